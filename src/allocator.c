@@ -0,0 +1,73 @@
+#include "allocator.h"
+#include <stdlib.h>
+
+
+// counters are shared by every thread that allocates, so they are bumped atomically
+static uint64_t allocationCount, freeCount, byteCount;
+
+static void CountAllocation(size_t size)
+{
+	__atomic_fetch_add(&allocationCount, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&byteCount, size, __ATOMIC_RELAXED);
+}
+
+static void CountFree(void)
+{
+	__atomic_fetch_add(&freeCount, 1, __ATOMIC_RELAXED);
+}
+
+void *AllocMemory(size_t size)
+{
+	void *memory = malloc(size);
+	if (memory)
+	{
+		CountAllocation(size);
+	}
+
+	return memory;
+}
+
+void *CallocMemory(size_t count, size_t size)
+{
+	void *memory = calloc(count, size);
+	if (memory)
+	{
+		CountAllocation(count * size);
+	}
+
+	return memory;
+}
+
+void *ReallocMemory(void *memory, size_t size)
+{
+	void *grown = realloc(memory, size);
+	if (grown)
+	{
+		if (memory)
+		{
+			CountFree();
+		}
+		CountAllocation(size);
+	}
+
+	return grown;
+}
+
+void FreeMemory(void *memory)
+{
+	if (memory)
+	{
+		CountFree();
+		free(memory);
+	}
+}
+
+MemoryStats GetMemoryStats(void)
+{
+	MemoryStats stats;
+	stats.allocations = __atomic_load_n(&allocationCount, __ATOMIC_RELAXED);
+	stats.frees = __atomic_load_n(&freeCount, __ATOMIC_RELAXED);
+	stats.bytes = __atomic_load_n(&byteCount, __ATOMIC_RELAXED);
+
+	return stats;
+}
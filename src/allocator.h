@@ -0,0 +1,30 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare MemoryStats struct.
+ */
+
+// running totals of the heap calls made by the core since the program started. a realloc of an
+// existing block counts as one allocation and one free
+typedef struct MemoryStats
+{
+	uint64_t allocations;	// calls that handed out a block
+	uint64_t frees;	// calls that gave a block back
+	uint64_t bytes;	// bytes requested over all allocations
+} MemoryStats;
+
+// the core allocates through these instead of malloc and friends, so tools can see how often
+// the engine touches the heap
+void *AllocMemory(size_t size);
+void *CallocMemory(size_t count, size_t size);
+void *ReallocMemory(void *memory, size_t size);
+void FreeMemory(void *memory);
+MemoryStats GetMemoryStats(void);
+
+
+#endif
@@ -0,0 +1,252 @@
+#include "asset.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#if ManySnakes_EMBED_ASSETS
+// generated at build time from the files listed in CMakeLists.txt
+extern const EmbeddedAsset EMBEDDED_ASSETS[];
+extern const int EMBEDDED_ASSET_COUNT;
+#endif
+
+static Asset *FindAsset(AssetCache *cache, AssetType type, const char *name, int size);
+static Asset *AddAsset(AssetCache *cache, AssetType type, const char *name, int size);
+static SDL_RWops *OpenAsset(const char *name);
+static void UnloadAsset(Asset *asset);
+
+AssetCache *CreateAssetCache(SDL_Renderer *renderer)
+{
+	// Create the struct.
+	AssetCache *cache = malloc(sizeof(AssetCache));
+	if (!cache)
+	{
+		SDL_SetError("Failed to create asset cache. (Failed to create AssetCache struct)");
+		return NULL;
+	}
+
+	cache->renderer = renderer;
+	cache->assets = NULL;
+	cache->assetCount = 0;
+	cache->assetCapacity = 0;
+
+	return cache;
+}
+
+SDL_Texture *AcquireTextureAsset(AssetCache *cache, const char *name)
+{
+	// Hand out the loaded texture if there is one.
+	Asset *asset = FindAsset(cache, ASSET_TEXTURE, name, 0);
+	if (asset)
+	{
+		++asset->refCount;
+		return asset->texture;
+	}
+
+	SDL_RWops *source = OpenAsset(name);
+	if (!source)
+	{
+		SDL_SetError("Failed to acquire texture asset %s. (Asset not found)", name);
+		return NULL;
+	}
+
+	// Load the texture, which closes the source.
+	SDL_Texture *texture = IMG_LoadTexture_RW(cache->renderer, source, 1);
+	if (!texture)
+	{
+		SDL_SetError("Failed to acquire texture asset %s. (Texture failed to load)", name);
+		return NULL;
+	}
+
+	asset = AddAsset(cache, ASSET_TEXTURE, name, 0);
+	if (!asset)
+	{
+		SDL_DestroyTexture(texture);
+		return NULL;
+	}
+
+	asset->texture = texture;
+
+	return texture;
+}
+
+TTF_Font *AcquireFontAsset(AssetCache *cache, const char *name, int size)
+{
+	// Hand out the opened font if there is one at this size.
+	Asset *asset = FindAsset(cache, ASSET_FONT, name, size);
+	if (asset)
+	{
+		++asset->refCount;
+		return asset->font;
+	}
+
+	SDL_RWops *source = OpenAsset(name);
+	if (!source)
+	{
+		SDL_SetError("Failed to acquire font asset %s. (Asset not found)", name);
+		return NULL;
+	}
+
+	// Open the font, which keeps reading from the source until it is closed.
+	TTF_Font *font = TTF_OpenFontRW(source, 1, size);
+	if (!font)
+	{
+		SDL_SetError("Failed to acquire font asset %s. (Font failed to open)", name);
+		return NULL;
+	}
+
+	asset = AddAsset(cache, ASSET_FONT, name, size);
+	if (!asset)
+	{
+		TTF_CloseFont(font);
+		return NULL;
+	}
+
+	asset->font = font;
+
+	return font;
+}
+
+void ReleaseTextureAsset(AssetCache *cache, SDL_Texture *texture)
+{
+	for (int i = 0; i < cache->assetCount; ++i)
+	{
+		if (cache->assets[i].texture == texture && cache->assets[i].refCount > 0)
+		{
+			--cache->assets[i].refCount;
+			return;
+		}
+	}
+}
+
+void ReleaseFontAsset(AssetCache *cache, TTF_Font *font)
+{
+	for (int i = 0; i < cache->assetCount; ++i)
+	{
+		if (cache->assets[i].font == font && cache->assets[i].refCount > 0)
+		{
+			--cache->assets[i].refCount;
+			return;
+		}
+	}
+}
+
+void PurgeAssetCache(AssetCache *cache)
+{
+	// Unload the assets nobody holds, keeping the rest packed at the front.
+	int kept = 0;
+	for (int i = 0; i < cache->assetCount; ++i)
+	{
+		if (cache->assets[i].refCount > 0)
+		{
+			cache->assets[kept++] = cache->assets[i];
+		}
+		else
+		{
+			UnloadAsset(&cache->assets[i]);
+		}
+	}
+
+	cache->assetCount = kept;
+}
+
+void DestroyAssetCache(AssetCache *cache)
+{
+	for (int i = 0; i < cache->assetCount; ++i)
+	{
+		UnloadAsset(&cache->assets[i]);
+	}
+
+	free(cache->assets);
+	free(cache);
+}
+
+static Asset *FindAsset(AssetCache *cache, AssetType type, const char *name, int size)
+{
+	for (int i = 0; i < cache->assetCount; ++i)
+	{
+		Asset *asset = &cache->assets[i];
+		if (asset->type == type && asset->size == size && strcmp(asset->name, name) == 0)
+		{
+			return asset;
+		}
+	}
+
+	return NULL;
+}
+
+static Asset *AddAsset(AssetCache *cache, AssetType type, const char *name, int size)
+{
+	// Grow the asset array when full.
+	if (cache->assetCount == cache->assetCapacity)
+	{
+		int capacity = cache->assetCapacity ? cache->assetCapacity * 2 : 8;
+		Asset *assets = realloc(cache->assets, capacity * sizeof(Asset));
+		if (!assets)
+		{
+			SDL_SetError("Failed to add asset %s. (Failed to grow Asset array)", name);
+			return NULL;
+		}
+
+		cache->assets = assets;
+		cache->assetCapacity = capacity;
+	}
+
+	// Keep a copy of the name, the caller's string may not outlive the cache.
+	char *nameCopy = malloc(strlen(name) + 1);
+	if (!nameCopy)
+	{
+		SDL_SetError("Failed to add asset %s. (Failed to copy name)", name);
+		return NULL;
+	}
+	strcpy(nameCopy, name);
+
+	Asset *asset = &cache->assets[cache->assetCount++];
+	asset->type = type;
+	asset->name = nameCopy;
+	asset->size = size;
+	asset->refCount = 1;
+	asset->texture = NULL;
+	asset->font = NULL;
+
+	return asset;
+}
+
+static SDL_RWops *OpenAsset(const char *name)
+{
+#if ManySnakes_EMBED_ASSETS
+	// Read from the copy in the binary when there is one.
+	for (int i = 0; i < EMBEDDED_ASSET_COUNT; ++i)
+	{
+		if (strcmp(EMBEDDED_ASSETS[i].name, name) == 0)
+		{
+			return SDL_RWFromConstMem(EMBEDDED_ASSETS[i].data, (int) EMBEDDED_ASSETS[i].size);
+		}
+	}
+#endif
+
+	// Otherwise, read from the source tree.
+	char path[256];
+	if (snprintf(path, sizeof(path), "%s/%s", ROOT_DIR, name) >= (int) sizeof(path))
+	{
+		return NULL;
+	}
+
+	return SDL_RWFromFile(path, "rb");
+}
+
+static void UnloadAsset(Asset *asset)
+{
+	if (asset->texture)
+	{
+		SDL_DestroyTexture(asset->texture);
+	}
+
+	if (asset->font)
+	{
+		TTF_CloseFont(asset->font);
+	}
+
+	free((char *) asset->name);
+}
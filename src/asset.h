@@ -0,0 +1,58 @@
+#ifndef ASSET_H
+#define ASSET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare EmbeddedAsset, Asset, AssetCache structs.
+ */
+
+// a file compiled into the binary, named by its path relative to the source tree. the table of
+// them is generated at build time when ManySnakes_EMBED_ASSETS is on
+typedef struct EmbeddedAsset
+{
+	const char *name;
+	const unsigned char *data;
+	size_t size;
+} EmbeddedAsset;
+
+typedef enum AssetType
+{
+	ASSET_TEXTURE,
+	ASSET_FONT
+} AssetType;
+
+typedef struct Asset
+{
+	AssetType type;
+	const char *name;	// path relative to the source tree, e.g. "images/Apple.png"
+	int size;	// point size of a font, unused for textures
+	int refCount;	// handles given out and not yet released
+	SDL_Texture *texture;
+	TTF_Font *font;
+} Asset;
+
+// loads every texture and font once and hands out counted handles to it. assets nobody holds
+// stay loaded until the cache is purged or destroyed, so a new round reuses them without
+// touching the filesystem
+typedef struct AssetCache
+{
+	SDL_Renderer *renderer;	// renderer the textures are created for
+	Asset *assets;
+	int assetCount, assetCapacity;
+} AssetCache;
+
+AssetCache *CreateAssetCache(SDL_Renderer *renderer);
+SDL_Texture *AcquireTextureAsset(AssetCache *cache, const char *name);
+TTF_Font *AcquireFontAsset(AssetCache *cache, const char *name, int size);
+void ReleaseTextureAsset(AssetCache *cache, SDL_Texture *texture);
+void ReleaseFontAsset(AssetCache *cache, TTF_Font *font);
+void PurgeAssetCache(AssetCache *cache);
+void DestroyAssetCache(AssetCache *cache);
+
+#endif
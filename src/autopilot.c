@@ -0,0 +1,444 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "autopilot.h"
+#include "allocator.h"
+#include <string.h>
+#include <time.h>
+
+#define AUTOPILOT_ROOM 4
+// cells a decision searches between looks at the clock
+#define AUTOPILOT_CLOCK_CELLS 256
+
+// directions in the order the searches try them
+static const SnakeDirection AUTOPILOT_DIRECTIONS[4] = {SNAKE_RIGHT, SNAKE_UP, SNAKE_LEFT, SNAKE_DOWN};
+
+static void BuildAutopilotCycle(Autopilot *autopilot);
+static uint32_t NextAutopilotStamp(Autopilot *autopilot);
+static bool RefillAutopilotBudget(Autopilot *autopilot, int *budget);
+static int NeighbourOfAutopilot(const Autopilot *autopilot, int cell, SnakeDirection direction);
+static SnakeDirection DirectionOfAutopilot(const Autopilot *autopilot, int from, int to);
+static SnakeDirection OppositeOfAutopilot(SnakeDirection direction);
+static int SearchAutopilot(Autopilot *autopilot, const Board *board, int start, int goal, int tail, SnakeDirection forbidden, uint32_t blockStamp, int *budget);
+static bool IsSafeAfterPathAutopilot(Autopilot *autopilot, Snake *snake, int pathLength, int *budget);
+static bool IsAlignedAutopilot(Autopilot *autopilot, Snake *snake, int *budget);
+static SnakeDirection ShortcutAutopilot(Autopilot *autopilot, const Board *board, int head, int tail, int length, int goal, SnakeDirection forbidden, int *budget);
+
+Autopilot *CreateAutopilot(int width, int height, AutopilotStrategy strategy, int budgetMicros)
+{
+	Autopilot *autopilot = CallocMemory(1, sizeof(Autopilot));
+	if (!autopilot)
+	{
+		return NULL;
+	}
+
+	autopilot->strategy = strategy;
+	autopilot->width = width;
+	autopilot->height = height;
+	autopilot->budgetMicros = budgetMicros;
+
+	// every buffer a decision can need, allocated once for the board
+	size_t cellCount = (size_t) width * height;
+	autopilot->queue = AllocMemory(cellCount * sizeof(int));
+	autopilot->parent = AllocMemory(cellCount * sizeof(int));
+	autopilot->distance = AllocMemory(cellCount * sizeof(int));
+	autopilot->path = AllocMemory(cellCount * sizeof(int));
+	autopilot->seen = CallocMemory(cellCount, sizeof(uint32_t));
+	autopilot->blocked = CallocMemory(cellCount, sizeof(uint32_t));
+
+	// a board that wraps around has a Hamiltonian cycle as long as it is at least two cells each way,
+	// and a snake can follow it forever
+	bool hasCycle = width >= 2 && height >= 2;
+	if (hasCycle)
+	{
+		autopilot->cycleOrder = AllocMemory(cellCount * sizeof(int));
+		autopilot->cycleCells = AllocMemory(cellCount * sizeof(int));
+	}
+
+	if (!autopilot->queue || !autopilot->parent || !autopilot->distance || !autopilot->path || !autopilot->seen || !autopilot->blocked
+			|| (hasCycle && (!autopilot->cycleOrder || !autopilot->cycleCells)))
+	{
+		DestroyAutopilot(autopilot);
+		return NULL;
+	}
+
+	if (hasCycle)
+	{
+		BuildAutopilotCycle(autopilot);
+	}
+
+	return autopilot;
+}
+
+SnakeDirection SteerAutopilot(Autopilot *autopilot, Snake *snake, Board *board, const Food *food)
+{
+	int width = autopilot->width;
+	SnakeCell *headCell = SnakeHead(snake);
+	SnakeCell *tailCell = SnakeTail(snake);
+	int head = headCell->yPos * width + headCell->xPos;
+	int tail = tailCell->yPos * width + tailCell->xPos;
+	SnakeDirection reverse = OppositeOfAutopilot(snake->currentDirection);
+
+	// the budget counts down the cells left until the clock is looked at again
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	autopilot->deadline = (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec + (uint64_t) autopilot->budgetMicros * 1000;
+	int budget = AUTOPILOT_CLOCK_CELLS;
+	SnakeDirection direction = 0;
+	bool hasFood = food->xPos >= 0 && food->yPos >= 0;
+	int goal = hasFood ? food->yPos * width + food->xPos : -1;
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Cut across the cycle towards the food, where the cut cannot trap the snake.
+	 */
+
+	if (autopilot->strategy == AUTOPILOT_SAFE && autopilot->cycleOrder && IsAlignedAutopilot(autopilot, snake, &budget))
+	{
+		direction = ShortcutAutopilot(autopilot, board, head, tail, snake->length, goal, reverse, &budget);
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Take the shortest path to the food, if it is safe enough for the strategy.
+	 */
+
+	if (!direction && (autopilot->strategy == AUTOPILOT_GREEDY || !autopilot->cycleOrder))
+	{
+		int pathLength = hasFood ? SearchAutopilot(autopilot, board, head, goal, tail, reverse, 0, &budget) : 0;
+		int firstStep = pathLength > 0 ? autopilot->path[pathLength - 1] : -1;
+		if (pathLength > 0 && (autopilot->strategy == AUTOPILOT_GREEDY || IsSafeAfterPathAutopilot(autopilot, snake, pathLength, &budget)))
+		{
+			direction = DirectionOfAutopilot(autopilot, head, firstStep);
+		}
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Otherwise follow the cycle, or chase the tail, which keeps the way out open.
+	 */
+
+	if (!direction && autopilot->strategy != AUTOPILOT_GREEDY && autopilot->cycleOrder)
+	{
+		int cellCount = width * autopilot->height;
+		int next = autopilot->cycleCells[(autopilot->cycleOrder[head] + 1) % cellCount];
+		SnakeDirection cycleDirection = DirectionOfAutopilot(autopilot, head, next);
+		if (cycleDirection != reverse && (board->counts[next] == 0 || next == tail))
+		{
+			direction = cycleDirection;
+		}
+	}
+
+	if (!direction && autopilot->strategy != AUTOPILOT_GREEDY && snake->length > 2)
+	{
+		int pathLength = SearchAutopilot(autopilot, board, head, tail, tail, reverse, 0, &budget);
+		if (pathLength > 0)
+		{
+			direction = DirectionOfAutopilot(autopilot, head, autopilot->path[pathLength - 1]);
+		}
+	}
+
+	// when nothing else worked out, any free neighbour beats running into something
+	for (int i = 0; i < 4 && !direction; ++i)
+	{
+		int next = NeighbourOfAutopilot(autopilot, head, AUTOPILOT_DIRECTIONS[i]);
+		if (AUTOPILOT_DIRECTIONS[i] != reverse && (board->counts[next] == 0 || next == tail))
+		{
+			direction = AUTOPILOT_DIRECTIONS[i];
+		}
+	}
+
+	if (!direction)
+	{
+		direction = snake->currentDirection;
+	}
+
+	SteerSnake(snake, direction);
+
+	return direction;
+}
+
+void DestroyAutopilot(Autopilot *autopilot)
+{
+	FreeMemory(autopilot->queue);
+	FreeMemory(autopilot->parent);
+	FreeMemory(autopilot->distance);
+	FreeMemory(autopilot->path);
+	FreeMemory(autopilot->seen);
+	FreeMemory(autopilot->blocked);
+	FreeMemory(autopilot->cycleOrder);
+	FreeMemory(autopilot->cycleCells);
+	FreeMemory(autopilot);
+}
+
+static void BuildAutopilotCycle(Autopilot *autopilot)
+{
+	// lay the cycle out on rows x columns with an even number of rows: along the first row, then
+	// back and forth over every column but the first, then up the first column to the start.
+	// a board with an odd height but an even width gets the same cycle turned on its side. a board
+	// with both sides odd has no such cycle, so the cycle is laid over every row but the last, and
+	// its first step goes up across the edge, back along the last row and down across the edge again
+	bool isOdd = autopilot->width % 2 != 0 && autopilot->height % 2 != 0;
+	bool isTurned = !isOdd && autopilot->height % 2 != 0;
+	int rows = isTurned ? autopilot->width : isOdd ? autopilot->height - 1 : autopilot->height;
+	int columns = isTurned ? autopilot->height : autopilot->width;
+	int order = 0;
+
+	for (int row = 0; row < rows; ++row)
+	{
+		for (int i = 0; i < columns - (row > 0); ++i)
+		{
+			// the first row covers every column, the others skip the first column
+			int column = row == 0 ? i : row % 2 == 1 ? columns - 1 - i : i + 1;
+			int cell = isTurned ? column * autopilot->width + row : row * autopilot->width + column;
+			autopilot->cycleOrder[cell] = order;
+			autopilot->cycleCells[order++] = cell;
+
+			// the last row, from the first column leftwards around to the second
+			int detourCount = isOdd && order == 1 ? columns : 0;
+			for (int j = 0; j < detourCount; ++j)
+			{
+				int detour = (autopilot->height - 1) * autopilot->width + (columns - j) % columns;
+				autopilot->cycleOrder[detour] = order;
+				autopilot->cycleCells[order++] = detour;
+			}
+		}
+	}
+
+	for (int row = rows - 1; row > 0; --row)
+	{
+		int cell = isTurned ? row : row * autopilot->width;
+		autopilot->cycleOrder[cell] = order;
+		autopilot->cycleCells[order++] = cell;
+	}
+}
+
+static uint32_t NextAutopilotStamp(Autopilot *autopilot)
+{
+	// when the stamps run out, clear the stamp arrays once and start over
+	if (++autopilot->stamp == 0)
+	{
+		size_t cellCount = (size_t) autopilot->width * autopilot->height;
+		memset(autopilot->seen, 0, cellCount * sizeof(uint32_t));
+		memset(autopilot->blocked, 0, cellCount * sizeof(uint32_t));
+		autopilot->stamp = 1;
+	}
+
+	return autopilot->stamp;
+}
+
+static bool RefillAutopilotBudget(Autopilot *autopilot, int *budget)
+{
+	// another round of cells if the decision still has time, otherwise it has to wrap up
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if ((uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec >= autopilot->deadline)
+	{
+		return false;
+	}
+
+	*budget = AUTOPILOT_CLOCK_CELLS;
+
+	return true;
+}
+
+static int NeighbourOfAutopilot(const Autopilot *autopilot, int cell, SnakeDirection direction)
+{
+	// the board wraps around at its edges, like StepSnake
+	int x = cell % autopilot->width;
+	int y = cell / autopilot->width;
+	switch (direction)
+	{
+		case SNAKE_RIGHT: x = (x + 1) % autopilot->width; break;
+		case SNAKE_LEFT: x = (x + autopilot->width - 1) % autopilot->width; break;
+		case SNAKE_DOWN: y = (y + 1) % autopilot->height; break;
+		case SNAKE_UP: y = (y + autopilot->height - 1) % autopilot->height; break;
+	}
+
+	return y * autopilot->width + x;
+}
+
+static SnakeDirection DirectionOfAutopilot(const Autopilot *autopilot, int from, int to)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		if (NeighbourOfAutopilot(autopilot, from, AUTOPILOT_DIRECTIONS[i]) == to)
+		{
+			return AUTOPILOT_DIRECTIONS[i];
+		}
+	}
+
+	return 0;
+}
+
+static SnakeDirection OppositeOfAutopilot(SnakeDirection direction)
+{
+	switch (direction)
+	{
+		case SNAKE_RIGHT: return SNAKE_LEFT;
+		case SNAKE_UP: return SNAKE_DOWN;
+		case SNAKE_LEFT: return SNAKE_RIGHT;
+		case SNAKE_DOWN: return SNAKE_UP;
+	}
+
+	return 0;
+}
+
+static int SearchAutopilot(Autopilot *autopilot, const Board *board, int start, int goal, int tail, SnakeDirection forbidden, uint32_t blockStamp, int *budget)
+{
+	// breadth first search from start to goal, spending one unit of budget per cell taken off the
+	// queue and giving up when the decision's time is out. without a block stamp, a cell is open if the board has nothing on it or it is the tail,
+	// which moves away before the head arrives. with one, a cell is open unless the look-ahead
+	// body took it. returns the path length, 0 if the goal cannot be reached, -1 if out of budget
+	uint32_t stamp = NextAutopilotStamp(autopilot);
+	int *queue = autopilot->queue;
+	int queueHead = 0, queueTail = 0;
+
+	queue[queueTail++] = start;
+	autopilot->seen[start] = stamp;
+	autopilot->distance[start] = 0;
+
+	while (queueHead < queueTail)
+	{
+		if (--*budget < 0 && !RefillAutopilotBudget(autopilot, budget))
+		{
+			return -1;
+		}
+
+		int cell = queue[queueHead++];
+		for (int i = 0; i < 4; ++i)
+		{
+			if (cell == start && AUTOPILOT_DIRECTIONS[i] == forbidden)
+			{
+				continue;
+			}
+
+			int next = NeighbourOfAutopilot(autopilot, cell, AUTOPILOT_DIRECTIONS[i]);
+			bool isOpen = blockStamp ? autopilot->blocked[next] != blockStamp : board->counts[next] == 0 || next == tail;
+			if (autopilot->seen[next] == stamp || !isOpen)
+			{
+				continue;
+			}
+
+			autopilot->seen[next] = stamp;
+			autopilot->parent[next] = cell;
+			autopilot->distance[next] = autopilot->distance[cell] + 1;
+
+			if (next == goal)
+			{
+				// walk back to the start, leaving the path from the goal to the first step
+				int length = 0;
+				for (int step = goal; step != start; step = autopilot->parent[step])
+				{
+					autopilot->path[length++] = step;
+				}
+
+				return length;
+			}
+
+			queue[queueTail++] = next;
+		}
+	}
+
+	return 0;
+}
+
+static bool IsSafeAfterPathAutopilot(Autopilot *autopilot, Snake *snake, int pathLength, int *budget)
+{
+	// lay out the body the snake would have after following the path and eating: the path,
+	// then as much of the current body as still fits, one cell longer than now
+	int length = snake->length + 1;
+	*budget -= length;
+	if (*budget < 0 && !RefillAutopilotBudget(autopilot, budget))
+	{
+		return false;
+	}
+
+	uint32_t blockStamp = NextAutopilotStamp(autopilot);
+	int newHead = autopilot->path[0];
+	int newTail = newHead;
+	for (int i = 0; i < length; ++i)
+	{
+		SnakeCell *cell = i < pathLength ? NULL : SnakeCellAt(snake, i - pathLength);
+		newTail = cell ? cell->yPos * autopilot->width + cell->xPos : autopilot->path[i];
+		autopilot->blocked[newTail] = blockStamp;
+	}
+
+	// the snake is safe if its head can still find its tail, which keeps moving out of the way
+	autopilot->blocked[newTail] = 0;
+
+	return SearchAutopilot(autopilot, NULL, newHead, newTail, -1, 0, blockStamp, budget) > 0;
+}
+
+static bool IsAlignedAutopilot(Autopilot *autopilot, Snake *snake, int *budget)
+{
+	// the body is aligned when it lies on the stretch of the cycle from the tail to the head.
+	// an aligned snake has nothing but free cells ahead of its head until the cycle comes back
+	// around to its tail, which is what makes cutting across the cycle safe
+	*budget -= snake->length;
+	if (*budget < 0 && !RefillAutopilotBudget(autopilot, budget))
+	{
+		return false;
+	}
+
+	int cellCount = autopilot->width * autopilot->height;
+	int *order = autopilot->cycleOrder;
+	SnakeCell *tailCell = SnakeTail(snake);
+	int tailOrder = order[tailCell->yPos * autopilot->width + tailCell->xPos];
+	SnakeCell *headCell = SnakeHead(snake);
+	int span = (order[headCell->yPos * autopilot->width + headCell->xPos] - tailOrder + cellCount) % cellCount;
+
+	for (int i = 1; i < snake->length - 1; ++i)
+	{
+		SnakeCell *cell = SnakeCellAt(snake, i);
+		if ((order[cell->yPos * autopilot->width + cell->xPos] - tailOrder + cellCount) % cellCount > span)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static SnakeDirection ShortcutAutopilot(Autopilot *autopilot, const Board *board, int head, int tail, int length, int goal, SnakeDirection forbidden, int *budget)
+{
+	// an aligned snake may jump ahead on the cycle to any neighbour short of its tail and keep
+	// the whole body on the stretch from the new tail to the new head, so it stays aligned and can
+	// never be trapped. the jump leaves room to grow, never skips past the food, and stops once
+	// the snake fills half the board, from where it just follows the cycle
+	int cellCount = autopilot->width * autopilot->height;
+	int *order = autopilot->cycleOrder;
+	int headOrder = order[head];
+	int tailGap = length > 1 ? (order[tail] - headOrder + cellCount) % cellCount : cellCount;
+	int foodGap = goal >= 0 ? (order[goal] - headOrder + cellCount) % cellCount : 1;
+	int reach = length * 2 > cellCount ? 1 : tailGap - AUTOPILOT_ROOM;
+	reach = reach < foodGap ? reach : foodGap;
+
+	// rank the neighbours by how far they are from the food over the free cells. cells the
+	// search did not reach before the budget ran out rank after, by how far the cycle takes them
+	uint32_t stamp = 0;
+	if (goal >= 0 && reach > 1)
+	{
+		SearchAutopilot(autopilot, board, goal, -1, tail, 0, 0, budget);
+		stamp = autopilot->stamp;
+	}
+
+	SnakeDirection direction = 0;
+	int bestScore = 0, bestGap = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		int next = NeighbourOfAutopilot(autopilot, head, AUTOPILOT_DIRECTIONS[i]);
+		int gap = (order[next] - headOrder + cellCount) % cellCount;
+		if (AUTOPILOT_DIRECTIONS[i] == forbidden || gap < 1 || (gap > reach && gap != 1)
+				|| (board->counts[next] != 0 && next != tail))
+		{
+			continue;
+		}
+
+		int score = stamp && autopilot->seen[next] == stamp ? autopilot->distance[next] : cellCount + foodGap - gap;
+		if (!direction || score < bestScore || (score == bestScore && gap > bestGap))
+		{
+			direction = AUTOPILOT_DIRECTIONS[i];
+			bestScore = score;
+			bestGap = gap;
+		}
+	}
+
+	return direction;
+}
@@ -0,0 +1,60 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "snake.h"
+
+
+// microseconds a decision may take and still leave most of a 60 Hz frame for everything else
+#define AUTOPILOT_FRAME_MICROS 2000
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare AutopilotStrategy enum.
+ */
+
+// ways the autopilot can choose a move
+typedef enum
+{
+	AUTOPILOT_GREEDY,	// shortest path to the food, without looking further ahead
+	AUTOPILOT_SAFE,	// on boards with a Hamiltonian cycle, which is every board at least 2x2 since
+			// the edges wrap, cut across the cycle towards the food wherever that cannot
+			// trap the snake. on a board one cell thin, take the shortest path to the food
+			// if the tail can still be reached after eating, otherwise chase the tail
+	AUTOPILOT_CYCLE	// always follow the Hamiltonian cycle, slow but never stuck
+} AutopilotStrategy;
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare Autopilot struct.
+ */
+
+// drives a snake by setting its pending direction once per tick. every search buffer is sized
+// for the board up front, and a decision stops searching once it has taken budgetMicros, going by
+// a clock read every few hundred cells, so it ends in about that time no matter how large the
+// board or the snake. when the time runs out before an answer, the autopilot falls back to the
+// cycle or to any free neighbour, so how far it looks ahead depends on how fast the machine is
+typedef struct Autopilot
+{
+	AutopilotStrategy strategy;
+	int width, height;	// size of the board the buffers are for
+	int budgetMicros;	// longest a decision may search, in microseconds
+	uint64_t deadline;	// monotonic clock in nanoseconds the current decision has to end by
+	int *queue;	// breadth first search frontier
+	int *parent;	// cell each searched cell was reached from
+	int *distance;	// steps from the start of the search to each searched cell
+	int *path;	// cells of the last path found, from the goal back to the start
+	uint32_t *seen;	// search stamp of each cell, equal to stamp when searched this round
+	uint32_t *blocked;	// stamp of each cell taken by the look-ahead body
+	uint32_t stamp;	// bumped for every search so the stamp arrays never need clearing
+	int *cycleOrder;	// position of each cell on the Hamiltonian cycle, NULL if the board has none
+	int *cycleCells;	// cell at each position on the cycle
+} Autopilot;
+
+Autopilot *CreateAutopilot(int width, int height, AutopilotStrategy strategy, int budgetMicros);
+SnakeDirection SteerAutopilot(Autopilot *autopilot, Snake *snake, Board *board, const Food *food);
+void DestroyAutopilot(Autopilot *autopilot);
+
+#endif
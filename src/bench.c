@@ -0,0 +1,666 @@
+/* ManySnakes microbenchmarks
+ * Times the snake engine calls across snake lengths and board sizes, reports ns/op, throughput and
+ * heap allocations per op, and optionally compares against a saved baseline.
+ *
+ * usage: manysnakes_bench [--quick] [--json file] [--baseline file] [--threshold percent]
+ *
+ * exits with 1 when a benchmark is slower than its baseline by more than the threshold.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "allocator.h"
+#include "board.h"
+#include "collide.h"
+#include "snake.h"
+#if ManySnakes_BENCH_RENDER
+#include "render.h"
+#endif
+
+// snake lengths every benchmark runs at, each on a board big enough to hold the snake twice over
+static const int BENCH_LENGTHS[] = {10, 100, 1000, 10000, 100000, 1000000};
+// board sides the board-bound benchmarks also run at, with a short snake
+static const int BENCH_SIDES[] = {40, 256, 1024, 2048};
+// most benchmark results a run can produce
+#define BENCH_MAX_RESULTS 128
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare BenchRun, BenchResult, Benchmark structs.
+ */
+
+// what one timed run of a benchmark measured. setup and teardown are not included
+typedef struct BenchRun
+{
+	long long ops;
+	double seconds;
+	uint64_t allocations;
+} BenchRun;
+
+typedef struct BenchResult
+{
+	char name[32];
+	int length;	// snake length the benchmark ran with
+	int side;	// width and height of the board
+	long long ops;
+	double nsPerOp;
+	double opsPerSecond;
+	double allocationsPerOp;
+	double baselineNsPerOp;	// 0 when the baseline has no matching result
+} BenchResult;
+
+// runs at least the given number of ops of one engine call on a snake of length on a side x side board
+typedef BenchRun (*BenchFunction)(int length, int side, long long ops);
+
+typedef struct Benchmark
+{
+	const char *name;
+	BenchFunction function;
+	bool isBoardBound;	// also run across BENCH_SIDES
+} Benchmark;
+
+double GetSeconds(void);
+int BoardSideFor(int length);
+void ColumnBoardFor(int length, int side, int *width, int *height);
+void SerpentineCell(int i, int side, int *x, int *y);
+BenchRun BenchCreateSnake(int length, int side, long long ops);
+BenchRun BenchStepSnake(int length, int side, long long ops);
+BenchRun BenchGrowSnake(int length, int side, long long ops);
+BenchRun BenchCheckCollisionSnake(int length, int side, long long ops);
+BenchRun BenchRandPosFood(int length, int side, long long ops);
+BenchRun BenchCollideHeads(CollideKernel kernel, int length, int side, long long ops);
+BenchRun BenchCollideHeadsScalar(int length, int side, long long ops);
+BenchRun BenchCollideHeadsBest(int length, int side, long long ops);
+#if ManySnakes_BENCH_RENDER
+BenchRun BenchBatchSnake(int length, int side, long long ops);
+#endif
+bool RunBenchmark(const Benchmark *benchmark, int length, int side, double minSeconds, BenchResult *result);
+int ReadBaseline(const char *path, BenchResult *baseline, int maxCount);
+bool WriteResults(const char *path, const BenchResult *results, int count);
+
+static const Benchmark BENCHMARKS[] =
+{
+	{"CreateSnake", BenchCreateSnake, false},
+	{"StepSnake", BenchStepSnake, true},
+	{"GrowSnake", BenchGrowSnake, false},
+	{"CheckCollisionSnake", BenchCheckCollisionSnake, false},
+	{"RandPosFood", BenchRandPosFood, true},
+	{"CollideHeadsScalar", BenchCollideHeadsScalar, false},
+	{"CollideHeads", BenchCollideHeadsBest, false},
+#if ManySnakes_BENCH_RENDER
+	{"BatchSnake", BenchBatchSnake, false},
+#endif
+};
+
+// keeps the compiler from dropping calls whose results are otherwise unused
+static volatile int benchSink;
+
+int main(int argc, char **argv)
+{
+	// read the options
+	double minSeconds = 0.25;
+	double threshold = 10.0;
+	const char *jsonPath = NULL;
+	const char *baselinePath = NULL;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+		{
+			minSeconds = 0.02;
+		}
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+		{
+			baselinePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+		{
+			threshold = atof(argv[++i]);
+		}
+		else
+		{
+			fprintf(stderr, "usage: %s [--quick] [--json file] [--baseline file] [--threshold percent]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	BenchResult baseline[BENCH_MAX_RESULTS];
+	int baselineCount = 0;
+	if (baselinePath)
+	{
+		baselineCount = ReadBaseline(baselinePath, baseline, BENCH_MAX_RESULTS);
+		if (baselineCount < 0)
+		{
+			fprintf(stderr, "failed to read baseline %s\n", baselinePath);
+			return 2;
+		}
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Run every benchmark at every length, then the board-bound ones at every board size.
+	 */
+
+	static BenchResult results[BENCH_MAX_RESULTS];
+	int resultCount = 0;
+	int lengthCount = sizeof(BENCH_LENGTHS) / sizeof(BENCH_LENGTHS[0]);
+	int sideCount = sizeof(BENCH_SIDES) / sizeof(BENCH_SIDES[0]);
+	int benchmarkCount = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+
+	printf("collision kernel: %s\n", NameCollideKernel(GetCollideKernel()));
+	printf("%-20s %8s %6s %12s %14s %10s %10s\n", "benchmark", "length", "board", "ns/op", "ops/s", "allocs/op", "baseline");
+	for (int b = 0; b < benchmarkCount; ++b)
+	{
+		for (int i = 0; i < lengthCount + sideCount; ++i)
+		{
+			bool isSideSweep = i >= lengthCount;
+			if (isSideSweep && !BENCHMARKS[b].isBoardBound)
+			{
+				break;
+			}
+
+			int length = isSideSweep ? BENCH_LENGTHS[0] : BENCH_LENGTHS[i];
+			int side = isSideSweep ? BENCH_SIDES[i - lengthCount] : BoardSideFor(length);
+
+			BenchResult *result = &results[resultCount];
+			if (resultCount == BENCH_MAX_RESULTS || !RunBenchmark(&BENCHMARKS[b], length, side, minSeconds, result))
+			{
+				fprintf(stderr, "%s failed at length %d on a %dx%d board\n", BENCHMARKS[b].name, length, side, side);
+				return 2;
+			}
+			++resultCount;
+
+			// look up the same benchmark in the baseline
+			result->baselineNsPerOp = 0;
+			for (int j = 0; j < baselineCount; ++j)
+			{
+				if (strcmp(baseline[j].name, result->name) == 0 && baseline[j].length == length && baseline[j].side == side)
+				{
+					result->baselineNsPerOp = baseline[j].nsPerOp;
+				}
+			}
+
+			printf("%-20s %8d %6d %12.2f %14.0f %10.3f", result->name, length, side, result->nsPerOp, result->opsPerSecond, result->allocationsPerOp);
+			if (result->baselineNsPerOp > 0)
+			{
+				printf(" %+9.1f%%", (result->nsPerOp / result->baselineNsPerOp - 1) * 100);
+			}
+			printf("\n");
+		}
+	}
+
+	if (jsonPath && !WriteResults(jsonPath, results, resultCount))
+	{
+		fprintf(stderr, "failed to write %s\n", jsonPath);
+		return 2;
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Fail when a benchmark got slower than the baseline by more than the threshold.
+	 */
+
+	int regressions = 0;
+	for (int i = 0; i < resultCount; ++i)
+	{
+		BenchResult *result = &results[i];
+		if (result->baselineNsPerOp > 0 && result->nsPerOp > result->baselineNsPerOp * (1 + threshold / 100))
+		{
+			fprintf(stderr, "regression: %s at length %d on a %dx%d board took %.2f ns/op, baseline %.2f ns/op\n",
+					result->name, result->length, result->side, result->side, result->nsPerOp, result->baselineNsPerOp);
+			++regressions;
+		}
+	}
+
+	if (baselinePath)
+	{
+		printf("%d of %d benchmarks slower than baseline by more than %.1f%%\n", regressions, resultCount, threshold);
+	}
+
+	return regressions > 0 ? 1 : 0;
+}
+
+double GetSeconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int BoardSideFor(int length)
+{
+	// the smallest square board with room for the snake twice over, and no smaller than Play's
+	int side = 40;
+	while ((long long) side * side < 2LL * length)
+	{
+		side *= 2;
+	}
+
+	return side;
+}
+
+void ColumnBoardFor(int length, int side, int *width, int *height)
+{
+	// CreateSnake lays a snake down one column, wrapping at the bottom edge. a column shorter than
+	// the snake would wrap it onto itself and stack its cells, so the board is made at least one
+	// cell taller than the snake and narrower to match, keeping about side x side cells
+	*height = length < side ? side : length + 1;
+	*width = (int) ((long long) side * side / *height);
+	*width = *width < 1 ? 1 : *width;
+}
+
+void SerpentineCell(int i, int side, int *x, int *y)
+{
+	// walk the board row by row, turning around at the end of each row, so consecutive
+	// cells are always neighbours
+	int row = i / side % side;
+	int column = i % side;
+	*x = row % 2 == 0 ? column : side - 1 - column;
+	*y = row;
+}
+
+bool RunBenchmark(const Benchmark *benchmark, int length, int side, double minSeconds, BenchResult *result)
+{
+	// double the op count until one run takes long enough to time reliably
+	long long ops = 1;
+	BenchRun run;
+	do
+	{
+		run = benchmark->function(length, side, ops);
+		if (run.ops == 0)
+		{
+			return false;
+		}
+
+		ops = run.ops * 2;
+	}
+	while (run.seconds < minSeconds);
+
+	strncpy(result->name, benchmark->name, sizeof(result->name) - 1);
+	result->name[sizeof(result->name) - 1] = '\0';
+	result->length = length;
+	result->side = side;
+	result->ops = run.ops;
+	result->nsPerOp = run.seconds * 1e9 / run.ops;
+	result->opsPerSecond = run.ops / run.seconds;
+	result->allocationsPerOp = (double) run.allocations / run.ops;
+
+	return true;
+}
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Benchmarks. Each one sets up its own board and snake, then times only the calls it is named for.
+ */
+
+BenchRun BenchCreateSnake(int length, int side, long long ops)
+{
+	BenchRun run = {0, 0, 0};
+	int width, height;
+	ColumnBoardFor(length, side, &width, &height);
+	Board *board = CreateBoard(width, height);
+	if (!board)
+	{
+		return run;
+	}
+
+	// create snakes in rounds of up to 64, or fewer long ones so a round stays within a few
+	// million cells, and destroy them between rounds without the clock running
+	Snake *snakes[64];
+	int roundSize = (1 << 22) / length;
+	roundSize = roundSize < 1 ? 1 : roundSize > 64 ? 64 : roundSize;
+	SnakeColor color = {0x00, 0x00, 0xA0, 0xFF};
+	while (run.ops < ops)
+	{
+		int count = ops - run.ops < roundSize ? (int) (ops - run.ops) : roundSize;
+
+		uint64_t allocations = GetMemoryStats().allocations;
+		double start = GetSeconds();
+		for (int i = 0; i < count; ++i)
+		{
+			snakes[i] = CreateSnake(board, width / 2, height / 2, 1, 1, 0, length, SNAKE_UP, &color);
+		}
+		run.seconds += GetSeconds() - start;
+		run.allocations += GetMemoryStats().allocations - allocations;
+
+		for (int i = 0; i < count; ++i)
+		{
+			if (!snakes[i])
+			{
+				run.ops = 0;
+				DestroyBoard(board);
+				return run;
+			}
+			DestroySnake(snakes[i]);
+		}
+		ClearBoard(board);
+		run.ops += count;
+	}
+
+	DestroyBoard(board);
+
+	return run;
+}
+
+BenchRun BenchStepSnake(int length, int side, long long ops)
+{
+	BenchRun run = {0, 0, 0};
+	int width, height;
+	ColumnBoardFor(length, side, &width, &height);
+	Board *board = CreateBoard(width, height);
+	SnakeColor color = {0x00, 0x00, 0xA0, 0xFF};
+	Snake *snake = board ? CreateSnake(board, width / 2, height / 2, 1, 1, 0, length, SNAKE_UP, &color) : NULL;
+	if (!snake)
+	{
+		if (board)
+		{
+			DestroyBoard(board);
+		}
+		return run;
+	}
+
+	// the snake keeps moving up its own column, wrapping at the edge of the board. the column is taller
+	// than the snake, so the head never runs into the body
+	uint64_t allocations = GetMemoryStats().allocations;
+	double start = GetSeconds();
+	for (long long i = 0; i < ops; ++i)
+	{
+		StepSnake(snake, board);
+	}
+	run.seconds = GetSeconds() - start;
+	run.allocations = GetMemoryStats().allocations - allocations;
+	run.ops = ops;
+
+	DestroySnake(snake);
+	DestroyBoard(board);
+
+	return run;
+}
+
+BenchRun BenchGrowSnake(int length, int side, long long ops)
+{
+	BenchRun run = {0, 0, 0};
+	Board *board = CreateBoard(side, side);
+	if (!board)
+	{
+		return run;
+	}
+
+	// grow snakes from one cell to the full length along a serpentine path, so every op
+	// includes its share of the ring buffer doublings
+	SnakeColor color = {0x00, 0x00, 0xA0, 0xFF};
+	while (run.ops < ops)
+	{
+		Snake *snake = CreateSnake(board, 0, 0, 1, 1, 0, 1, SNAKE_LEFT, &color);
+		if (!snake)
+		{
+			run.ops = 0;
+			break;
+		}
+
+		bool isGrown = true;
+		uint64_t allocations = GetMemoryStats().allocations;
+		double start = GetSeconds();
+		for (int i = 1; i < length && isGrown; ++i)
+		{
+			int x, y;
+			SerpentineCell(i, side, &x, &y);
+			isGrown = GrowSnake(snake, board, x, y);
+		}
+		run.seconds += GetSeconds() - start;
+		run.allocations += GetMemoryStats().allocations - allocations;
+		run.ops += length > 1 ? length - 1 : 1;
+
+		DestroySnake(snake);
+		ClearBoard(board);
+		if (!isGrown)
+		{
+			run.ops = 0;
+			break;
+		}
+	}
+
+	DestroyBoard(board);
+
+	return run;
+}
+
+BenchRun BenchCheckCollisionSnake(int length, int side, long long ops)
+{
+	BenchRun run = {0, 0, 0};
+	int width, height;
+	ColumnBoardFor(length, side, &width, &height);
+	Board *board = CreateBoard(width, height);
+	SnakeColor color = {0x00, 0x00, 0xA0, 0xFF};
+	Snake *snake = board ? CreateSnake(board, width / 2, height / 2, 1, 1, 0, length, SNAKE_UP, &color) : NULL;
+	if (!snake)
+	{
+		if (board)
+		{
+			DestroyBoard(board);
+		}
+		return run;
+	}
+
+	uint64_t allocations = GetMemoryStats().allocations;
+	double start = GetSeconds();
+	int collisions = 0;
+	for (long long i = 0; i < ops; ++i)
+	{
+		collisions += CheckCollisionSnake(snake, board);
+	}
+	run.seconds = GetSeconds() - start;
+	run.allocations = GetMemoryStats().allocations - allocations;
+	run.ops = ops;
+	benchSink = collisions;
+
+	DestroySnake(snake);
+	DestroyBoard(board);
+
+	return run;
+}
+
+BenchRun BenchRandPosFood(int length, int side, long long ops)
+{
+	BenchRun run = {0, 0, 0};
+	int width, height;
+	ColumnBoardFor(length, side, &width, &height);
+	Board *board = CreateBoard(width, height);
+	SnakeColor color = {0x00, 0x00, 0xA0, 0xFF};
+	Snake *snake = board ? CreateSnake(board, width / 2, height / 2, 1, 1, 0, length, SNAKE_UP, &color) : NULL;
+	if (!snake)
+	{
+		if (board)
+		{
+			DestroyBoard(board);
+		}
+		return run;
+	}
+
+	// the same seed every run, so runs pick the same cells
+	Random random;
+	SeedRandom(&random, 1);
+	Food food = {FOOD_APPLE, 0, 0};
+	uint64_t allocations = GetMemoryStats().allocations;
+	double start = GetSeconds();
+	for (long long i = 0; i < ops; ++i)
+	{
+		RandPosFood(&food, board, &random);
+	}
+	run.seconds = GetSeconds() - start;
+	run.allocations = GetMemoryStats().allocations - allocations;
+	run.ops = ops;
+	benchSink = food.xPos;
+
+	DestroySnake(snake);
+	DestroyBoard(board);
+
+	return run;
+}
+
+BenchRun BenchCollideHeads(CollideKernel kernel, int length, int side, long long ops)
+{
+	// length is the number of heads here, checked in one batch per op like a crowded world step
+	BenchRun run = {0, 0, 0};
+	Board *board = CreateBoard(side, side);
+	int *headX = AllocMemory(length * sizeof(int));
+	int *headY = AllocMemory(length * sizeof(int));
+	uint8_t *hits = AllocMemory(length * sizeof(uint8_t));
+	CollideKernel best = GetCollideKernel();
+	if (!(board && headX && headY && hits && SetCollideKernel(kernel)))
+	{
+		FreeMemory(headX);
+		FreeMemory(headY);
+		FreeMemory(hits);
+		if (board)
+		{
+			DestroyBoard(board);
+		}
+		return run;
+	}
+
+	// scatter the heads over the board, and put a body under every eighth one so some of them hit
+	Random random;
+	SeedRandom(&random, 1);
+	for (int i = 0; i < length; ++i)
+	{
+		headX[i] = RangeRandom(&random, side);
+		headY[i] = RangeRandom(&random, side);
+		OccupyBoardCell(board, headX[i], headY[i]);
+		if (i % 8 == 0)
+		{
+			OccupyBoardCell(board, headX[i], headY[i]);
+		}
+	}
+
+	uint64_t allocations = GetMemoryStats().allocations;
+	double start = GetSeconds();
+	int collisions = 0;
+	for (long long i = 0; i < ops; ++i)
+	{
+		collisions += CollideBoardHeads(board, headX, headY, length, hits);
+	}
+	run.seconds = GetSeconds() - start;
+	run.allocations = GetMemoryStats().allocations - allocations;
+	run.ops = ops;
+	benchSink = collisions;
+
+	SetCollideKernel(best);
+	FreeMemory(headX);
+	FreeMemory(headY);
+	FreeMemory(hits);
+	DestroyBoard(board);
+
+	return run;
+}
+
+BenchRun BenchCollideHeadsScalar(int length, int side, long long ops)
+{
+	return BenchCollideHeads(COLLIDE_SCALAR, length, side, ops);
+}
+
+BenchRun BenchCollideHeadsBest(int length, int side, long long ops)
+{
+	return BenchCollideHeads(GetCollideKernel(), length, side, ops);
+}
+
+#if ManySnakes_BENCH_RENDER
+BenchRun BenchBatchSnake(int length, int side, long long ops)
+{
+	BenchRun run = {0, 0, 0};
+	int width, height;
+	ColumnBoardFor(length, side, &width, &height);
+	Board *board = CreateBoard(width, height);
+	SnakeColor color = {0x00, 0x00, 0xA0, 0xFF};
+	Snake *snake = board ? CreateSnake(board, width / 2, height / 2, 1, 1, 0, length, SNAKE_UP, &color) : NULL;
+	RenderBatch *batch = snake ? CreateRenderBatch(length) : NULL;
+	if (!batch)
+	{
+		if (snake)
+		{
+			DestroySnake(snake);
+		}
+		if (board)
+		{
+			DestroyBoard(board);
+		}
+		return run;
+	}
+
+	// build the quads of the whole snake the way a frame does, without drawing them
+	uint64_t allocations = GetMemoryStats().allocations;
+	double start = GetSeconds();
+	bool isBatched = true;
+	for (long long i = 0; i < ops && isBatched; ++i)
+	{
+		ClearRenderBatch(batch);
+		isBatched = BatchSnake(batch, snake, NULL, 0, 0, 20, 20);
+	}
+	run.seconds = GetSeconds() - start;
+	run.allocations = GetMemoryStats().allocations - allocations;
+	run.ops = isBatched ? ops : 0;
+
+	DestroyRenderBatch(batch);
+	DestroySnake(snake);
+	DestroyBoard(board);
+
+	return run;
+}
+#endif
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Read and write results as JSON, one benchmark per line so the baseline can be read back
+ * without a JSON library.
+ */
+
+int ReadBaseline(const char *path, BenchResult *baseline, int maxCount)
+{
+	FILE *file = fopen(path, "r");
+	if (!file)
+	{
+		return -1;
+	}
+
+	int count = 0;
+	char line[512];
+	while (count < maxCount && fgets(line, sizeof(line), file))
+	{
+		BenchResult *result = &baseline[count];
+		if (sscanf(line, " {\"name\": \"%31[^\"]\", \"length\": %d, \"board\": %d, \"ops\": %lld, \"nsPerOp\": %lf",
+					result->name, &result->length, &result->side, &result->ops, &result->nsPerOp) == 5)
+		{
+			++count;
+		}
+	}
+
+	fclose(file);
+
+	return count;
+}
+
+bool WriteResults(const char *path, const BenchResult *results, int count)
+{
+	FILE *file = fopen(path, "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"benchmarks\": [\n");
+	for (int i = 0; i < count; ++i)
+	{
+		const BenchResult *result = &results[i];
+		fprintf(file, "\t\t{\"name\": \"%s\", \"length\": %d, \"board\": %d, \"ops\": %lld, \"nsPerOp\": %.3f, \"opsPerSecond\": %.1f, \"allocationsPerOp\": %.6f}%s\n",
+				result->name, result->length, result->side, result->ops, result->nsPerOp, result->opsPerSecond, result->allocationsPerOp,
+				i + 1 < count ? "," : "");
+	}
+	fprintf(file, "\t]\n}\n");
+
+	return fclose(file) == 0;
+}
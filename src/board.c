@@ -0,0 +1,81 @@
+#include "board.h"
+#include "allocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+Board *CreateBoard(int width, int height)
+{
+	// a board needs at least one cell
+	if (width < 1 || height < 1)
+	{
+		return NULL;
+	}
+
+	Board *board = AllocMemory(sizeof(Board));
+	if (!board)
+	{
+		return NULL;
+	}
+
+	board->width = width;
+	board->height = height;
+
+	// create the occupancy counters, with a spare one past the end for wide loads, and the free cell list
+	size_t cellCount = (size_t) width * height;
+	board->counts = AllocMemory((cellCount + 1) * sizeof(uint16_t));
+	board->freeCells = AllocMemory(cellCount * sizeof(int));
+	board->freeSlots = AllocMemory(cellCount * sizeof(int));
+	if (!(board->counts && board->freeCells && board->freeSlots))
+	{
+		FreeMemory(board->counts);
+		FreeMemory(board->freeCells);
+		FreeMemory(board->freeSlots);
+		FreeMemory(board);
+		return NULL;
+	}
+
+	// every cell starts out empty
+	ClearBoard(board);
+
+	return board;
+}
+
+void ClearBoard(Board *board)
+{
+	int cellCount = board->width * board->height;
+
+	memset(board->counts, 0, ((size_t) cellCount + 1) * sizeof(uint16_t));
+
+	// every cell is free and sits in the slot matching its index
+	for (int cell = 0; cell < cellCount; ++cell)
+	{
+		board->freeCells[cell] = cell;
+		board->freeSlots[cell] = cell;
+	}
+	board->freeCount = cellCount;
+}
+
+bool RandFreeBoardCell(Board *board, Random *random, int *x, int *y)
+{
+	// a full board has nowhere left to put anything
+	if (board->freeCount == 0)
+	{
+		return false;
+	}
+
+	// pick a random slot of the free list, which is always a free cell
+	int cell = board->freeCells[RangeRandom(random, (uint32_t) board->freeCount)];
+	*x = cell % board->width;
+	*y = cell / board->width;
+
+	return true;
+}
+
+void DestroyBoard(Board *board)
+{
+	FreeMemory(board->counts);
+	FreeMemory(board->freeCells);
+	FreeMemory(board->freeSlots);
+	FreeMemory(board);
+}
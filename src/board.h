@@ -0,0 +1,95 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "random.h"
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare Board struct.
+ */
+
+// occupancy grid of the play area. every cell counts how many snake cells sit on it,
+// so "is this cell free" and "did the head hit something" are single lookups.
+// the free cells are also kept in a dense list with back-references from each cell
+// to its slot in the list, so a random free cell can be picked in constant time
+typedef struct Board
+{
+	int width, height;	// size of the board in cells
+	uint16_t *counts;	// number of snake cells on each cell, indexed by y * width + x, plus one spare that stays 0
+	int *freeCells;	// indices of the free cells, the first freeCount entries are valid
+	int *freeSlots;	// slot of each cell in freeCells, only meaningful while the cell is free
+	int freeCount;	// number of free cells
+} Board;
+
+Board *CreateBoard(int width, int height);
+void ClearBoard(Board *board);
+bool RandFreeBoardCell(Board *board, Random *random, int *x, int *y);
+void DestroyBoard(Board *board);
+
+// number of snake cells that sit on the cell at x, y
+static inline int CountBoardCell(const Board *board, int x, int y)
+{
+	return board->counts[y * board->width + x];
+}
+
+static inline bool IsFreeBoardCell(const Board *board, int x, int y)
+{
+	return board->counts[y * board->width + x] == 0;
+}
+
+static inline void OccupyBoardCell(Board *board, int x, int y)
+{
+	int cell = y * board->width + x;
+
+	// a cell that was free is taken out of the free list by moving the last free cell into its slot
+	if (board->counts[cell]++ == 0)
+	{
+		int slot = board->freeSlots[cell];
+		int last = board->freeCells[--board->freeCount];
+		board->freeCells[slot] = last;
+		board->freeSlots[last] = slot;
+	}
+}
+
+static inline void VacateBoardCell(Board *board, int x, int y)
+{
+	int cell = y * board->width + x;
+
+	// a cell that becomes free goes on the end of the free list
+	if (--board->counts[cell] == 0)
+	{
+		board->freeSlots[cell] = board->freeCount;
+		board->freeCells[board->freeCount++] = cell;
+	}
+}
+
+// change the count of a cell while other threads may be changing counts too. only the count
+// is touched, so the free list must be brought up to date afterwards with SyncBoardCell
+static inline void AddBoardCellCount(Board *board, int x, int y, int delta)
+{
+	__atomic_fetch_add(&board->counts[y * board->width + x], (uint16_t) delta, __ATOMIC_RELAXED);
+}
+
+// put a cell in or take it out of the free list to match its count
+static inline void SyncBoardCell(Board *board, int x, int y)
+{
+	int cell = y * board->width + x;
+	int slot = board->freeSlots[cell];
+	bool isListed = slot < board->freeCount && board->freeCells[slot] == cell;
+
+	if (board->counts[cell] == 0 && !isListed)
+	{
+		board->freeSlots[cell] = board->freeCount;
+		board->freeCells[board->freeCount++] = cell;
+	}
+	else if (board->counts[cell] != 0 && isListed)
+	{
+		int last = board->freeCells[--board->freeCount];
+		board->freeCells[slot] = last;
+		board->freeSlots[last] = slot;
+	}
+}
+
+#endif
@@ -0,0 +1,407 @@
+#include "client.h"
+#include "allocator.h"
+#include <string.h>
+
+
+// snapshot parts a client has room to track from the start
+#define CLIENT_MIN_PARTS 64
+// highest snake a snapshot may name, so a bad packet cannot make the mirror huge
+#define CLIENT_MAX_SNAKES (1 << 22)
+// cells of a body put in the mirror at once
+#define CLIENT_BODY_BATCH 64
+// bytes an input takes before its turns, and the most one turn takes
+#define CLIENT_INPUT_HEADER 10
+#define CLIENT_MAX_TURN 6
+
+static bool WelcomeNetClient(NetClient *client, NetPacket *packet);
+static int ReadNetClientPart(NetClient *client, NetMessage message, NetPacket *packet);
+static bool ReadNetClientRecords(NetClient *client, NetPacket *packet);
+static bool ReadNetClientBody(NetClient *client, NetPacket *packet, int snake, SnakeDirection direction);
+
+NetClient *CreateNetClient(const char *host, int port, int snakeCount)
+{
+	NetClient *client = CallocMemory(1, sizeof(NetClient));
+	if (!client)
+	{
+		return NULL;
+	}
+
+	// the socket takes any free port, the server answers to whichever it was
+	client->snakesWanted = snakeCount > 0 ? snakeCount : 1;
+	client->socket = OpenNetSocket(0);
+	client->partCapacity = CLIENT_MIN_PARTS;
+	client->partMarks = AllocMemory(client->partCapacity * sizeof(uint8_t));
+	if (!(client->socket && client->partMarks && ResolveNetAddress(host, port, &client->server)))
+	{
+		DestroyNetClient(client);
+		return NULL;
+	}
+
+	return client;
+}
+
+int PollNetClient(NetClient *client)
+{
+	// read every packet that is waiting, and count the snapshots that were completed by them
+	int applied = 0;
+	NetAddress address;
+	NetPacket *packet = &client->packet;
+	while (ReceiveNetSocket(client->socket, &address, packet))
+	{
+		if (!IsSameNetAddress(&address, &client->server))
+		{
+			continue;
+		}
+
+		NetMessage message = (NetMessage) GetNetU8(packet);
+		if (message == NET_WELCOME && !client->mirror && !WelcomeNetClient(client, packet))
+		{
+			return -1;
+		}
+		else if ((message == NET_DELTA || message == NET_FULL) && client->mirror)
+		{
+			int result = ReadNetClientPart(client, message, packet);
+			if (result < 0)
+			{
+				return -1;
+			}
+
+			applied += result;
+		}
+	}
+
+	return applied;
+}
+
+void SteerNetClient(NetClient *client, int own, SnakeDirection direction)
+{
+	// the last turn before the next flush is the one sent
+	if (client->turns && own >= 0 && own < client->snakeCount)
+	{
+		client->turns[own] = direction;
+	}
+}
+
+bool FlushNetClient(NetClient *client)
+{
+	NetPacket *packet = &client->packet;
+
+	// until the server answers, keep asking to join
+	if (!client->mirror)
+	{
+		StartNetPacket(packet, NET_JOIN);
+		PutNetVarint(packet, (uint32_t) client->snakesWanted);
+		return SendNetSocket(client->socket, &client->server, packet);
+	}
+
+	// send the turns along with how far the mirror got, in as many packets as it takes. even with
+	// no turns one goes out, so the server knows the client is still there
+	bool isSent = true;
+	int own = 0;
+	do
+	{
+		int turnCount = 0, end = own;
+		for (; end < client->snakeCount && (turnCount + 1) * CLIENT_MAX_TURN <= NET_MAX_PACKET - CLIENT_INPUT_HEADER; ++end)
+		{
+			turnCount += client->turns[end] != 0;
+		}
+
+		StartNetPacket(packet, NET_INPUT);
+		PutNetU32(packet, client->appliedTick);
+		PutNetU8(packet, !client->isSynced);
+		PutNetVarint(packet, (uint32_t) turnCount);
+		for (; own < end; ++own)
+		{
+			if (client->turns[own])
+			{
+				PutNetVarint(packet, (uint32_t) own);
+				PutNetU8(packet, (uint8_t) EncodeSnapshotDirection(client->turns[own]));
+				client->turns[own] = 0;
+			}
+		}
+
+		isSent = SendNetSocket(client->socket, &client->server, packet) && isSent;
+	}
+	while (own < client->snakeCount);
+
+	return isSent;
+}
+
+void DestroyNetClient(NetClient *client)
+{
+	// tell the server, so the snakes leave now instead of when it gives up on the client
+	if (client->mirror)
+	{
+		StartNetPacket(&client->packet, NET_LEAVE);
+		SendNetSocket(client->socket, &client->server, &client->packet);
+		DestroyWorld(client->mirror);
+	}
+
+	if (client->socket)
+	{
+		CloseNetSocket(client->socket);
+	}
+
+	FreeMemory(client->partMarks);
+	FreeMemory(client->turns);
+	FreeMemory(client);
+}
+
+static bool WelcomeNetClient(NetClient *client, NetPacket *packet)
+{
+	int firstSnake = (int) GetNetVarint(packet);
+	int snakeCount = (int) GetNetVarint(packet);
+	int width = (int) GetNetU32(packet);
+	int height = (int) GetNetU32(packet);
+	int foodCount = (int) GetNetVarint(packet);
+	int tickRate = (int) GetNetVarint(packet);
+	if (packet->isBad || width < 1 || height < 1 || snakeCount < 0 || firstSnake + snakeCount > CLIENT_MAX_SNAKES)
+	{
+		return true;
+	}
+
+	// the mirror starts empty, the first full snapshot fills it in
+	client->mirror = CreateWorld(width, height, foodCount, 0);
+	client->turns = CallocMemory(snakeCount > 0 ? snakeCount : 1, sizeof(SnakeDirection));
+	if (!(client->mirror && client->turns))
+	{
+		return false;
+	}
+
+	for (int food = 0; food < foodCount; ++food)
+	{
+		MoveWorldFood(client->mirror, food, -1, -1);
+	}
+
+	client->firstSnake = firstSnake;
+	client->snakeCount = snakeCount;
+	client->tickRate = tickRate > 0 ? tickRate : 1;
+	client->isSynced = false;
+
+	return true;
+}
+
+static int ReadNetClientPart(NetClient *client, NetMessage message, NetPacket *packet)
+{
+	uint32_t tick = GetNetU32(packet);
+	int part = GetNetU16(packet);
+	int partCount = GetNetU16(packet);
+	if (packet->isBad || part >= partCount)
+	{
+		return 0;
+	}
+
+	// a delta only follows on from the tick before it, so one that skips a tick means a packet was
+	// lost and the client has to ask for the whole world. anything older than the mirror is late
+	int32_t ahead = (int32_t) (tick - client->appliedTick);
+	if (message == NET_DELTA && (!client->isSynced || ahead <= 0))
+	{
+		return 0;
+	}
+	else if (message == NET_DELTA && ahead > 1)
+	{
+		client->isSynced = false;
+		return 0;
+	}
+	else if (message == NET_FULL && client->isSynced && ahead <= 0)
+	{
+		return 0;
+	}
+
+	// the first part of a new snapshot starts it over. a full one starts from an empty world
+	if (message != client->partMessage || tick != client->partTick || partCount != client->partCount)
+	{
+		if (partCount > client->partCapacity)
+		{
+			uint8_t *partMarks = ReallocMemory(client->partMarks, partCount * sizeof(uint8_t));
+			if (!partMarks)
+			{
+				return -1;
+			}
+
+			client->partMarks = partMarks;
+			client->partCapacity = partCount;
+		}
+
+		memset(client->partMarks, 0, partCount * sizeof(uint8_t));
+		client->partMessage = message;
+		client->partTick = tick;
+		client->partCount = partCount;
+		client->partsSeen = 0;
+
+		if (message == NET_FULL)
+		{
+			for (int snake = 0; snake < client->mirror->snakeCount; ++snake)
+			{
+				RemoveWorldSnake(client->mirror, snake);
+			}
+
+			for (int food = 0; food < client->mirror->foodCount; ++food)
+			{
+				MoveWorldFood(client->mirror, food, -1, -1);
+			}
+		}
+	}
+
+	// every part holds whole records, so each is used as soon as it comes in
+	if (client->partMarks[part])
+	{
+		return 0;
+	}
+	client->partMarks[part] = 1;
+	++client->partsSeen;
+
+	if (!ReadNetClientRecords(client, packet))
+	{
+		client->isSynced = false;
+		client->partMessage = 0;
+		return 0;
+	}
+
+	if (client->partsSeen < client->partCount)
+	{
+		return 0;
+	}
+
+	// the whole snapshot is in
+	client->appliedTick = tick;
+	client->partMessage = 0;
+	if (message == NET_FULL)
+	{
+		client->isSynced = true;
+		++client->fullsApplied;
+	}
+	else
+	{
+		++client->deltasApplied;
+	}
+
+	return 1;
+}
+
+static bool ReadNetClientRecords(NetClient *client, NetPacket *packet)
+{
+	World *mirror = client->mirror;
+	while (packet->offset < packet->size)
+	{
+		uint8_t tag = GetNetU8(packet);
+
+		// food goes straight to its cell, or out of play at 0
+		if (tag & SNAPSHOT_FOOD)
+		{
+			uint32_t food = GetNetVarint(packet);
+			int x = (int) GetNetVarint(packet) - 1;
+			int y = (int) GetNetVarint(packet) - 1;
+			if (packet->isBad || food >= (uint32_t) mirror->foodCount || x >= mirror->width || y >= mirror->height || (x < 0) != (y < 0))
+			{
+				return false;
+			}
+
+			MoveWorldFood(mirror, (int) food, x, y);
+			continue;
+		}
+
+		uint32_t snake = GetNetVarint(packet);
+		if (packet->isBad || snake >= CLIENT_MAX_SNAKES)
+		{
+			return false;
+		}
+
+		SnakeDirection direction = DecodeSnapshotDirection(tag);
+		if (tag & SNAPSHOT_BODY)
+		{
+			if (!ReadNetClientBody(client, packet, (int) snake, direction))
+			{
+				return false;
+			}
+			continue;
+		}
+
+		// a snake that died moved first, but that is of no use to the mirror
+		if (tag & SNAPSHOT_DIED)
+		{
+			if (snake < (uint32_t) mirror->snakeCount)
+			{
+				RemoveWorldSnake(mirror, (int) snake);
+			}
+			continue;
+		}
+
+		// a snake that came back is placed before it moves, like the server did
+		if (tag & SNAPSHOT_SPAWNED)
+		{
+			uint32_t x = GetNetVarint(packet);
+			uint32_t y = GetNetVarint(packet);
+			SnakeColor color = {GetNetU8(packet), GetNetU8(packet), GetNetU8(packet), 0xFF};
+			if (packet->isBad || x >= (uint32_t) mirror->width || y >= (uint32_t) mirror->height || !PlaceWorldSnake(mirror, (int) snake, (int) x, (int) y, direction, &color))
+			{
+				return false;
+			}
+		}
+
+		if (tag & SNAPSHOT_MOVED)
+		{
+			if (snake >= (uint32_t) mirror->snakeCount || !mirror->isAlive[snake] || !PushWorldSnake(mirror, (int) snake, direction, (tag & SNAPSHOT_GREW) != 0))
+			{
+				return false;
+			}
+		}
+	}
+
+	return !packet->isBad;
+}
+
+static bool ReadNetClientBody(NetClient *client, NetPacket *packet, int snake, SnakeDirection direction)
+{
+	World *mirror = client->mirror;
+	SnakeColor color = {GetNetU8(packet), GetNetU8(packet), GetNetU8(packet), 0xFF};
+	uint32_t offset = GetNetVarint(packet);
+	uint32_t count = GetNetVarint(packet);
+	SnakeCell cell = {(int) GetNetVarint(packet), (int) GetNetVarint(packet)};
+	if (packet->isBad || count < 1 || cell.xPos < 0 || cell.xPos >= mirror->width || cell.yPos < 0 || cell.yPos >= mirror->height)
+	{
+		return false;
+	}
+
+	// the first record of a body places its head, the others carry on from its tail
+	SnakeCell batch[CLIENT_BODY_BATCH];
+	int batched = 0;
+	if (offset == 0)
+	{
+		if (!PlaceWorldSnake(mirror, snake, cell.xPos, cell.yPos, direction, &color))
+		{
+			return false;
+		}
+	}
+	else if (snake < mirror->snakeCount && mirror->isAlive[snake] && (uint32_t) mirror->length[snake] == offset)
+	{
+		batch[batched++] = cell;
+	}
+	else
+	{
+		return false;
+	}
+
+	// each code leads from one cell to the next, four to a byte
+	uint8_t codes = 0;
+	for (uint32_t i = 1; i < count && !packet->isBad; ++i)
+	{
+		if ((i - 1) % 4 == 0)
+		{
+			codes = GetNetU8(packet);
+		}
+
+		cell = MoveSnapshotCell(cell, codes >> ((i - 1) % 4 * 2), mirror->width, mirror->height);
+		batch[batched++] = cell;
+		if (batched == CLIENT_BODY_BATCH)
+		{
+			if (!ExtendWorldSnake(mirror, snake, batch, batched))
+			{
+				return false;
+			}
+			batched = 0;
+		}
+	}
+
+	return !packet->isBad && ExtendWorldSnake(mirror, snake, batch, batched);
+}
@@ -0,0 +1,47 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "net.h"
+#include "server.h"
+#include "world.h"
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare NetClient struct.
+ */
+
+// the other end of a Server. keeps a mirror of the server's world up to date from its snapshots,
+// which can be drawn like any World, and sends the turns of the client's own snakes
+typedef struct NetClient
+{
+	NetSocket *socket;
+	NetAddress server;
+	int snakesWanted;	// snakes asked for when joining
+
+	World *mirror;	// the server's world as of appliedTick, NULL until the server answers
+	int firstSnake, snakeCount;	// the client's own snakes in the mirror
+	int tickRate;	// server ticks per second
+	uint32_t appliedTick;	// last tick the mirror has every change of
+	bool isSynced;	// false until the first full snapshot, and again after a lost packet
+
+	// the snapshot being put together, one mark for every part already used
+	NetMessage partMessage;
+	uint32_t partTick;
+	uint8_t *partMarks;
+	int partCount, partsSeen, partCapacity;
+
+	SnakeDirection *turns;	// turn of each own snake for the next input, 0 for none
+	NetPacket packet;	// the packet being read or written
+
+	uint64_t deltasApplied, fullsApplied;	// snapshots put together, for telling how often packets go missing
+} NetClient;
+
+NetClient *CreateNetClient(const char *host, int port, int snakeCount);
+int PollNetClient(NetClient *client);
+void SteerNetClient(NetClient *client, int own, SnakeDirection direction);
+bool FlushNetClient(NetClient *client);
+void DestroyNetClient(NetClient *client);
+
+#endif
@@ -0,0 +1,168 @@
+#include "collide.h"
+#include <string.h>
+
+// the vector kernels need x86 intrinsics and a compiler that can build single functions for a
+// newer CPU than the rest of the program, and ask the CPU at run time what it supports
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLLIDE_X86 1
+#include <immintrin.h>
+#else
+#define COLLIDE_X86 0
+#endif
+
+static bool IsCollideKernelSupported(CollideKernel kernel);
+static int CollideHeadsScalar(const Board *board, const int *headX, const int *headY, int count, uint8_t *hits);
+#if COLLIDE_X86
+static int CollideHeadsSSE2(const Board *board, const int *headX, const int *headY, int count, uint8_t *hits);
+static int CollideHeadsAVX2(const Board *board, const int *headX, const int *headY, int count, uint8_t *hits);
+#endif
+
+// kernel in use, -1 until it is first asked for. loaded and stored atomically, since the workers
+// of a world step check their heads at the same time
+static int collideKernel = -1;
+
+CollideKernel GetCollideKernel(void)
+{
+	int kernel = __atomic_load_n(&collideKernel, __ATOMIC_RELAXED);
+	if (kernel < 0)
+	{
+		// every thread that gets here picks the same kernel, so racing to store it is harmless
+		kernel = IsCollideKernelSupported(COLLIDE_AVX2) ? COLLIDE_AVX2 : IsCollideKernelSupported(COLLIDE_SSE2) ? COLLIDE_SSE2 : COLLIDE_SCALAR;
+		__atomic_store_n(&collideKernel, kernel, __ATOMIC_RELAXED);
+	}
+
+	return (CollideKernel) kernel;
+}
+
+bool SetCollideKernel(CollideKernel kernel)
+{
+	if (!IsCollideKernelSupported(kernel))
+	{
+		return false;
+	}
+
+	__atomic_store_n(&collideKernel, (int) kernel, __ATOMIC_RELAXED);
+
+	return true;
+}
+
+const char *NameCollideKernel(CollideKernel kernel)
+{
+	switch (kernel)
+	{
+		case COLLIDE_SCALAR: return "scalar";
+		case COLLIDE_SSE2: return "sse2";
+		case COLLIDE_AVX2: return "avx2";
+	}
+
+	return "unknown";
+}
+
+int CollideBoardHeads(const Board *board, const int *headX, const int *headY, int count, uint8_t *hits)
+{
+	switch (GetCollideKernel())
+	{
+#if COLLIDE_X86
+		case COLLIDE_AVX2: return CollideHeadsAVX2(board, headX, headY, count, hits);
+		case COLLIDE_SSE2: return CollideHeadsSSE2(board, headX, headY, count, hits);
+#endif
+		default: return CollideHeadsScalar(board, headX, headY, count, hits);
+	}
+}
+
+static bool IsCollideKernelSupported(CollideKernel kernel)
+{
+	switch (kernel)
+	{
+		case COLLIDE_SCALAR: return true;
+#if COLLIDE_X86
+		case COLLIDE_SSE2: return __builtin_cpu_supports("sse2");
+		case COLLIDE_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+		default: return false;
+	}
+}
+
+static int CollideHeadsScalar(const Board *board, const int *headX, const int *headY, int count, uint8_t *hits)
+{
+	// the board is read through locals, since a store to hits could otherwise alias it
+	const uint16_t *counts = board->counts;
+	int width = board->width;
+	int hitCount = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		int hit = counts[headY[i] * width + headX[i]] > 1;
+		hits[i] = (uint8_t) hit;
+		hitCount += hit;
+	}
+
+	return hitCount;
+}
+
+#if COLLIDE_X86
+__attribute__((target("sse2")))
+static int CollideHeadsSSE2(const Board *board, const int *headX, const int *headY, int count, uint8_t *hits)
+{
+	const uint16_t *counts = board->counts;
+	__m128i width = _mm_set1_epi32(board->width);
+	__m128i one = _mm_set1_epi32(1);
+	int hitCount = 0;
+	int i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i *) (headX + i));
+		__m128i y = _mm_loadu_si128((const __m128i *) (headY + i));
+
+		// y * width + x. SSE2 only multiplies the even lanes, so the odd ones are shifted down,
+		// multiplied on their own and woven back in
+		__m128i even = _mm_mul_epu32(y, width);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(y, 32), width);
+		__m128i rows = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		int cells[4];
+		_mm_storeu_si128((__m128i *) cells, _mm_add_epi32(rows, x));
+
+		// there is no gather before AVX2, so the counts are looked up one by one
+		__m128i cellCounts = _mm_set_epi32(counts[cells[3]], counts[cells[2]], counts[cells[1]], counts[cells[0]]);
+		__m128i isHit = _mm_cmpgt_epi32(cellCounts, one);
+		hitCount += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(isHit)));
+
+		// narrow the lanes to one byte each and store the four flags at once
+		__m128i bytes = _mm_and_si128(_mm_packs_epi16(_mm_packs_epi32(isHit, isHit), isHit), _mm_set1_epi8(1));
+		int flags = _mm_cvtsi128_si32(bytes);
+		memcpy(hits + i, &flags, 4);
+	}
+
+	return hitCount + CollideHeadsScalar(board, headX + i, headY + i, count - i, hits + i);
+}
+
+__attribute__((target("avx2")))
+static int CollideHeadsAVX2(const Board *board, const int *headX, const int *headY, int count, uint8_t *hits)
+{
+	__m256i width = _mm256_set1_epi32(board->width);
+	__m256i one = _mm256_set1_epi32(1);
+	__m256i low = _mm256_set1_epi32(0xFFFF);
+	int hitCount = 0;
+	int i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i *) (headX + i));
+		__m256i y = _mm256_loadu_si256((const __m256i *) (headY + i));
+		__m256i cells = _mm256_add_epi32(_mm256_mullo_epi32(y, width), x);
+
+		// gather 32 bits from each count, which brings the next count along, and keep the low half.
+		// the board keeps a spare count past the last cell so the gather never reads past its end
+		__m256i cellCounts = _mm256_and_si256(_mm256_i32gather_epi32((const int *) board->counts, cells, 2), low);
+		__m256i isHit = _mm256_cmpgt_epi32(cellCounts, one);
+		hitCount += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(isHit)));
+
+		// narrow the lanes to one byte each and store the eight flags at once
+		__m128i words = _mm_packs_epi32(_mm256_castsi256_si128(isHit), _mm256_extracti128_si256(isHit, 1));
+		__m128i bytes = _mm_and_si128(_mm_packs_epi16(words, words), _mm_set1_epi8(1));
+		_mm_storel_epi64((__m128i *) (hits + i), bytes);
+	}
+
+	return hitCount + CollideHeadsScalar(board, headX + i, headY + i, count - i, hits + i);
+}
+#endif
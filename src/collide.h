@@ -0,0 +1,32 @@
+#ifndef COLLIDE_H
+#define COLLIDE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare CollideKernel enum.
+ */
+
+// ways a batch of heads can be checked against the board, from slowest to fastest
+typedef enum
+{
+	COLLIDE_SCALAR,	// one head at a time, works everywhere
+	COLLIDE_SSE2,	// four heads at a time, with the lookups done one by one
+	COLLIDE_AVX2	// eight heads at a time, with the lookups gathered in one instruction
+} CollideKernel;
+
+// the fastest kernel this CPU can run, picked the first time the heads are checked
+CollideKernel GetCollideKernel(void);
+// run a slower kernel instead, for comparing them. false if this CPU cannot run it
+bool SetCollideKernel(CollideKernel kernel);
+const char *NameCollideKernel(CollideKernel kernel);
+
+// check every head against the board in one pass. a head collided when its cell holds more than
+// one snake cell, its own included. sets hits[i] to 1 for those heads and 0 for the rest, and
+// returns the number of heads that collided
+int CollideBoardHeads(const Board *board, const int *headX, const int *headY, int count, uint8_t *hits);
+
+#endif
@@ -0,0 +1,237 @@
+#include "env.h"
+#include "allocator.h"
+#include <string.h>
+
+
+// the heading each action turns to, 0 for ENV_KEEP
+static const SnakeDirection ENV_DIRECTIONS[] = {(SnakeDirection) 0, SNAKE_RIGHT, SNAKE_UP, SNAKE_LEFT, SNAKE_DOWN};
+
+static void ResetEnvGames(void *data, int begin, int end);
+static void StepEnvGames(void *data, int begin, int end);
+static void ResetEnvGame(EnvBatch *batch, int i);
+static void ObserveEnvGame(EnvBatch *batch, int i);
+static int WrapEnvOffset(int offset, int size);
+
+EnvBatch *CreateEnvBatch(const GameConfig *config, int gameCount, EnvObservation observation, int starveTicks, int threadCount)
+{
+	if (gameCount < 1 || (observation != ENV_OBSERVE_GRID && observation != ENV_OBSERVE_FEATURES))
+	{
+		return NULL;
+	}
+
+	EnvBatch *batch = CallocMemory(1, sizeof(EnvBatch));
+	if (!batch)
+	{
+		return NULL;
+	}
+
+	batch->gameCount = gameCount;
+	batch->starveTicks = starveTicks > 0 ? starveTicks : 0;
+	batch->observation = observation;
+	batch->observationSize = observation == ENV_OBSERVE_GRID ? ENV_GRID_PLANES * config->width * config->height : ENV_FEATURE_COUNT;
+
+	// every game is made once up front, so resets and steps never touch the heap
+	batch->start = CreateGame(config);
+	batch->games = CallocMemory(gameCount, sizeof(Game *));
+	batch->seeders = AllocMemory(gameCount * sizeof(Random));
+	batch->lastMeals = CallocMemory(gameCount, sizeof(uint64_t));
+	if (!batch->start || !batch->games || !batch->seeders || !batch->lastMeals || (threadCount > 1 && !(batch->workers = CreateWorkerPool(threadCount))))
+	{
+		DestroyEnvBatch(batch);
+		return NULL;
+	}
+
+	for (int i = 0; i < gameCount; ++i)
+	{
+		batch->games[i] = CreateGame(config);
+		if (!batch->games[i])
+		{
+			DestroyEnvBatch(batch);
+			return NULL;
+		}
+
+		// each game draws its rounds' seeds from a stream of its own, so the rounds do not depend on
+		// which worker steps them or in what order
+		SeedRandom(&batch->seeders[i], config->seed + (uint64_t) i);
+	}
+
+	return batch;
+}
+
+void ResetEnvBatch(EnvBatch *batch, float *observations)
+{
+	batch->observations = observations;
+
+	if (batch->workers)
+	{
+		RunWorkerPool(batch->workers, batch->gameCount, ResetEnvGames, batch);
+	}
+	else
+	{
+		ResetEnvGames(batch, 0, batch->gameCount);
+	}
+}
+
+void StepEnvBatch(EnvBatch *batch, const uint8_t *actions, float *observations, float *rewards, uint8_t *dones)
+{
+	batch->actions = actions;
+	batch->observations = observations;
+	batch->rewards = rewards;
+	batch->dones = dones;
+
+	if (batch->workers)
+	{
+		RunWorkerPool(batch->workers, batch->gameCount, StepEnvGames, batch);
+	}
+	else
+	{
+		StepEnvGames(batch, 0, batch->gameCount);
+	}
+}
+
+void DestroyEnvBatch(EnvBatch *batch)
+{
+	if (batch->workers)
+	{
+		DestroyWorkerPool(batch->workers);
+	}
+
+	if (batch->games)
+	{
+		for (int i = 0; i < batch->gameCount; ++i)
+		{
+			if (batch->games[i])
+			{
+				DestroyGame(batch->games[i]);
+			}
+		}
+	}
+
+	if (batch->start)
+	{
+		DestroyGame(batch->start);
+	}
+
+	FreeMemory(batch->lastMeals);
+	FreeMemory(batch->seeders);
+	FreeMemory(batch->games);
+	FreeMemory(batch);
+}
+
+static void ResetEnvGames(void *data, int begin, int end)
+{
+	EnvBatch *batch = data;
+
+	for (int i = begin; i < end; ++i)
+	{
+		ResetEnvGame(batch, i);
+		ObserveEnvGame(batch, i);
+	}
+}
+
+static void StepEnvGames(void *data, int begin, int end)
+{
+	EnvBatch *batch = data;
+
+	for (int i = begin; i < end; ++i)
+	{
+		Game *game = batch->games[i];
+		uint8_t action = batch->actions[i];
+		GameInput input = {action <= ENV_DOWN ? ENV_DIRECTIONS[action] : (SnakeDirection) 0};
+		GameEvent events = StepGame(game, &input);
+
+		// eating is worth 1 and dying costs 1. a round that starves out ends without either
+		float reward = (events & GAME_EVENT_ATE) ? 1.0f : (events & GAME_EVENT_DIED) ? -1.0f : 0.0f;
+		if (events & GAME_EVENT_ATE)
+		{
+			batch->lastMeals[i] = game->tick;
+		}
+
+		bool isDone = game->isOver || (batch->starveTicks > 0 && game->tick - batch->lastMeals[i] >= (uint64_t) batch->starveTicks);
+		if (isDone)
+		{
+			ResetEnvGame(batch, i);
+			__atomic_fetch_add(&batch->episodes, 1, __ATOMIC_RELAXED);
+		}
+
+		batch->rewards[i] = reward;
+		batch->dones[i] = isDone;
+		ObserveEnvGame(batch, i);
+	}
+}
+
+static void ResetEnvGame(EnvBatch *batch, int i)
+{
+	// start from the shared first state, then place the food with the round's own seed
+	Game *game = batch->games[i];
+	Random *seeder = &batch->seeders[i];
+	CopyGame(game, batch->start);
+	SeedRandom(&game->random, (uint64_t) NextRandom(seeder) << 32 | NextRandom(seeder));
+	game->isOver = !RandPosFood(&game->food, game->board, &game->random);
+	game->changeCount = 0;
+	batch->lastMeals[i] = game->tick;
+}
+
+static void ObserveEnvGame(EnvBatch *batch, int i)
+{
+	Game *game = batch->games[i];
+	Board *board = game->board;
+	Snake *player = game->player;
+	SnakeCell *head = SnakeHead(player);
+	float *observation = batch->observations + (size_t) i * batch->observationSize;
+
+	if (batch->observation == ENV_OBSERVE_GRID)
+	{
+		// clear the planes, then mark the cells of the body, the head and the food
+		int planeSize = board->width * board->height;
+		float *body = observation, *heads = observation + planeSize, *food = observation + 2 * planeSize;
+		memset(observation, 0, (size_t) batch->observationSize * sizeof(float));
+
+		for (int cell = 0; cell < player->length; ++cell)
+		{
+			SnakeCell *cur = SnakeCellAt(player, cell);
+			body[cur->yPos * board->width + cur->xPos] = 1;
+		}
+		heads[head->yPos * board->width + head->xPos] = 1;
+		food[game->food.yPos * board->width + game->food.xPos] = 1;
+
+		return;
+	}
+
+	// the cells next to the head, wrapping like the snake does, in the order right, up, left, down
+	int xRight = head->xPos + 1 < board->width ? head->xPos + 1 : 0;
+	int xLeft = head->xPos > 0 ? head->xPos - 1 : board->width - 1;
+	int yDown = head->yPos + 1 < board->height ? head->yPos + 1 : 0;
+	int yUp = head->yPos > 0 ? head->yPos - 1 : board->height - 1;
+	observation[0] = !IsFreeBoardCell(board, xRight, head->yPos);
+	observation[1] = !IsFreeBoardCell(board, head->xPos, yUp);
+	observation[2] = !IsFreeBoardCell(board, xLeft, head->yPos);
+	observation[3] = !IsFreeBoardCell(board, head->xPos, yDown);
+
+	// the shortest way to the food, which may be across an edge
+	observation[4] = (float) WrapEnvOffset(game->food.xPos - head->xPos, board->width) / (float) board->width;
+	observation[5] = (float) WrapEnvOffset(game->food.yPos - head->yPos, board->height) / (float) board->height;
+
+	observation[6] = player->currentDirection == SNAKE_RIGHT;
+	observation[7] = player->currentDirection == SNAKE_UP;
+	observation[8] = player->currentDirection == SNAKE_LEFT;
+	observation[9] = player->currentDirection == SNAKE_DOWN;
+
+	observation[10] = (float) player->length / (float) (board->width * board->height);
+}
+
+static int WrapEnvOffset(int offset, int size)
+{
+	// bring the offset between -size / 2 and size / 2, going across the edge when that is shorter
+	if (offset > size / 2)
+	{
+		return offset - size;
+	}
+
+	if (offset < -size / 2)
+	{
+		return offset + size;
+	}
+
+	return offset;
+}
@@ -0,0 +1,76 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "game.h"
+#include "workers.h"
+
+
+// planes of a grid observation, each width * height values: the body, the head and the food
+#define ENV_GRID_PLANES 3
+// values of a feature observation
+#define ENV_FEATURE_COUNT 11
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare EnvObservation, EnvAction enums.
+ */
+
+// what each game is observed as
+typedef enum
+{
+	// ENV_GRID_PLANES planes of width * height, 1 where the body, the head or the food is and 0 elsewhere
+	ENV_OBSERVE_GRID = 1,
+	// ENV_FEATURE_COUNT values: for right, up, left and down whether the next cell is body, the food's
+	// offset from the head over the board size in x then y, the heading one-hot in the same order,
+	// and the length over the board's cell count
+	ENV_OBSERVE_FEATURES = 2
+} EnvObservation;
+
+// what each game is told to do on a step. a turn back into the body is ignored like a key press
+typedef enum
+{
+	ENV_KEEP = 0,
+	ENV_RIGHT,
+	ENV_UP,
+	ENV_LEFT,
+	ENV_DOWN
+} EnvAction;
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare EnvBatch struct.
+ */
+
+// many independent games stepped together, for training agents. a step takes one action per game
+// and writes every observation, reward and done flag straight into the caller's arrays, game i at
+// index i, with no copy in between. a game that ends is reset right away with a new seed, and its
+// observation is of the new game, so the batch never has to be reset by hand. the games are split
+// across a worker pool, and any number of workers gives the same results
+typedef struct EnvBatch
+{
+	Game **games;
+	int gameCount;
+	Game *start;	// the game every reset copies, before its food is placed with the new seed
+	Random *seeders;	// gives the seed of each game's next round
+	uint64_t *lastMeals;	// tick each game last ate on, or started
+	int starveTicks;	// ticks without eating that end a round, 0 for never
+	EnvObservation observation;
+	int observationSize;	// values per game
+	WorkerPool *workers;	// threads that share a step, NULL to step on the calling thread only
+
+	// the arrays of the current step, handed to the workers
+	const uint8_t *actions;
+	float *observations, *rewards;
+	uint8_t *dones;
+
+	uint64_t episodes;	// rounds finished over every game
+} EnvBatch;
+
+EnvBatch *CreateEnvBatch(const GameConfig *config, int gameCount, EnvObservation observation, int starveTicks, int threadCount);
+void ResetEnvBatch(EnvBatch *batch, float *observations);
+void StepEnvBatch(EnvBatch *batch, const uint8_t *actions, float *observations, float *rewards, uint8_t *dones);
+void DestroyEnvBatch(EnvBatch *batch);
+
+#endif
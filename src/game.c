@@ -0,0 +1,178 @@
+#include "game.h"
+#include "allocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+Game *CreateGame(const GameConfig *config)
+{
+	Game *game = AllocMemory(sizeof(Game));
+	if (!game)
+	{
+		return NULL;
+	}
+
+	// create the board, then place the player and the food on it
+	game->board = CreateBoard(config->width, config->height);
+	if (!game->board)
+	{
+		FreeMemory(game);
+		return NULL;
+	}
+
+	SnakeColor color = config->color;
+	game->player = CreateSnake(game->board, config->xStart, config->yStart, config->nodeWidth, config->nodeHeight, config->speed, config->length, config->direction, &color);
+
+	// the snake can never be longer than the board has cells, so its ring buffer is made that big
+	// up front and growing never touches the heap during the round
+	if (!game->player || !ReserveSnake(game->player, config->width * config->height))
+	{
+		if (game->player)
+		{
+			DestroySnake(game->player);
+		}
+		DestroyBoard(game->board);
+		FreeMemory(game);
+		return NULL;
+	}
+
+	SeedRandom(&game->random, config->seed);
+	game->food.type = FOOD_APPLE;
+	game->food.xPos = game->food.yPos = 0;
+	game->tick = 0;
+	game->isOver = !RandPosFood(&game->food, game->board, &game->random);
+	game->changeCount = 0;
+
+	return game;
+}
+
+GameEvent StepGame(Game *game, const GameInput *input)
+{
+	game->changeCount = 0;
+
+	// a finished game does not move anymore
+	if (game->isOver)
+	{
+		return GAME_EVENT_NONE;
+	}
+
+	Snake *player = game->player;
+
+	if (input && input->direction)
+	{
+		SteerSnake(player, input->direction);
+	}
+
+	// store tail position for new tail if snake grows
+	int xTail = SnakeTail(player)->xPos;
+	int yTail = SnakeTail(player)->yPos;
+
+	// update the snake's position
+	StepSnake(player, game->board);
+	++game->tick;
+	GameEvent events = GAME_EVENT_MOVED;
+
+	// the tail left its cell and the head took a new one
+	game->changes[game->changeCount++] = (SnakeCell) {xTail, yTail};
+	game->changes[game->changeCount++] = *SnakeHead(player);
+
+	// if snake hits itself, end game
+	if (CheckCollisionSnake(player, game->board))
+	{
+		game->isOver = true;
+		return events | GAME_EVENT_DIED;
+	}
+
+	// if snake eats food, grow snake and move food
+	SnakeCell *head = SnakeHead(player);
+	if (head->xPos == game->food.xPos && head->yPos == game->food.yPos)
+	{
+		// grow first so the food cannot land on the new tail
+		if (!GrowSnake(player, game->board, xTail, yTail))
+		{
+			game->isOver = true;
+			return events | GAME_EVENT_ERROR;
+		}
+		events |= GAME_EVENT_ATE;
+
+		// if there is no free cell left for the food, the snake fills the board and the game is won
+		if (!RandPosFood(&game->food, game->board, &game->random))
+		{
+			game->isOver = true;
+			events |= GAME_EVENT_WON;
+		}
+		else
+		{
+			game->changes[game->changeCount++] = (SnakeCell) {game->food.xPos, game->food.yPos};
+		}
+	}
+
+	return events;
+}
+
+bool CopyGame(Game *game, const Game *source)
+{
+	Board *board = game->board;
+	const Board *sourceBoard = source->board;
+	Snake *player = game->player;
+	const Snake *sourcePlayer = source->player;
+
+	// only a game on a board of the same size can take the copy
+	if (board->width != sourceBoard->width || board->height != sourceBoard->height || !ReserveSnake(player, sourcePlayer->length))
+	{
+		return false;
+	}
+
+	int cellCount = board->width * board->height;
+	memcpy(board->counts, sourceBoard->counts, (cellCount + 1) * sizeof(uint16_t));
+	memcpy(board->freeCells, sourceBoard->freeCells, cellCount * sizeof(int));
+	memcpy(board->freeSlots, sourceBoard->freeSlots, cellCount * sizeof(int));
+	board->freeCount = sourceBoard->freeCount;
+
+	// the body is copied unrolled with the head at index 0, keeping the copy's own ring buffer
+	SnakeCell *cells = player->cells;
+	int capacity = player->capacity;
+	int headSpan = sourcePlayer->capacity - sourcePlayer->headIndex;
+	int bodySpan = sourcePlayer->length < headSpan ? sourcePlayer->length : headSpan;
+	*player = *sourcePlayer;
+	player->cells = cells;
+	player->capacity = capacity;
+	player->headIndex = 0;
+	memcpy(cells, sourcePlayer->cells + sourcePlayer->headIndex, bodySpan * sizeof(SnakeCell));
+	memcpy(cells + bodySpan, sourcePlayer->cells, (sourcePlayer->length - bodySpan) * sizeof(SnakeCell));
+
+	game->food = source->food;
+	game->random = source->random;
+	game->tick = source->tick;
+	game->isOver = source->isOver;
+	memcpy(game->changes, source->changes, sizeof(game->changes));
+	game->changeCount = source->changeCount;
+
+	return true;
+}
+
+uint64_t HashGame(Game *game)
+{
+	// FNV-1a over the tick, the food and every body cell, so runs can be compared for identical results
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	Board *board = game->board;
+
+	hash = (hash ^ game->tick) * 0x100000001b3ULL;
+	hash = (hash ^ (uint64_t) game->isOver) * 0x100000001b3ULL;
+	hash = (hash ^ (uint64_t) (game->food.yPos * board->width + game->food.xPos)) * 0x100000001b3ULL;
+
+	for (int i = 0; i < game->player->length; ++i)
+	{
+		SnakeCell *cell = SnakeCellAt(game->player, i);
+		hash = (hash ^ (uint64_t) (cell->yPos * board->width + cell->xPos)) * 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+void DestroyGame(Game *game)
+{
+	DestroySnake(game->player);
+	DestroyBoard(game->board);
+	FreeMemory(game);
+}
@@ -0,0 +1,74 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "random.h"
+#include "snake.h"
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare GameEvent enum.
+ */
+
+// things that can happen during a tick, combined as bit flags
+typedef enum
+{
+	GAME_EVENT_NONE = 0,
+	GAME_EVENT_MOVED = 1 << 0,	// the player moved one cell
+	GAME_EVENT_ATE = 1 << 1,	// the player ate the food and grew
+	GAME_EVENT_DIED = 1 << 2,	// the player hit itself
+	GAME_EVENT_WON = 1 << 3,	// the player fills the board
+	GAME_EVENT_ERROR = 1 << 4	// the game could not continue, e.g. out of memory
+} GameEvent;
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare GameConfig, GameInput, Game structs.
+ */
+
+// everything needed to set up a new game
+typedef struct GameConfig
+{
+	int width, height;	// size of the board in cells
+	int xStart, yStart;	// starting cell of the player's head
+	int length;	// starting length of the player
+	SnakeDirection direction;	// starting direction of the player
+	uint64_t speed;	// milliseconds per move, used by frontends that run in real time
+	int nodeWidth, nodeHeight;	// size of each drawn SnakeCell
+	SnakeColor color;	// color of the player
+	uint64_t seed;	// seed of the game's random generator, the same seed and inputs replay the same game
+} GameConfig;
+
+// inputs applied at the start of a tick. a direction of 0 keeps the current heading
+typedef struct GameInput
+{
+	SnakeDirection direction;
+} GameInput;
+
+// most cells a single tick can change: the old tail, the new head and the new food cell
+#define GAME_MAX_CHANGES 4
+
+// complete state of one game, independent of any window or clock
+typedef struct Game
+{
+	Board *board;
+	Snake *player;
+	Food food;
+	Random random;	// places the food, seeded from the config
+	uint64_t tick;	// number of ticks stepped so far
+	bool isOver;
+	SnakeCell changes[GAME_MAX_CHANGES];	// cells whose contents changed on the last tick
+	int changeCount;
+} Game;
+
+Game *CreateGame(const GameConfig *config);
+GameEvent StepGame(Game *game, const GameInput *input);
+// copy the whole state of source into game, which must have a board of the same size. the copy
+// keeps its own board and body, so it can be read while source steps on
+bool CopyGame(Game *game, const Game *source);
+uint64_t HashGame(Game *game);
+void DestroyGame(Game *game);
+
+#endif
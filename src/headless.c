@@ -0,0 +1,917 @@
+/* ManySnakes headless driver
+ * Steps games back to back without a window, as fast as the CPU allows.
+ *
+ * usage: manysnakes_headless [ticks] [width] [height] [seed]
+ *        manysnakes_headless world [ticks] [width] [height] [snakes] [seed] [threads] [state]
+ *        manysnakes_headless resume <state> [ticks] [threads]
+ *        manysnakes_headless record <log> [ticks] [width] [height] [seed]
+ *        manysnakes_headless replay <log> [repeats]
+ *        manysnakes_headless autopilot [games] [width] [height] [seed] [greedy|safe|cycle] [budget us]
+ *        manysnakes_headless envs [games] [steps] [width] [height] [threads] [grid|features] [seed]
+ *        manysnakes_headless serve [port] [width] [height] [foods] [rate] [seconds] [seed]
+ *        manysnakes_headless bots [host] [port] [bots] [seconds]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "allocator.h"
+#include "autopilot.h"
+#include "client.h"
+#include "env.h"
+#include "game.h"
+#include "replay.h"
+#include "server.h"
+#include "state.h"
+#include "world.h"
+
+double GetSeconds(void);
+int RunGames(int argc, char **argv);
+int RunWorld(int argc, char **argv);
+int RunResume(int argc, char **argv);
+int RunRecord(int argc, char **argv);
+int RunReplay(int argc, char **argv);
+int RunAutopilot(int argc, char **argv);
+int RunEnvs(int argc, char **argv);
+int RunServe(int argc, char **argv);
+int RunBots(int argc, char **argv);
+SnakeDirection ChooseDirection(Game *game);
+SnakeDirection ChooseWorldDirection(World *world, int snake);
+void RunWorldTicks(World *world, long long ticks);
+uint64_t HashWorld(World *world);
+
+int main(int argc, char **argv)
+{
+	// the first argument picks between single player games and one multi-snake world
+	if (argc > 1 && strcmp(argv[1], "world") == 0)
+	{
+		return RunWorld(argc - 1, argv + 1);
+	}
+	else if (argc > 1 && strcmp(argv[1], "resume") == 0)
+	{
+		return RunResume(argc - 1, argv + 1);
+	}
+	else if (argc > 1 && strcmp(argv[1], "record") == 0)
+	{
+		return RunRecord(argc - 1, argv + 1);
+	}
+	else if (argc > 1 && strcmp(argv[1], "replay") == 0)
+	{
+		return RunReplay(argc - 1, argv + 1);
+	}
+	else if (argc > 1 && strcmp(argv[1], "autopilot") == 0)
+	{
+		return RunAutopilot(argc - 1, argv + 1);
+	}
+	else if (argc > 1 && strcmp(argv[1], "envs") == 0)
+	{
+		return RunEnvs(argc - 1, argv + 1);
+	}
+	else if (argc > 1 && strcmp(argv[1], "serve") == 0)
+	{
+		return RunServe(argc - 1, argv + 1);
+	}
+	else if (argc > 1 && strcmp(argv[1], "bots") == 0)
+	{
+		return RunBots(argc - 1, argv + 1);
+	}
+
+	return RunGames(argc, argv);
+}
+
+double GetSeconds(void)
+{
+	// wall clock time, so time spent on other threads is not counted twice
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int RunGames(int argc, char **argv)
+{
+	// read the run settings, falling back to the board Play uses
+	long long ticks = argc > 1 ? atoll(argv[1]) : 10000000;
+	int width = argc > 2 ? atoi(argv[2]) : 40;
+	int height = argc > 3 ? atoi(argv[3]) : 40;
+	unsigned seed = argc > 4 ? (unsigned) strtoul(argv[4], NULL, 10) : (unsigned) time(NULL);
+
+	if (ticks < 1 || width < 1 || height < 3)
+	{
+		fprintf(stderr, "usage: %s [ticks] [width] [height] [seed]\n", argv[0]);
+		return 1;
+	}
+
+	srand(seed);
+
+	GameConfig config = {width, height, width / 2, height / 2, 3, SNAKE_UP, 0, 1, 1, {0x00, 0x00, 0xA0, 0xFF}, seed};
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Step games until the tick budget is spent, starting a new game whenever one ends.
+	 */
+
+	long long games = 0, foods = 0, longest = 0;
+	double start = GetSeconds();
+
+	Game *game = NULL;
+	for (long long tick = 0; tick < ticks; ++tick)
+	{
+		if (!game || game->isOver)
+		{
+			if (game)
+			{
+				longest = game->player->length > longest ? game->player->length : longest;
+				DestroyGame(game);
+			}
+
+			// every game gets its own seed, following on from the run's seed
+			config.seed = seed + games;
+			game = CreateGame(&config);
+			if (!game)
+			{
+				fprintf(stderr, "Failed to create game.\n");
+				return 1;
+			}
+			++games;
+		}
+
+		GameInput input = {ChooseDirection(game)};
+		GameEvent events = StepGame(game, &input);
+
+		if (events & GAME_EVENT_ERROR)
+		{
+			fprintf(stderr, "Game stopped on tick %llu.\n", (unsigned long long) game->tick);
+			DestroyGame(game);
+			return 1;
+		}
+
+		if (events & GAME_EVENT_ATE)
+		{
+			++foods;
+		}
+	}
+
+	double seconds = GetSeconds() - start;
+
+	if (game->player->length > longest)
+	{
+		longest = game->player->length;
+	}
+	DestroyGame(game);
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Print the results.
+	 */
+
+	printf("board %dx%d, seed %u\n", width, height, seed);
+	printf("%lld ticks in %.3f s (%.0f ticks/s)\n", ticks, seconds, seconds > 0 ? ticks / seconds : 0.0);
+	printf("%lld games, %lld foods eaten, longest snake %lld\n", games, foods, longest);
+
+	return 0;
+}
+
+int RunWorld(int argc, char **argv)
+{
+	// read the run settings
+	long long ticks = argc > 1 ? atoll(argv[1]) : 10000;
+	int width = argc > 2 ? atoi(argv[2]) : 1000;
+	int height = argc > 3 ? atoi(argv[3]) : 1000;
+	int snakes = argc > 4 ? atoi(argv[4]) : 10000;
+	unsigned seed = argc > 5 ? (unsigned) strtoul(argv[5], NULL, 10) : (unsigned) time(NULL);
+	int threads = argc > 6 ? atoi(argv[6]) : 1;
+	const char *statePath = argc > 7 ? argv[7] : NULL;
+
+	if (ticks < 1 || width < 1 || height < 1 || snakes < 1 || threads < 1)
+	{
+		fprintf(stderr, "usage: %s world [ticks] [width] [height] [snakes] [seed] [threads] [state]\n", argv[0]);
+		return 1;
+	}
+
+	srand(seed);
+
+	// one food for every other snake keeps the arena busy
+	World *world = CreateWorld(width, height, snakes / 2 + 1, seed);
+	if (!world || !SetWorldThreads(world, threads))
+	{
+		fprintf(stderr, "Failed to create world.\n");
+		return 1;
+	}
+
+	// drop every snake on a random free cell
+	for (int snake = 0; snake < snakes; ++snake)
+	{
+		int x, y;
+		SnakeColor color = {rand() % 256, rand() % 256, rand() % 256, 0xFF};
+		if (!RandFreeWorldCell(world, &x, &y) || AddWorldSnake(world, x, y, 3, SNAKE_UP, 1, &color) < 0)
+		{
+			fprintf(stderr, "Failed to add snake %d.\n", snake);
+			DestroyWorld(world);
+			return 1;
+		}
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Step the world, then save it if asked to.
+	 */
+
+	printf("world %dx%d with %d snakes, seed %u, %d threads\n", width, height, snakes, seed, threads);
+	RunWorldTicks(world, ticks);
+
+	bool isSaved = true;
+	if (statePath)
+	{
+		double saveStart = GetSeconds();
+		isSaved = SaveWorldState(world, statePath);
+		printf(isSaved ? "saved %s in %.3f ms\n" : "Failed to save %s.\n", statePath, (GetSeconds() - saveStart) * 1000);
+	}
+
+	DestroyWorld(world);
+
+	return isSaved ? 0 : 1;
+}
+
+int RunResume(int argc, char **argv)
+{
+	// read the run settings
+	const char *path = argc > 1 ? argv[1] : NULL;
+	long long ticks = argc > 2 ? atoll(argv[2]) : 10000;
+	int threads = argc > 3 ? atoi(argv[3]) : 1;
+
+	if (!path || ticks < 0 || threads < 1)
+	{
+		fprintf(stderr, "usage: %s resume <state> [ticks] [threads]\n", argv[0]);
+		return 1;
+	}
+
+	double loadStart = GetSeconds();
+	World *world = LoadWorldState(path);
+	double loadSeconds = GetSeconds() - loadStart;
+	if (!world || !SetWorldThreads(world, threads))
+	{
+		fprintf(stderr, "Failed to load world state %s.\n", path);
+		if (world)
+			DestroyWorld(world);
+		return 1;
+	}
+
+	long long cells = 0;
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		cells += world->length[snake];
+	}
+
+	// carry on from where the saved run stopped
+	printf("world %dx%d with %d snakes and %lld body cells at tick %llu, loaded in %.3f ms, %d threads\n",
+			world->width, world->height, world->snakeCount, cells, (unsigned long long) world->tick, loadSeconds * 1000, threads);
+	RunWorldTicks(world, ticks);
+
+	DestroyWorld(world);
+
+	return 0;
+}
+
+void RunWorldTicks(World *world, long long ticks)
+{
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Step the world, steering every snake and respawning the dead ones.
+	 */
+
+	long long deaths = 0, foods = 0, moves = 0;
+	double stepSeconds = 0;
+	double start = GetSeconds();
+
+	for (long long tick = 0; tick < ticks; ++tick)
+	{
+		for (int snake = 0; snake < world->snakeCount; ++snake)
+		{
+			if (world->isAlive[snake])
+			{
+				SteerWorldSnake(world, snake, ChooseWorldDirection(world, snake));
+			}
+			else
+			{
+				int x, y;
+				if (RandFreeWorldCell(world, &x, &y))
+				{
+					SpawnWorldSnake(world, snake, x, y, 3, SNAKE_UP);
+				}
+			}
+		}
+
+		double stepStart = GetSeconds();
+		deaths += StepWorld(world);
+		stepSeconds += GetSeconds() - stepStart;
+
+		for (int snake = 0; snake < world->snakeCount; ++snake)
+		{
+			moves += (world->events[snake] & GAME_EVENT_MOVED) != 0;
+			foods += (world->events[snake] & GAME_EVENT_ATE) != 0;
+		}
+	}
+
+	double seconds = GetSeconds() - start;
+
+	long long cells = 0;
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		cells += world->length[snake];
+	}
+
+	printf("%lld ticks in %.3f s (%.0f ticks/s, %.0f snake moves/s)\n", ticks, seconds, seconds > 0 ? ticks / seconds : 0.0, seconds > 0 ? moves / seconds : 0.0);
+	printf("StepWorld took %.3f s (%.0f snake moves/s)\n", stepSeconds, stepSeconds > 0 ? moves / stepSeconds : 0.0);
+	printf("%lld deaths, %lld foods eaten, %lld body cells at the end\n", deaths, foods, cells);
+	printf("world hash %016llx\n", (unsigned long long) HashWorld(world));
+}
+
+int RunRecord(int argc, char **argv)
+{
+	// read the run settings, falling back to the board Play uses
+	const char *path = argc > 1 ? argv[1] : NULL;
+	long long ticks = argc > 2 ? atoll(argv[2]) : 100000;
+	int width = argc > 3 ? atoi(argv[3]) : 40;
+	int height = argc > 4 ? atoi(argv[4]) : 40;
+	uint64_t seed = argc > 5 ? strtoull(argv[5], NULL, 10) : (uint64_t) time(NULL);
+
+	if (!path || ticks < 1 || width < 1 || height < 3)
+	{
+		fprintf(stderr, "usage: %s record <log> [ticks] [width] [height] [seed]\n", argv[0]);
+		return 1;
+	}
+
+	srand((unsigned) seed);
+
+	GameConfig config = {width, height, width / 2, height / 2, 3, SNAKE_UP, 0, 1, 1, {0x00, 0x00, 0xA0, 0xFF}, seed};
+	Game *game = CreateGame(&config);
+	Replay *replay = CreateReplay(&config);
+	if (!game || !replay)
+	{
+		fprintf(stderr, "Failed to create game.\n");
+		if (replay)
+			DestroyReplay(replay);
+		if (game)
+			DestroyGame(game);
+		return 1;
+	}
+
+	// let the bot play one game until it ends or the tick budget is spent, logging what it turns
+	while (!game->isOver && (long long) game->tick < ticks)
+	{
+		GameInput input = {ChooseDirection(game)};
+		if (input.direction == game->player->currentDirection)
+		{
+			input.direction = 0;
+		}
+
+		if (!RecordReplay(replay, game->tick, &input) || StepGame(game, &input) & GAME_EVENT_ERROR)
+		{
+			fprintf(stderr, "Game stopped on tick %llu.\n", (unsigned long long) game->tick);
+			DestroyReplay(replay);
+			DestroyGame(game);
+			return 1;
+		}
+	}
+
+	FinishReplay(replay, game);
+	if (!SaveReplay(replay, path))
+	{
+		fprintf(stderr, "Failed to save %s.\n", path);
+		DestroyReplay(replay);
+		DestroyGame(game);
+		return 1;
+	}
+
+	printf("recorded %llu ticks, %d inputs, length %d, game hash %016llx\n", (unsigned long long) replay->tickCount,
+			replay->inputCount, game->player->length, (unsigned long long) replay->finalHash);
+
+	DestroyReplay(replay);
+	DestroyGame(game);
+
+	return 0;
+}
+
+int RunReplay(int argc, char **argv)
+{
+	const char *path = argc > 1 ? argv[1] : NULL;
+	long long repeats = argc > 2 ? atoll(argv[2]) : 1;
+
+	if (!path || repeats < 1)
+	{
+		fprintf(stderr, "usage: %s replay <log> [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	Replay *replay = LoadReplay(path);
+	if (!replay)
+	{
+		fprintf(stderr, "Failed to load %s.\n", path);
+		return 1;
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Step the logged game as fast as possible, as many times as asked, checking every run ends the same.
+	 */
+
+	uint64_t hash = 0;
+	int length = 0;
+	double start = GetSeconds();
+	for (long long repeat = 0; repeat < repeats; ++repeat)
+	{
+		Game *game = CreateGame(&replay->config);
+		if (!game)
+		{
+			fprintf(stderr, "Failed to create game.\n");
+			DestroyReplay(replay);
+			return 1;
+		}
+
+		int cursor = 0;
+		while (game->tick < replay->tickCount && !game->isOver)
+		{
+			GameInput input;
+			InputReplay(replay, &cursor, game->tick, &input);
+			StepGame(game, &input);
+		}
+
+		hash = HashGame(game);
+		length = game->player->length;
+		DestroyGame(game);
+
+		if (hash != replay->finalHash)
+		{
+			break;
+		}
+	}
+	double seconds = GetSeconds() - start;
+
+	// real time is the ticks at the game's own speed, or Play's speed if it has none
+	double ticks = (double) replay->tickCount * repeats;
+	double realSeconds = ticks * (replay->config.speed ? replay->config.speed : 125) / 1000.0;
+	printf("replayed %llu ticks x %lld in %.3f s (%.0f ticks/s, %.0fx real time)\n", (unsigned long long) replay->tickCount,
+			repeats, seconds, seconds > 0 ? ticks / seconds : 0.0, seconds > 0 ? realSeconds / seconds : 0.0);
+	printf("length %d, game hash %016llx, logged %016llx\n", length, (unsigned long long) hash, (unsigned long long) replay->finalHash);
+
+	bool isMatch = hash == replay->finalHash;
+	DestroyReplay(replay);
+	if (!isMatch)
+	{
+		fprintf(stderr, "Replay diverged from the log.\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+int RunAutopilot(int argc, char **argv)
+{
+	// read the run settings, falling back to the board Play uses
+	long long gameCount = argc > 1 ? atoll(argv[1]) : 10;
+	int width = argc > 2 ? atoi(argv[2]) : 40;
+	int height = argc > 3 ? atoi(argv[3]) : 40;
+	uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 10) : (uint64_t) time(NULL);
+	const char *strategyName = argc > 5 ? argv[5] : "safe";
+	int budgetMicros = argc > 6 ? atoi(argv[6]) : AUTOPILOT_FRAME_MICROS;
+
+	AutopilotStrategy strategy = strcmp(strategyName, "greedy") == 0 ? AUTOPILOT_GREEDY : strcmp(strategyName, "cycle") == 0 ? AUTOPILOT_CYCLE : AUTOPILOT_SAFE;
+	if (gameCount < 1 || width < 2 || height < 3 || budgetMicros < 1 || (strategy == AUTOPILOT_SAFE && strcmp(strategyName, "safe") != 0))
+	{
+		fprintf(stderr, "usage: %s autopilot [games] [width] [height] [seed] [greedy|safe|cycle] [budget us]\n", argv[0]);
+		return 1;
+	}
+
+	Autopilot *autopilot = CreateAutopilot(width, height, strategy, budgetMicros);
+	if (!autopilot)
+	{
+		fprintf(stderr, "Failed to create autopilot.\n");
+		return 1;
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Play every game to its end, timing each decision. A game that goes on for far longer than
+	 * filling the board by the cycle takes is called a stall.
+	 */
+
+	long long wins = 0, stalls = 0, lengths = 0, totalTicks = 0;
+	double decisionSeconds = 0, slowestDecision = 0;
+	long long tickLimit = 4LL * width * height * width * height;
+	double start = GetSeconds();
+
+	for (long long i = 0; i < gameCount; ++i)
+	{
+		GameConfig config = {width, height, width / 2, height / 2, 3, SNAKE_UP, 0, 1, 1, {0x00, 0x00, 0xA0, 0xFF}, seed + i};
+		Game *game = CreateGame(&config);
+		if (!game)
+		{
+			fprintf(stderr, "Failed to create game.\n");
+			DestroyAutopilot(autopilot);
+			return 1;
+		}
+
+		GameEvent events = GAME_EVENT_NONE;
+		while (!game->isOver && (long long) game->tick < tickLimit)
+		{
+			double decisionStart = GetSeconds();
+			SteerAutopilot(autopilot, game->player, game->board, &game->food);
+			double decision = GetSeconds() - decisionStart;
+			decisionSeconds += decision;
+			slowestDecision = decision > slowestDecision ? decision : slowestDecision;
+
+			events = StepGame(game, NULL);
+		}
+
+		wins += (events & GAME_EVENT_WON) != 0;
+		stalls += !game->isOver;
+		lengths += game->player->length;
+		totalTicks += game->tick;
+		DestroyGame(game);
+	}
+
+	double seconds = GetSeconds() - start;
+	DestroyAutopilot(autopilot);
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Print the results.
+	 */
+
+	printf("board %dx%d, seed %llu, %s autopilot, budget %d us\n", width, height, (unsigned long long) seed, strategyName, budgetMicros);
+	printf("%lld games in %.3f s, %lld won, %lld stalled, average length %.1f of %d\n", gameCount, seconds, wins, stalls,
+			(double) lengths / gameCount, width * height);
+	printf("%lld decisions, %.2f us average, %.2f us slowest\n", totalTicks, totalTicks ? decisionSeconds * 1e6 / totalTicks : 0.0,
+			slowestDecision * 1e6);
+
+	return 0;
+}
+
+int RunEnvs(int argc, char **argv)
+{
+	// read the run settings, falling back to the board Play uses
+	int gameCount = argc > 1 ? atoi(argv[1]) : 4096;
+	long long steps = argc > 2 ? atoll(argv[2]) : 1000;
+	int width = argc > 3 ? atoi(argv[3]) : 40;
+	int height = argc > 4 ? atoi(argv[4]) : 40;
+	int threadCount = argc > 5 ? atoi(argv[5]) : 1;
+	const char *observationName = argc > 6 ? argv[6] : "features";
+	uint64_t seed = argc > 7 ? strtoull(argv[7], NULL, 10) : (uint64_t) time(NULL);
+
+	EnvObservation observation = strcmp(observationName, "grid") == 0 ? ENV_OBSERVE_GRID : strcmp(observationName, "features") == 0 ? ENV_OBSERVE_FEATURES : 0;
+	if (gameCount < 1 || steps < 1 || width < 2 || height < 3 || threadCount < 1 || !observation)
+	{
+		fprintf(stderr, "usage: %s envs [games] [steps] [width] [height] [threads] [grid|features] [seed]\n", argv[0]);
+		return 1;
+	}
+
+	// a round that goes a whole board without eating is cut short, so wandering agents keep resetting
+	GameConfig config = {width, height, width / 2, height / 2, 3, SNAKE_UP, 0, 1, 1, {0x00, 0x00, 0xA0, 0xFF}, seed};
+	EnvBatch *batch = CreateEnvBatch(&config, gameCount, observation, width * height, threadCount);
+	uint8_t *actions = AllocMemory((size_t) gameCount);
+	float *observations = AllocMemory((size_t) gameCount * (batch ? batch->observationSize : 0) * sizeof(float));
+	float *rewards = AllocMemory((size_t) gameCount * sizeof(float));
+	uint8_t *dones = AllocMemory((size_t) gameCount);
+	if (!batch || !actions || !observations || !rewards || !dones)
+	{
+		fprintf(stderr, "Failed to create %d games.\n", gameCount);
+		FreeMemory(dones);
+		FreeMemory(rewards);
+		FreeMemory(observations);
+		FreeMemory(actions);
+		if (batch)
+			DestroyEnvBatch(batch);
+		return 1;
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Step every game with random actions, drawn outside the timing like an agent's would be, and
+	 * hash the rewards and done flags, which come out the same for any number of threads.
+	 */
+
+	Random random;
+	SeedRandom(&random, seed);
+	double stepSeconds = 0, rewardTotal = 0;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	ResetEnvBatch(batch, observations);
+
+	for (long long step = 0; step < steps; ++step)
+	{
+		for (int i = 0; i < gameCount; ++i)
+		{
+			actions[i] = (uint8_t) RangeRandom(&random, ENV_DOWN + 1);
+		}
+
+		double stepStart = GetSeconds();
+		StepEnvBatch(batch, actions, observations, rewards, dones);
+		stepSeconds += GetSeconds() - stepStart;
+
+		for (int i = 0; i < gameCount; ++i)
+		{
+			rewardTotal += rewards[i];
+			hash = (hash ^ (uint64_t) (rewards[i] + 1) ^ (uint64_t) dones[i] << 2) * 0x100000001b3ULL;
+		}
+	}
+
+	for (int i = 0; i < gameCount; ++i)
+	{
+		hash = (hash ^ HashGame(batch->games[i])) * 0x100000001b3ULL;
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Print the results.
+	 */
+
+	long long gameSteps = (long long) gameCount * steps;
+	printf("%d games on %dx%d boards, %s observations of %d values, %d threads, seed %llu\n", gameCount, width, height,
+			observationName, batch->observationSize, threadCount, (unsigned long long) seed);
+	printf("%lld game steps in %.3f s, %.0f steps/s, %.2f ns per game step\n", gameSteps, stepSeconds, gameSteps / stepSeconds, stepSeconds * 1e9 / gameSteps);
+	printf("%llu rounds finished, total reward %.0f\n", (unsigned long long) batch->episodes, rewardTotal);
+	printf("hash %016llx\n", (unsigned long long) hash);
+
+	FreeMemory(dones);
+	FreeMemory(rewards);
+	FreeMemory(observations);
+	FreeMemory(actions);
+	DestroyEnvBatch(batch);
+
+	return 0;
+}
+
+int RunServe(int argc, char **argv)
+{
+	// read the server settings
+	int port = argc > 1 ? atoi(argv[1]) : NET_DEFAULT_PORT;
+	int width = argc > 2 ? atoi(argv[2]) : 200;
+	int height = argc > 3 ? atoi(argv[3]) : 200;
+	int foodCount = argc > 4 ? atoi(argv[4]) : 100;
+	int rate = argc > 5 ? atoi(argv[5]) : 8;
+	double seconds = argc > 6 ? atof(argv[6]) : 0;
+	uint64_t seed = argc > 7 ? strtoull(argv[7], NULL, 10) : (uint64_t) time(NULL);
+
+	if (port < 0 || width < 1 || height < 1 || foodCount < 0 || rate < 1 || seconds < 0)
+	{
+		fprintf(stderr, "usage: %s serve [port] [width] [height] [foods] [rate] [seconds] [seed]\n", argv[0]);
+		return 1;
+	}
+
+	Server *server = CreateServer(port, width, height, foodCount, rate, seed);
+	if (!server)
+	{
+		fprintf(stderr, "Failed to start server on port %d.\n", port);
+		return 1;
+	}
+
+	printf("serving a %dx%d world on port %d at %d ticks/s\n", width, height, port, rate);
+	fflush(stdout);
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Handle packets as they arrive and step on the tick, reporting the traffic every second.
+	 */
+
+	double tickSeconds = 1.0 / rate;
+	double next = GetSeconds(), end = seconds > 0 ? next + seconds : 0, report = next + 1;
+	uint64_t reportDeltaBytes = 0, reportFullBytes = 0;
+	int returnCode = 0;
+
+	while (end == 0 || GetSeconds() < end)
+	{
+		// sleep until the next tick unless a packet comes first
+		double wait = next - GetSeconds();
+		if (wait > 0)
+		{
+			WaitNetSocket(server->socket, (int) (wait * 1000 + 0.999));
+		}
+		PollServer(server);
+
+		double now = GetSeconds();
+		if (now >= next)
+		{
+			if (!StepServer(server))
+			{
+				fprintf(stderr, "Failed to step server.\n");
+				returnCode = 1;
+				break;
+			}
+
+			// a server that fell far behind carries on from now, instead of catching up in a burst
+			next = now - next > 0.25 ? now + tickSeconds : next + tickSeconds;
+		}
+
+		if (now >= report)
+		{
+			int clients = CountServerClients(server), alive = 0;
+			for (int snake = 0; snake < server->world->snakeCount; ++snake)
+			{
+				alive += server->world->isAlive[snake];
+			}
+
+			double deltaRate = (server->deltaBytes - reportDeltaBytes) / 1024.0 / (clients > 0 ? clients : 1);
+			printf("tick %llu, %d clients, %d snakes in %d slots, %.2f kB/s of deltas per client, %.2f kB/s of full snapshots\n",
+					(unsigned long long) server->world->tick, clients, alive, server->world->snakeCount, deltaRate, (server->fullBytes - reportFullBytes) / 1024.0);
+			fflush(stdout);
+
+			reportDeltaBytes = server->deltaBytes;
+			reportFullBytes = server->fullBytes;
+			report = now + 1;
+		}
+	}
+
+	DestroyServer(server);
+
+	return returnCode;
+}
+
+int RunBots(int argc, char **argv)
+{
+	// read the client settings
+	const char *host = argc > 1 ? argv[1] : "127.0.0.1";
+	int port = argc > 2 ? atoi(argv[2]) : NET_DEFAULT_PORT;
+	int bots = argc > 3 ? atoi(argv[3]) : 100;
+	double seconds = argc > 4 ? atof(argv[4]) : 10;
+
+	if (port < 1 || bots < 1 || seconds <= 0)
+	{
+		fprintf(stderr, "usage: %s bots [host] [port] [bots] [seconds]\n", argv[0]);
+		return 1;
+	}
+
+	NetClient *client = CreateNetClient(host, port, bots);
+	if (!client)
+	{
+		fprintf(stderr, "Failed to reach %s:%d.\n", host, port);
+		return 1;
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Steer every bot from the mirror each time a tick comes in, like a player watching the screen.
+	 */
+
+	double start = GetSeconds(), end = start + seconds, nextFlush = start;
+	int returnCode = 0;
+
+	while (GetSeconds() < end)
+	{
+		WaitNetSocket(client->socket, 10);
+		int applied = PollNetClient(client);
+		if (applied < 0)
+		{
+			fprintf(stderr, "Failed to apply a snapshot.\n");
+			returnCode = 1;
+			break;
+		}
+
+		// turns go out as soon as a tick is in. between ticks, a few inputs a second keep the
+		// client known to the server, and ask again to join or for the whole world if needed
+		World *mirror = client->mirror;
+		double now = GetSeconds();
+		if (applied > 0 && client->isSynced)
+		{
+			for (int own = 0; own < client->snakeCount; ++own)
+			{
+				int snake = client->firstSnake + own;
+				if (snake < mirror->snakeCount && mirror->isAlive[snake])
+				{
+					SteerNetClient(client, own, ChooseWorldDirection(mirror, snake));
+				}
+			}
+		}
+
+		if (applied > 0 || now >= nextFlush)
+		{
+			FlushNetClient(client);
+			nextFlush = now + 0.2;
+		}
+	}
+
+	double elapsed = GetSeconds() - start;
+	printf("%d bots on %s:%d for %.1f s\n", client->snakeCount, host, port, elapsed);
+	printf("%llu deltas and %llu full snapshots applied, last tick %u\n", (unsigned long long) client->deltasApplied, (unsigned long long) client->fullsApplied, client->appliedTick);
+	printf("%.2f kB/s in, %.2f kB/s out\n", client->socket->bytesReceived / 1024.0 / elapsed, client->socket->bytesSent / 1024.0 / elapsed);
+
+	DestroyNetClient(client);
+
+	return returnCode;
+}
+
+SnakeDirection ChooseDirection(Game *game)
+{
+	// a simple bot: head for the food along whichever axis is off, but never into a taken cell
+	Snake *player = game->player;
+	Board *board = game->board;
+	SnakeCell *head = SnakeHead(player);
+
+	SnakeDirection wanted[4];
+	int count = 0;
+
+	if (game->food.xPos > head->xPos)
+		wanted[count++] = SNAKE_RIGHT;
+	else if (game->food.xPos < head->xPos)
+		wanted[count++] = SNAKE_LEFT;
+
+	if (game->food.yPos > head->yPos)
+		wanted[count++] = SNAKE_DOWN;
+	else if (game->food.yPos < head->yPos)
+		wanted[count++] = SNAKE_UP;
+
+	// after the food directions, fall back to the others in a random order
+	SnakeDirection all[4] = {SNAKE_RIGHT, SNAKE_UP, SNAKE_LEFT, SNAKE_DOWN};
+	int offset = rand() % 4;
+	for (int i = 0; i < 4 && count < 4; ++i)
+	{
+		SnakeDirection direction = all[(offset + i) % 4];
+		bool isWanted = false;
+		for (int j = 0; j < count; ++j)
+		{
+			isWanted = isWanted || wanted[j] == direction;
+		}
+
+		if (!isWanted)
+		{
+			wanted[count++] = direction;
+		}
+	}
+
+	for (int i = 0; i < count; ++i)
+	{
+		int x = head->xPos, y = head->yPos;
+		switch (wanted[i])
+		{
+			case SNAKE_RIGHT: x = (x + 1) % board->width; break;
+			case SNAKE_LEFT: x = (x + board->width - 1) % board->width; break;
+			case SNAKE_DOWN: y = (y + 1) % board->height; break;
+			case SNAKE_UP: y = (y + board->height - 1) % board->height; break;
+		}
+
+		if (IsFreeBoardCell(board, x, y))
+		{
+			return wanted[i];
+		}
+	}
+
+	return 0;
+}
+
+SnakeDirection ChooseWorldDirection(World *world, int snake)
+{
+	// keep going unless the next cell is taken or a random turn comes up, then take any free cell
+	SnakeDirection all[4] = {SNAKE_RIGHT, SNAKE_UP, SNAKE_LEFT, SNAKE_DOWN};
+	SnakeDirection current = world->direction[snake];
+	int offset = rand() % 8;
+
+	for (int i = 0; i < 5; ++i)
+	{
+		SnakeDirection direction = i == 0 ? current : all[(offset + i) % 4];
+		if (i == 0 && offset >= 4)
+			continue;
+
+		int x = world->headX[snake], y = world->headY[snake];
+		switch (direction)
+		{
+			case SNAKE_RIGHT: x = (x + 1) % world->width; break;
+			case SNAKE_LEFT: x = (x + world->width - 1) % world->width; break;
+			case SNAKE_DOWN: y = (y + 1) % world->height; break;
+			case SNAKE_UP: y = (y + world->height - 1) % world->height; break;
+		}
+
+		if (IsFreeWorldCell(world, x, y))
+		{
+			return direction;
+		}
+	}
+
+	return current;
+}
+
+uint64_t HashWorld(World *world)
+{
+	// FNV-1a over the board, every body and the food, so runs can be compared for identical results.
+	// a sparse board is only hashed through the bodies, since its tiles follow from them
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	Board *board = world->board;
+
+	for (int cell = 0; board && cell < board->width * board->height; ++cell)
+	{
+		hash = (hash ^ board->counts[cell]) * 0x100000001b3ULL;
+	}
+
+	for (int i = 0; board && i < board->freeCount; ++i)
+	{
+		hash = (hash ^ (uint64_t) board->freeCells[i]) * 0x100000001b3ULL;
+	}
+
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		for (int i = 0; i < world->length[snake]; ++i)
+		{
+			SnakeCell *cell = WorldSnakeCellAt(world, snake, i);
+			hash = (hash ^ (uint64_t) ((int64_t) cell->yPos * world->width + cell->xPos)) * 0x100000001b3ULL;
+		}
+	}
+
+	for (int food = 0; food < world->foodCount; ++food)
+	{
+		hash = (hash ^ (uint64_t) ((int64_t) world->foods[food].yPos * world->width + world->foods[food].xPos)) * 0x100000001b3ULL;
+	}
+
+	return hash;
+}
@@ -0,0 +1,64 @@
+#include "input.h"
+
+
+static bool IsReverseInput(SnakeDirection a, SnakeDirection b);
+
+void InitInputQueue(InputQueue *queue, int depth)
+{
+	queue->head = queue->count = 0;
+	queue->depth = depth < 1 ? 1 : depth > INPUT_QUEUE_CAPACITY ? INPUT_QUEUE_CAPACITY : depth;
+	queue->dropped = 0;
+}
+
+bool PushInputQueue(InputQueue *queue, SnakeDirection heading, SnakeDirection direction, uint64_t time)
+{
+	// the snake will be heading the way of the last turn waiting, or the given heading if there is none
+	if (queue->count > 0)
+	{
+		heading = queue->directions[(queue->head + queue->count - 1) % INPUT_QUEUE_CAPACITY];
+	}
+
+	// a turn that keeps that heading or reverses it would do nothing, so it does not take a move
+	if (direction == heading || IsReverseInput(direction, heading))
+	{
+		return false;
+	}
+
+	// a full queue keeps the turns it has, they were asked for first
+	if (queue->count >= queue->depth)
+	{
+		++queue->dropped;
+		return false;
+	}
+
+	int slot = (queue->head + queue->count++) % INPUT_QUEUE_CAPACITY;
+	queue->directions[slot] = direction;
+	queue->times[slot] = time;
+
+	return true;
+}
+
+bool PopInputQueue(InputQueue *queue, SnakeDirection *direction, uint64_t *time)
+{
+	if (queue->count == 0)
+	{
+		return false;
+	}
+
+	*direction = queue->directions[queue->head];
+	*time = queue->times[queue->head];
+	queue->head = (queue->head + 1) % INPUT_QUEUE_CAPACITY;
+	--queue->count;
+
+	return true;
+}
+
+void ClearInputQueue(InputQueue *queue)
+{
+	queue->head = queue->count = 0;
+}
+
+static bool IsReverseInput(SnakeDirection a, SnakeDirection b)
+{
+	return (a == SNAKE_LEFT && b == SNAKE_RIGHT) || (a == SNAKE_RIGHT && b == SNAKE_LEFT) || (a == SNAKE_UP && b == SNAKE_DOWN) || (a == SNAKE_DOWN && b == SNAKE_UP);
+}
@@ -0,0 +1,36 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "snake.h"
+
+
+// most turns an InputQueue can hold, whatever depth it is given
+#define INPUT_QUEUE_CAPACITY 8
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare InputQueue struct.
+ */
+
+// turns of one snake waiting for their ticks, oldest first, each with the time its key went down.
+// a snake takes one turn per move, so two quick turns inside one tick are both kept and play out on
+// the next two moves instead of the second one replacing the first. a turn is checked against
+// the heading the snake will have once the turns before it are taken, not the current one, so
+// e.g. left then down while going up is a legal pair
+typedef struct InputQueue
+{
+	SnakeDirection directions[INPUT_QUEUE_CAPACITY];	// a ring
+	uint64_t times[INPUT_QUEUE_CAPACITY];	// when each turn was asked for, in milliseconds
+	int head, count;
+	int depth;	// most turns kept waiting, the rest are dropped
+	uint64_t dropped;	// turns dropped because the queue was full
+} InputQueue;
+
+void InitInputQueue(InputQueue *queue, int depth);
+bool PushInputQueue(InputQueue *queue, SnakeDirection heading, SnakeDirection direction, uint64_t time);
+bool PopInputQueue(InputQueue *queue, SnakeDirection *direction, uint64_t *time);
+void ClearInputQueue(InputQueue *queue);
+
+#endif
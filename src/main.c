@@ -6,20 +6,33 @@
 #include "math.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
+#include "asset.h"
+#include "autopilot.h"
+#include "client.h"
+#include "game.h"
+#include "pacer.h"
+#include "profiler.h"
+#include "replay.h"
+#include "render.h"
+#include "simulation.h"
 #include "snake.h"
+#include "state.h"
 #include "texture.h"
 
 void PrintGameInfo();
 void PrintError();
-int MainMenu(SDL_Window *window, SDL_Renderer *renderer);
-int Play(SDL_Window *window, SDL_Renderer *renderer);
-int Pause(SDL_Window *window, SDL_Renderer *renderer, SDL_Texture *buffer);
+int MainMenu(SDL_Window *window, SDL_Renderer *renderer, AssetCache *assets);
+int Play(SDL_Window *window, SDL_Renderer *renderer, AssetCache *assets, const char *statePath);
+int Pause(SDL_Window *window, SDL_Renderer *renderer, SDL_Texture *buffer, Game *game, const GameConfig *config);
+int WatchReplay(SDL_Window *window, SDL_Renderer *renderer, AssetCache *assets, Replay *replay, double speed);
+int WatchServer(SDL_Window *window, SDL_Renderer *renderer, AssetCache *assets, const char *host, int port);
 
-int main(void)
+int main(int argc, char **argv)
 {
 	// print the game's credits and versions
 	PrintGameInfo();
@@ -66,7 +79,7 @@ int main(void)
 	}
 
 	// create renderer
-	SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+	SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | (ManySnakes_VSYNC ? SDL_RENDERER_PRESENTVSYNC : 0));
 	// if renderer doesn't exist, print error, destroy window and return
 	if (!renderer || SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND) != 0)
 	{
@@ -76,20 +89,61 @@ int main(void)
 	}
 
 
+	// create the cache that loads each texture and font once for every screen
+	AssetCache *assets = CreateAssetCache(renderer);
+	if (!assets)
+	{
+		PrintError();
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+		return 1;
+	}
+
+
 	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-	 * Seed rand and begin main loop.
+	 * Watch a replay, resume a saved game or join a server if asked to, otherwise begin main loop.
 	 */
 
-	// seed rand
-	srand(SDL_GetTicks());
-
-	int returnCode = MainMenu(window, renderer);	
-	printf("Exit MainMenu: %d\n", returnCode);
+	int returnCode;
+	if (argc > 2 && strcmp(argv[1], "--replay") == 0)
+	{
+		// usage: ManySnakes --replay <log> [speed]
+		Replay *replay = LoadReplay(argv[2]);
+		if (replay)
+		{
+			returnCode = WatchReplay(window, renderer, assets, replay, argc > 3 ? atof(argv[3]) : 1.0);
+			printf("Exit WatchReplay: %d\n", returnCode);
+			DestroyReplay(replay);
+		}
+		else
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load replay %s.", argv[2]);
+			returnCode = 1;
+		}
+	}
+	else if (argc > 2 && strcmp(argv[1], "--resume") == 0)
+	{
+		// usage: ManySnakes --resume <state>
+		returnCode = Play(window, renderer, assets, argv[2]);
+		printf("Exit Play: %d\n", returnCode);
+	}
+	else if (argc > 2 && strcmp(argv[1], "--connect") == 0)
+	{
+		// usage: ManySnakes --connect <host> [port]
+		returnCode = WatchServer(window, renderer, assets, argv[2], argc > 3 ? atoi(argv[3]) : NET_DEFAULT_PORT);
+		printf("Exit WatchServer: %d\n", returnCode);
+	}
+	else
+	{
+		returnCode = MainMenu(window, renderer, assets);	
+		printf("Exit MainMenu: %d\n", returnCode);
+	}
 
 	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-	 * Destroy renderer and window, quit IMG and SDL, then return.
+	 * Destroy assets, renderer and window, quit IMG and SDL, then return.
 	 */
 
+	DestroyAssetCache(assets);
 	SDL_DestroyRenderer(renderer);
 	SDL_DestroyWindow(window);
 
@@ -153,7 +207,7 @@ void PrintError()
 	SDL_ClearError();
 }
 
-int MainMenu(SDL_Window *window, SDL_Renderer *renderer)
+int MainMenu(SDL_Window *window, SDL_Renderer *renderer, AssetCache *assets)
 {
 	// get window and box size
 	int WINDOW_WIDTH, WINDOW_HEIGHT;
@@ -171,12 +225,8 @@ int MainMenu(SDL_Window *window, SDL_Renderer *renderer)
 	 * Create font and textboxes.
 	 */
 
-	// get font location
-	char fontpath[128] = ROOT_DIR;
-	strcat(fontpath, "/Roboto_Mono/RobotoMono-VariableFont_wght.ttf");
-	
-	// create font
-	TTF_Font *font = TTF_OpenFont(fontpath, 50);
+	// get font from the asset cache
+	TTF_Font *font = AcquireFontAsset(assets, "Roboto_Mono/RobotoMono-VariableFont_wght.ttf", 50);
 	if (!font)
 	{
 		PrintError();
@@ -198,7 +248,7 @@ int MainMenu(SDL_Window *window, SDL_Renderer *renderer)
 	if (!textboxes[0])
 	{
 		PrintError();
-		TTF_CloseFont(font);
+		ReleaseFontAsset(assets, font);
 		return -2;
 	}
 
@@ -208,7 +258,7 @@ int MainMenu(SDL_Window *window, SDL_Renderer *renderer)
 	if (!textboxes[1])
 	{
 		PrintError();
-		TTF_CloseFont(font);
+		ReleaseFontAsset(assets, font);
 		return -2;
 	}
 
@@ -228,7 +278,7 @@ int MainMenu(SDL_Window *window, SDL_Renderer *renderer)
 	if (!playButton.textboxes)
 	{
 		SDL_Log("Failed to create play button. (textboxes array)");
-		TTF_CloseFont(font);
+		ReleaseFontAsset(assets, font);
 		return -2;
 	}
 
@@ -240,19 +290,25 @@ int MainMenu(SDL_Window *window, SDL_Renderer *renderer)
 	playButton.button = CreateTextbutton(&box, playButton.textboxes[0], playButton.textboxes[1], playButton.textboxes[2]);
 
 	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-	 * Set next frame time and begin main menu loop.
+	 * Create frame pacer and begin main menu loop.
 	 */
 
-	// set the next time a frame is presented
-	Uint64 nextFrameTime = SDL_GetTicks64() + (1000 / 60);
+	// create the pacer that sets the next time a frame is presented
+	FramePacer *pacer = CreateFramePacer(GetWindowFrameRate(window, ManySnakes_FRAME_RATE), ManySnakes_VSYNC);
 
 	// main menu loop
-	int returnCode = 0;
-	bool isRunning = true;
+	int returnCode = pacer ? 0 : -2;
+	bool isRunning = pacer != NULL;
+	if (!pacer)
+	{
+		PrintError();
+	}
+
 	while (isRunning)
 	{
 		SDL_Event event;
-		while (SDL_PollEvent(&event))
+		// sleep until the next frame, handling events as they arrive
+		while (WaitFramePacer(pacer, &event, 0))
 		{
 			if (SDL_QUIT == event.type)
 			{ 
@@ -267,7 +323,7 @@ int MainMenu(SDL_Window *window, SDL_Renderer *renderer)
 				SDL_Keycode key = event.key.keysym.sym;
 				if (SDLK_RETURN == key)
 				{
-					returnCode = Play(window, renderer);
+					returnCode = Play(window, renderer, assets, NULL);
 					SDL_Log("Exit Play: %d", returnCode);
 					if (returnCode != 0)
 						break;
@@ -277,7 +333,7 @@ int MainMenu(SDL_Window *window, SDL_Renderer *renderer)
 			{
 				if (SDL_PointInRect(& (SDL_Point) {event.button.x, event.button.y}, &playButton.button->mouseArea))
 				{
-					returnCode = Play(window, renderer);
+					returnCode = Play(window, renderer, assets, NULL);
 					SDL_Log("Exit Play: %d", returnCode);
 					if (returnCode != 0)
 						break;
@@ -289,11 +345,8 @@ int MainMenu(SDL_Window *window, SDL_Renderer *renderer)
 			break;
 
 		// display next frame once the next frame time is reached
-		Uint64 currentTime = SDL_GetTicks64();
-		if (currentTime >= nextFrameTime) 
+		if (DueFramePacer(pacer)) 
 		{
-			nextFrameTime = currentTime + (1000 / 60);
-			
 			if (SDL_SetRenderDrawColor(renderer, 0xA0, 0x00, 0xA0, 0xFF) != 0 || SDL_RenderClear(renderer) != 0)
 			{
 				PrintError();
@@ -321,11 +374,15 @@ int MainMenu(SDL_Window *window, SDL_Renderer *renderer)
 	DestroyTextboxes(textboxes, textboxesSize);
 	DestroyTextboxes(playButton.textboxes, 3);
 	DestroyTextbutton(playButton.button);
-	TTF_CloseFont(font);
+	ReleaseFontAsset(assets, font);
+	if (pacer)
+	{
+		DestroyFramePacer(pacer);
+	}
 	return ~returnCode;
 }
 
-int Play(SDL_Window *window, SDL_Renderer *renderer)
+int Play(SDL_Window *window, SDL_Renderer *renderer, AssetCache *assets, const char *statePath)
 {
 	// get window and box size
 	int WINDOW_WIDTH, WINDOW_HEIGHT;
@@ -340,37 +397,49 @@ int Play(SDL_Window *window, SDL_Renderer *renderer)
 	}
 
 	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-	 * Create the box size for snake and food, set play bounds, create the player's snake.
+	 * Create the box size for snake and food, set play bounds, create the game with the player's snake.
 	 */
 
-	// create player's snake
-	Snake *player = CreateSnake(19, 19, 20, 20, 125, 3, SNAKE_UP, & (SDL_Color) {0x00, 0x00, 0xA0, 0xFF});
-	if (!player)
+	// create the game on a 40x40 board, with the player in the middle and a fresh seed every round,
+	// or carry on with a saved game and the config it was made with
+	GameConfig config = {40, 40, 19, 19, 3, SNAKE_UP, 125, 20, 20, {0x00, 0x00, 0xA0, 0xFF}, SDL_GetPerformanceCounter()};
+	Game *game = statePath ? LoadGameState(statePath, &config) : CreateGame(&config);
+	if (!game)
 	{
+		if (statePath)
+			SDL_SetError("Failed to load game %s.", statePath);
+		else
+			SDL_SetError("Failed to create game.");
 		PrintError();
 		SDL_DestroyTexture(buffer);
 		return -2;
-	}	
+	}
+	Snake *player = game->player;
+
+	// create the log of the round's inputs, so it can be replayed
+	Replay *replay = CreateReplay(&config);
+	if (!replay)
+	{
+		SDL_SetError("Failed to create replay.");
+		PrintError();
+		DestroyGame(game);
+		SDL_DestroyTexture(buffer);
+		return -2;
+	}
 
 	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-	 * Set the food texture PNG path, create food, and give it a random position.
+	 * Get the food texture from the asset cache, which loads it only on the first round.
 	 */
 
-	// get apple png path
-	char applePNG[128] = ROOT_DIR;
-	strcat(applePNG, "/images/Apple.png");
-
-	// create apple
-	Food *apple = CreateFood(renderer, FOOD_APPLE, 0, 0, 20, 20, applePNG);
-	if (!apple)
+	Texture apple = {{0, 0, 20, 20}, AcquireTextureAsset(assets, "images/Apple.png")};
+	if (!apple.texture)
 	{
 		PrintError();
-		DestroySnake(player);
+		DestroyReplay(replay);
+		DestroyGame(game);
 		SDL_DestroyTexture(buffer);
 		return -2;
 	}
-	// randomize apple position
-	RandPosFood(apple, player, 40, 40);
 
 
 	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -381,25 +450,142 @@ int Play(SDL_Window *window, SDL_Renderer *renderer)
 	player->lastMoveTime = SDL_GetTicks64();
 	player->nextMoveTime = player->lastMoveTime + player->speed;
 
+	// create the pacer that sets the earliest time the next frame occurs
+	FramePacer *pacer = CreateFramePacer(GetWindowFrameRate(window, ManySnakes_FRAME_RATE), ManySnakes_VSYNC);
+	if (!pacer)
+	{
+		PrintError();
+		ReleaseTextureAsset(assets, apple.texture);
+		DestroyReplay(replay);
+		DestroyGame(game);
+		SDL_DestroyTexture(buffer);
+		return -2;
+	}
+
+	// create the camera that shows the part of the board around the player, left of the HUD. +
+	// and - zoom, WASD pans and F follows the player again
+	Camera camera;
+	InitCamera(&camera, (SDL_Rect) {0, 0, 800, WINDOW_HEIGHT < 800 ? WINDOW_HEIGHT : 800}, game->board->width, game->board->height, 20);
+
+	// create the layer that keeps the board drawn on the buffer and redraws only changed cells
+	BoardLayer *layer = CreateBoardLayer(&camera);
+	if (!layer)
+	{
+		PrintError();
+		DestroyFramePacer(pacer);
+		ReleaseTextureAsset(assets, apple.texture);
+		DestroyReplay(replay);
+		DestroyGame(game);
+		SDL_DestroyTexture(buffer);
+		return -2;
+	}
+
+	// get the HUD font and rasterize its glyphs once, so the HUD text can change every frame
+	TTF_Font *font = AcquireFontAsset(assets, "Roboto_Mono/RobotoMono-VariableFont_wght.ttf", 32);
+	GlyphAtlas *hud = font ? CreateGlyphAtlas(renderer, font) : NULL;
+	if (!hud)
+	{
+		PrintError();
+		if (font)
+			ReleaseFontAsset(assets, font);
+		DestroyBoardLayer(layer);
+		DestroyFramePacer(pacer);
+		ReleaseTextureAsset(assets, apple.texture);
+		DestroyReplay(replay);
+		DestroyGame(game);
+		SDL_DestroyTexture(buffer);
+		return -2;
+	}
+	SDL_Color hudColor = {0xFF, 0xFF, 0xFF, 0xFF};
+
+	// create the profiler that times each phase of the loop, shown with F3
+	FrameProfiler *profiler = CreateFrameProfiler();
+	if (!profiler)
+	{
+		PrintError();
+		DestroyGlyphAtlas(hud);
+		ReleaseFontAsset(assets, font);
+		DestroyBoardLayer(layer);
+		DestroyFramePacer(pacer);
+		ReleaseTextureAsset(assets, apple.texture);
+		DestroyReplay(replay);
+		DestroyGame(game);
+		SDL_DestroyTexture(buffer);
+		return -2;
+	}
+	bool isProfilerShown = false;
+
+	// create the autopilot that can steer the player instead, switched on and off with F2.
+	// a decision gives up searching well inside a frame, however big the board
+	Autopilot *autopilot = CreateAutopilot(game->board->width, game->board->height, AUTOPILOT_SAFE, AUTOPILOT_FRAME_MICROS);
+	if (!autopilot)
+	{
+		SDL_SetError("Failed to create autopilot.");
+		PrintError();
+		DestroyFrameProfiler(profiler);
+		DestroyGlyphAtlas(hud);
+		ReleaseFontAsset(assets, font);
+		DestroyBoardLayer(layer);
+		DestroyFramePacer(pacer);
+		ReleaseTextureAsset(assets, apple.texture);
+		DestroyReplay(replay);
+		DestroyGame(game);
+		SDL_DestroyTexture(buffer);
+		return -2;
+	}
+	bool isAutopilotOn = false;
+
+	// the last tick whose changes were drawn
+	uint64_t shownTick = game->tick;
+
+	// create the simulation that steps the game on its own thread, so ticks keep their time however
+	// long a frame takes. the turns asked for wait in it until their moves, so quick turns inside one
+	// move are all kept. this thread only draws the snapshots it hands back
+	Simulation *simulation = CreateSimulation(game, &config, replay, autopilot, ManySnakes_INPUT_DEPTH, SDL_GetTicks64);
+	if (!simulation || !StartSimulation(simulation))
+	{
+		SDL_SetError("Failed to start simulation.");
+		PrintError();
+		if (simulation)
+			DestroySimulation(simulation);
+		DestroyAutopilot(autopilot);
+		DestroyFrameProfiler(profiler);
+		DestroyGlyphAtlas(hud);
+		ReleaseFontAsset(assets, font);
+		DestroyBoardLayer(layer);
+		DestroyFramePacer(pacer);
+		ReleaseTextureAsset(assets, apple.texture);
+		DestroyReplay(replay);
+		DestroyGame(game);
+		SDL_DestroyTexture(buffer);
+		return -2;
+	}
+
 	// play loop
 	int returnCode = 0;
 	bool isRunning = true;
-	// set the earliest time the next frame occurs
-	Uint64 nextFrameTime = SDL_GetTicks64() + (1000 / 60);
+	SkipFrameProfiler(profiler);
 	while (isRunning)
 	{
 		SDL_Event event;
 		
 		bool isPaused = false;
 		
-		// poll events
-		while (SDL_PollEvent(&event))
+		// sleep until the next frame, handling events as they arrive
+		while (WaitFramePacer(pacer, &event, 0))
 		{
+			MarkFrameProfiler(profiler, PROFILE_WAIT);
+
 			if (SDL_QUIT == event.type) // if quit, stop event poll and exit main loop
 			{
 				returnCode = -1;
 				break;
 			}
+			else if (SDL_RENDER_TARGETS_RESET == event.type || SDL_RENDER_DEVICE_RESET == event.type || (SDL_WINDOWEVENT == event.type && SDL_WINDOWEVENT_SIZE_CHANGED == event.window.event))
+			{
+				// the buffer lost what was drawn on it, so draw the whole board again
+				InvalidateBoardLayer(layer);
+			}
 			else if (SDL_KEYDOWN == event.type) // if key pressed down, handle it!
 			{
 				SDL_Keycode pressedKey = event.key.keysym.sym;
@@ -411,113 +597,177 @@ int Play(SDL_Window *window, SDL_Renderer *renderer)
 				{
 					isPaused = true;
 				}
-				else if (pressedKey == SDLK_RIGHT && player->currentDirection != SNAKE_LEFT) // pressed right key, skip if direction is left
+				else if (pressedKey == SDLK_RIGHT || pressedKey == SDLK_UP || pressedKey == SDLK_LEFT || pressedKey == SDLK_DOWN) // pressed an arrow, queue the turn for a coming move
+				{
+					SnakeDirection direction = pressedKey == SDLK_RIGHT ? SNAKE_RIGHT : pressedKey == SDLK_UP ? SNAKE_UP : pressedKey == SDLK_LEFT ? SNAKE_LEFT : SNAKE_DOWN;
+					SimCommand command = {SIM_TURN, direction, event.key.timestamp, false};
+					SendSimulation(simulation, &command);
+				}
+				else if (pressedKey == SDLK_F3) // pressed F3, show or hide the frame timings
+				{
+					isProfilerShown = !isProfilerShown;
+				}
+				else if (pressedKey == SDLK_F2) // pressed F2, let the autopilot steer or take back control
 				{
-					player->pendingDirection = SNAKE_RIGHT; 
+					isAutopilotOn = !isAutopilotOn;
+					SimCommand command = {SIM_AUTOPILOT, 0, 0, isAutopilotOn};
+					SendSimulation(simulation, &command);
 				}
-				else if (pressedKey == SDLK_UP && player->currentDirection != SNAKE_DOWN) // pressed up key, skip if direction is down
+				else if (pressedKey == SDLK_EQUALS || pressedKey == SDLK_MINUS) // pressed + or -, zoom in or out
 				{
-					player->pendingDirection = SNAKE_UP; 
+					ZoomCamera(&camera, pressedKey == SDLK_EQUALS ? 1 : -1);
 				}
-				else if (pressedKey == SDLK_LEFT && player->currentDirection != SNAKE_RIGHT) // pressed left key, skip if direction is right
+				else if (pressedKey == SDLK_w || pressedKey == SDLK_a || pressedKey == SDLK_s || pressedKey == SDLK_d) // pressed WASD, pan a quarter of the view
 				{
-					player->pendingDirection = SNAKE_LEFT; 
+					int xStep = camera.cells.w > 4 ? camera.cells.w / 4 : 1, yStep = camera.cells.h > 4 ? camera.cells.h / 4 : 1;
+					PanCamera(&camera, pressedKey == SDLK_d ? xStep : pressedKey == SDLK_a ? -xStep : 0, pressedKey == SDLK_s ? yStep : pressedKey == SDLK_w ? -yStep : 0);
 				}
-				else if (pressedKey == SDLK_DOWN && player->currentDirection != SNAKE_UP) // pressed down key, skip if direction is up
+				else if (pressedKey == SDLK_f) // pressed F, follow the player again
 				{
-					player->pendingDirection = SNAKE_DOWN;
+					camera.isFollowing = true;
 				}
 			}
+
+			MarkFrameProfiler(profiler, PROFILE_EVENTS);
 		}
+		MarkFrameProfiler(profiler, PROFILE_WAIT);
 		
 		if (returnCode != 0)
 			break;
 		
 		
 		/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-		 * Move snake when time has elapsed. If snake eats food, reposition the food and grow snake.
-		 * If the snake hits itself, end game.
+		 * Take the newest snapshot of the game and catch up on the ticks since the last one. Mark the
+		 * cells they changed, time the turns they took, and end the round if the game ended.
 		 */
 
-		Uint64 timeNow = SDL_GetTicks64();
+		const SimSnapshot *snapshot = ReadSimulation(simulation);
+		Game *shown = snapshot->game;
+		Snake *shownPlayer = shown->player;
+		int events = 0;
 
-		if (timeNow >= player->nextMoveTime)
+		// a frame that fell more than the history behind has lost some changed cells, so it draws them all
+		if (shown->tick - shownTick > SIM_HISTORY)
 		{
-			// update next move time
-			player->lastMoveTime = player->nextMoveTime;
-			player->nextMoveTime = timeNow + player->speed;
-
-			// store tail position for new tail if snake grows 
-			int xTail = player->tail->xPos;
-			int yTail = player->tail->yPos;
-
-			// update the snake's position
-			StepSnake(player, 40, 40);
-			
-			// if snake hits itself, end game
-			if (CheckCollisionSnake(player)) 
-			{
-				isRunning = false;
-				SDL_Log("Game Over");
-			}
- 
-			// if snake eats food, grow snake and move food
-			if (player->head->xPos == apple->xPos && player->head->yPos == apple->yPos)
+			InvalidateBoardLayer(layer);
+			shownTick = shown->tick - SIM_HISTORY;
+		}
+		for (; shownTick < shown->tick; ++shownTick)
+		{
+			const SimTick *record = &snapshot->ticks[(shownTick + 1) % SIM_HISTORY];
+			MarkBoardLayer(layer, record->changes, record->changeCount);
+			if (record->isTurnTimed)
 			{
-				//FIXME add resolution case when snake covers whole map (probably not needed)
-				RandPosFood(apple, player, 40, 40);
-				GrowSnake(player, xTail, yTail);
-				SDL_Log("Size: %d", player->length);
+				AddInputFrameProfiler(profiler, record->turnTime);
 			}
+			events |= record->events;
+		}
 
+		if (events & GAME_EVENT_ERROR)
+		{
+			SDL_SetError("Failed to step game. (Failed to grow SnakeCell ring buffer or ReplayInput array)");
+			PrintError();
+			returnCode = -2;
+			break;
+		}
+
+		// if snake hits itself, end game
+		if (events & GAME_EVENT_DIED)
+		{
+			isRunning = false;
+			SDL_Log("Game Over");
 		}
 
+		if (events & GAME_EVENT_ATE)
+		{
+			SDL_Log("Size: %d", shownPlayer->length);
+		}
+
+		// if the snake fills the board, there is no room left for the food and the game is won
+		if (events & GAME_EVENT_WON)
+		{
+			isRunning = false;
+			SDL_Log("You Win");
+		}
+		MarkFrameProfiler(profiler, PROFILE_STEP);
+
 
 		/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 		 * Draw the food, snake, and wait until next frame, draw frame.
 		 */
 		
-		Uint64 currentTime = SDL_GetTicks64();
-		if (currentTime >= nextFrameTime) 
+		if (DueFramePacer(pacer)) 
 		{
-			nextFrameTime = currentTime + (1000 / 60);
-			
-			// set buffer as render target and clear frame
-			if (SDL_SetRenderTarget(renderer, buffer) != 0 || SDL_SetRenderDrawColor(renderer, 0xad, 0xd8, 0xe6, 0xff) != 0 || SDL_RenderClear(renderer) != 0)
+			// keep the player in view, then draw the cells that changed since the last frame onto the buffer
+			SnakeCell *head = SnakeCellAt(shownPlayer, 0);
+			FollowCamera(&camera, head->xPos, head->yPos);
+			if (SDL_SetRenderTarget(renderer, buffer) != 0 || !UpdateBoardLayer(renderer, layer, shown, &camera, &apple) || SDL_SetRenderTarget(renderer, NULL) != 0)
 			{
 				PrintError();
 				returnCode = -2;
 				break;
 			}
-			
-			// draw snake play area
-			if (SDL_SetRenderDrawColor(renderer, 0xe0, 0xb0, 0xff, 0xff) != 0 || SDL_RenderFillRect(renderer, & (SDL_Rect) {0, 0, 800, 800}) != 0)
+			MarkFrameProfiler(profiler, PROFILE_RENDER);
+
+			// copy the buffer to renderer
+			if (SDL_RenderCopy(renderer, buffer, NULL, NULL) != 0)
+			{
+				PrintError();
+				returnCode = -2;
+				break;
+			}
+			MarkFrameProfiler(profiler, PROFILE_COPY);
+
+			// the board only changes once a tick, but frames come at the display's rate, so slide the
+			// head and tail over the copy by how far the clock is between the last move and the next
+			Uint64 drawTime = SDL_GetTicks64();
+			float progress = drawTime >= shownPlayer->nextMoveTime ? 1 : drawTime <= shownPlayer->lastMoveTime ? 0 :
+				(float) (drawTime - shownPlayer->lastMoveTime) / (float) (shownPlayer->nextMoveTime - shownPlayer->lastMoveTime);
+			if (!RenderSnakeMotion(renderer, layer, shown, &camera, progress))
 			{
 				PrintError();
 				returnCode = -2;
 				break;
 			}
 
-
-			// render food and snake, copy to renderer
-			if (!(RenderFood(renderer, apple, 0, 0, 20, 20) && RenderSnake(renderer, player, 0, 0, 20, 20)) || SDL_SetRenderTarget(renderer, NULL) != 0 || SDL_RenderCopy(renderer, buffer, NULL, NULL) != 0)
+			// draw the HUD over the board, straight to the renderer so the buffer stays clean
+			char hudText[32];
+			snprintf(hudText, sizeof(hudText), "Length: %d", shownPlayer->length);
+			if (!AddTextGlyphAtlas(hud, hudText, 820, 20, &hudColor) || (isProfilerShown && !OverlayFrameProfiler(profiler, hud, 820, 20 + 2 * hud->lineHeight, &hudColor)) || !RenderGlyphAtlas(renderer, hud))
 			{
 				PrintError();
 				returnCode = -2;
 				break;
 			}
+			MarkFrameProfiler(profiler, PROFILE_RENDER);
 
 			SDL_RenderPresent(renderer);
+			MarkFrameProfiler(profiler, PROFILE_PRESENT);
+			CommitFrameProfiler(profiler);
 		}
 		
 		if (isPaused)
 		{	
+			// the game is only this thread's while the simulation is stopped, e.g. to save it
 			Uint64 timeBeforePause = SDL_GetTicks64();
-			returnCode = Pause(window, renderer, buffer);
+			StopSimulation(simulation);
+			returnCode = Pause(window, renderer, buffer, game, &config);
 			SDL_Log("Exit Pause: %d", returnCode);
 			if (returnCode == 0)
 			{
-				player->nextMoveTime += SDL_GetTicks64() - timeBeforePause;
+				// shift both move times, so the snake picks up mid cell where it paused
+				Uint64 pauseTime = SDL_GetTicks64() - timeBeforePause;
+				player->lastMoveTime += pauseTime;
+				player->nextMoveTime += pauseTime;
+				if (!StartSimulation(simulation))
+				{
+					SDL_SetError("Failed to start simulation.");
+					PrintError();
+					returnCode = -2;
+					break;
+				}
+				InvalidateBoardLayer(layer);
+				SkipFrameProfiler(profiler);
 			}
 			else if (returnCode > 0)
 			{
@@ -529,22 +779,70 @@ int Play(SDL_Window *window, SDL_Renderer *renderer)
 			}
 		}
 	} // play loop end
+
+	// take the game back from the simulation thread
+	StopSimulation(simulation);
+
+	// keep the timings of the round for finding hitches after the fact
+	if (!WriteFrameProfiler(profiler, ManySnakes_PERF_DUMP))
+	{
+		PrintError();
+	}
+	if (simulation->turns.dropped > 0)
+	{
+		SDL_Log("Dropped %llu turns with %d already queued.", (unsigned long long) simulation->turns.dropped, simulation->turns.depth);
+	}
+
+	// everything the loop needs is made before it starts, so a frame that touched the heap is a bug.
+	// debug builds point it out
+#ifndef NDEBUG
+	if (profiler->sessionAllocations > 0)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Play loop made %llu heap allocations in %llu of %llu frames.",
+				(unsigned long long) profiler->sessionAllocations, (unsigned long long) profiler->allocatingFrames, (unsigned long long) profiler->frameCount);
+	}
+#endif
+
+	// keep the inputs of the round for replaying it. a resumed round did not start from the config,
+	// so its inputs cannot replay it
+	FinishReplay(replay, game);
+	if (!statePath && !SaveReplay(replay, ManySnakes_REPLAY_LOG))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to save replay %s.", ManySnakes_REPLAY_LOG);
+	}
+	DestroyReplay(replay);
 		
-	DestroyFood(apple);
-	DestroySnake(player);
+	DestroySimulation(simulation);
+	DestroyAutopilot(autopilot);
+	DestroyFrameProfiler(profiler);
+	DestroyGlyphAtlas(hud);
+	ReleaseFontAsset(assets, font);
+	DestroyBoardLayer(layer);
+	DestroyFramePacer(pacer);
+	ReleaseTextureAsset(assets, apple.texture);
+	DestroyGame(game);
 	SDL_DestroyTexture(buffer);
 
 	return returnCode;
 }
 
-int Pause(SDL_Window *window, SDL_Renderer *renderer, SDL_Texture *buffer)
+int Pause(SDL_Window *window, SDL_Renderer *renderer, SDL_Texture *buffer, Game *game, const GameConfig *config)
 {	
 	int WINDOW_WIDTH, WINDOW_HEIGHT;
 	SDL_GetWindowSize(window, &WINDOW_WIDTH, &WINDOW_HEIGHT);
 	
+	// create the pacer that sets the earliest time the next frame occurs
+	FramePacer *pacer = CreateFramePacer(GetWindowFrameRate(window, ManySnakes_FRAME_RATE), ManySnakes_VSYNC);
+	if (!pacer)
+	{
+		PrintError();
+		return -2;
+	}
+
 	if (SDL_SetTextureBlendMode(buffer, SDL_BLENDMODE_BLEND) != 0 || SDL_SetTextureAlphaMod(buffer, 75) != 0)
 	{
 		PrintError();
+		DestroyFramePacer(pacer);
 		return -2;
 	}
 
@@ -555,19 +853,8 @@ int Pause(SDL_Window *window, SDL_Renderer *renderer, SDL_Texture *buffer)
 	{
 		SDL_Event event;
 
-		// clear frame
-		if (SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0) != 0 || SDL_RenderClear(renderer) != 0)
-		{
-			PrintError();
-			returnCode = -2;
-			break;
-		}
-		
-		// set the earliest time the next frame occurs
-		Uint64 nextFrameTime = SDL_GetTicks64() + (1000 / 60);
-		
-		// poll events
-		while (SDL_PollEvent(&event))
+		// sleep until the next frame, handling events as they arrive
+		while (WaitFramePacer(pacer, &event, 0))
 		{
 			if (SDL_QUIT == event.type) // if quit, stop event poll and exit main loop
 			{
@@ -585,6 +872,17 @@ int Pause(SDL_Window *window, SDL_Renderer *renderer, SDL_Texture *buffer)
 				{
 					isRunning = false;
 				}
+				else if (pressedKey == SDLK_s) // pressed S, save the game to resume it later with --resume
+				{
+					if (SaveGameState(game, config, ManySnakes_SAVE_STATE))
+					{
+						SDL_Log("Saved game to %s.", ManySnakes_SAVE_STATE);
+					}
+					else
+					{
+						SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to save game %s.", ManySnakes_SAVE_STATE);
+					}
+				}
 			}
 		}
 
@@ -592,6 +890,19 @@ int Pause(SDL_Window *window, SDL_Renderer *renderer, SDL_Texture *buffer)
 		{
 			break;
 		}
+
+		if (!DueFramePacer(pacer))
+		{
+			continue;
+		}
+
+		// clear frame
+		if (SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0) != 0 || SDL_RenderClear(renderer) != 0)
+		{
+			PrintError();
+			returnCode = -2;
+			break;
+		}
 		
 		// draw frame
 		if (SDL_SetRenderTarget(renderer, buffer) != 0 || SDL_SetRenderTarget(renderer, NULL) != 0 || SDL_RenderCopy(renderer, buffer, NULL, NULL))
@@ -601,11 +912,12 @@ int Pause(SDL_Window *window, SDL_Renderer *renderer, SDL_Texture *buffer)
 			break;
 		}
 				
-		// wait and present next frame
-		while (SDL_GetTicks64() < nextFrameTime);
+		// present next frame
 		SDL_RenderPresent(renderer);
 	}
 
+	DestroyFramePacer(pacer);
+
 	if (SDL_SetTextureBlendMode(buffer, SDL_BLENDMODE_NONE) != 0 || SDL_SetTextureAlphaMod(buffer, 0xFF) != 0 || SDL_SetRenderTarget(renderer, NULL) != 0)
 	{
 		PrintError();
@@ -616,3 +928,315 @@ int Pause(SDL_Window *window, SDL_Renderer *renderer, SDL_Texture *buffer)
 
 	return returnCode;
 }
+
+int WatchReplay(SDL_Window *window, SDL_Renderer *renderer, AssetCache *assets, Replay *replay, double speed)
+{
+	// get window size
+	int WINDOW_WIDTH, WINDOW_HEIGHT;
+	SDL_GetWindowSize(window, &WINDOW_WIDTH, &WINDOW_HEIGHT);
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Create the logged game and everything needed to draw it, like Play does.
+	 */
+
+	GameConfig *config = &replay->config;
+	Game *game = CreateGame(config);
+	SDL_Texture *buffer = SDL_CreateTexture(renderer, SDL_GetWindowPixelFormat(window), SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
+	Texture apple = {{0, 0, config->nodeWidth, config->nodeHeight}, AcquireTextureAsset(assets, "images/Apple.png")};
+	TTF_Font *font = AcquireFontAsset(assets, "Roboto_Mono/RobotoMono-VariableFont_wght.ttf", 32);
+	GlyphAtlas *hud = font ? CreateGlyphAtlas(renderer, font) : NULL;
+	FramePacer *pacer = CreateFramePacer(GetWindowFrameRate(window, ManySnakes_FRAME_RATE), ManySnakes_VSYNC);
+	Camera camera;
+	if (game)
+	{
+		InitCamera(&camera, (SDL_Rect) {0, 0, 800, WINDOW_HEIGHT < 800 ? WINDOW_HEIGHT : 800}, game->board->width, game->board->height, config->nodeWidth);
+	}
+	BoardLayer *layer = game ? CreateBoardLayer(&camera) : NULL;
+
+	int returnCode = 0;
+	if (!game || !buffer || !apple.texture || !hud || !pacer || !layer)
+	{
+		PrintError();
+		returnCode = -2;
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Step the logged inputs back in at the chosen speed. Up and down double and halve the speed.
+	 */
+
+	// ticks are owed at the game's own pace times the speed, and stepped in whole ticks each loop
+	Uint64 tickMs = config->speed ? config->speed : 125;
+	double ticksOwed = 0;
+	Uint64 lastTime = SDL_GetTicks64();
+	int cursor = 0;
+	bool isChecked = false;
+	SDL_Color hudColor = {0xFF, 0xFF, 0xFF, 0xFF};
+
+	while (returnCode == 0)
+	{
+		SDL_Event event;
+		bool isRunning = true;
+		while (WaitFramePacer(pacer, &event, 0))
+		{
+			if (SDL_QUIT == event.type)
+			{
+				returnCode = -1;
+				break;
+			}
+			else if (SDL_RENDER_TARGETS_RESET == event.type || SDL_RENDER_DEVICE_RESET == event.type)
+			{
+				InvalidateBoardLayer(layer);
+			}
+			else if (SDL_KEYDOWN == event.type)
+			{
+				SDL_Keycode pressedKey = event.key.keysym.sym;
+				if (pressedKey == SDLK_ESCAPE)
+				{
+					isRunning = false;
+				}
+				else if (pressedKey == SDLK_UP)
+				{
+					speed *= 2;
+				}
+				else if (pressedKey == SDLK_DOWN)
+				{
+					speed /= 2;
+				}
+				else if (pressedKey == SDLK_EQUALS || pressedKey == SDLK_MINUS)
+				{
+					ZoomCamera(&camera, pressedKey == SDLK_EQUALS ? 1 : -1);
+				}
+			}
+		}
+
+		if (returnCode != 0 || !isRunning)
+		{
+			break;
+		}
+
+		// step every tick owed since the last loop, up to where the log ends
+		Uint64 timeNow = SDL_GetTicks64();
+		ticksOwed += (double) (timeNow - lastTime) * speed / tickMs;
+		lastTime = timeNow;
+		while (ticksOwed >= 1 && game->tick < replay->tickCount && !game->isOver)
+		{
+			GameInput input;
+			InputReplay(replay, &cursor, game->tick, &input);
+			StepGame(game, &input);
+			MarkBoardLayer(layer, game->changes, game->changeCount);
+			--ticksOwed;
+		}
+
+		// once the log is used up, check that the replay ended the same as the recording
+		if (!isChecked && (game->tick >= replay->tickCount || game->isOver))
+		{
+			isChecked = true;
+			ticksOwed = 0;
+			if (HashGame(game) == replay->finalHash)
+			{
+				SDL_Log("Replay matches the log after %llu ticks.", (unsigned long long) game->tick);
+			}
+			else
+			{
+				SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Replay diverged from the log after %llu ticks.", (unsigned long long) game->tick);
+			}
+		}
+
+		if (DueFramePacer(pacer))
+		{
+			char hudText[64];
+			snprintf(hudText, sizeof(hudText), "Tick %llu/%llu x%g", (unsigned long long) game->tick, (unsigned long long) replay->tickCount, speed);
+			SnakeCell *head = SnakeCellAt(game->player, 0);
+			FollowCamera(&camera, head->xPos, head->yPos);
+			if (SDL_SetRenderTarget(renderer, buffer) != 0 || !UpdateBoardLayer(renderer, layer, game, &camera, &apple) || SDL_SetRenderTarget(renderer, NULL) != 0
+					|| SDL_RenderCopy(renderer, buffer, NULL, NULL) != 0 || !AddTextGlyphAtlas(hud, hudText, 820, 20, &hudColor) || !RenderGlyphAtlas(renderer, hud))
+			{
+				PrintError();
+				returnCode = -2;
+				break;
+			}
+
+			SDL_RenderPresent(renderer);
+		}
+	}
+
+	if (layer)
+		DestroyBoardLayer(layer);
+	if (pacer)
+		DestroyFramePacer(pacer);
+	if (hud)
+		DestroyGlyphAtlas(hud);
+	if (font)
+		ReleaseFontAsset(assets, font);
+	if (apple.texture)
+		ReleaseTextureAsset(assets, apple.texture);
+	if (buffer)
+		SDL_DestroyTexture(buffer);
+	if (game)
+		DestroyGame(game);
+
+	return returnCode;
+}
+
+int WatchServer(SDL_Window *window, SDL_Renderer *renderer, AssetCache *assets, const char *host, int port)
+{
+	// get window size
+	int WINDOW_WIDTH, WINDOW_HEIGHT;
+	SDL_GetWindowSize(window, &WINDOW_WIDTH, &WINDOW_HEIGHT);
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Join the server with one snake, and create everything needed to draw its world.
+	 */
+
+	NetClient *client = CreateNetClient(host, port, 1);
+	if (!client)
+	{
+		SDL_SetError("Failed to join server %s:%d. (could not open a socket or find the host)", host, port);
+	}
+	Texture apple = {{0, 0, 20, 20}, AcquireTextureAsset(assets, "images/Apple.png")};
+	TTF_Font *font = AcquireFontAsset(assets, "Roboto_Mono/RobotoMono-VariableFont_wght.ttf", 32);
+	GlyphAtlas *hud = font ? CreateGlyphAtlas(renderer, font) : NULL;
+	FramePacer *pacer = CreateFramePacer(GetWindowFrameRate(window, ManySnakes_FRAME_RATE), ManySnakes_VSYNC);
+	RenderBatch *snakeBatch = CreateRenderBatch(1024);
+	RenderBatch *foodBatch = CreateRenderBatch(64);
+
+	int returnCode = 0;
+	if (!client || !apple.texture || !hud || !pacer || !snakeBatch || !foodBatch)
+	{
+		PrintError();
+		returnCode = -2;
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Send the arrow keys as turns and draw the mirror of the server's world as it comes in.
+	 */
+
+	// the camera is set up once the server has answered and the size of its board is known
+	Camera camera;
+	bool hasCamera = false;
+	SDL_Color hudColor = {0xFF, 0xFF, 0xFF, 0xFF};
+	Uint64 lastTime = SDL_GetTicks64();
+	uint64_t lastBytes = 0;
+	double kilobytesPerSecond = 0;
+
+	while (returnCode == 0)
+	{
+		SDL_Event event;
+		bool isRunning = true;
+		while (WaitFramePacer(pacer, &event, 0))
+		{
+			if (SDL_QUIT == event.type)
+			{
+				returnCode = -1;
+				break;
+			}
+			else if (SDL_KEYDOWN == event.type)
+			{
+				SDL_Keycode pressedKey = event.key.keysym.sym;
+				if (pressedKey == SDLK_ESCAPE)
+				{
+					isRunning = false;
+				}
+				else if (pressedKey == SDLK_UP || pressedKey == SDLK_DOWN || pressedKey == SDLK_LEFT || pressedKey == SDLK_RIGHT)
+				{
+					SteerNetClient(client, 0, pressedKey == SDLK_UP ? SNAKE_UP : pressedKey == SDLK_DOWN ? SNAKE_DOWN : pressedKey == SDLK_LEFT ? SNAKE_LEFT : SNAKE_RIGHT);
+				}
+				else if (hasCamera && (pressedKey == SDLK_EQUALS || pressedKey == SDLK_MINUS))
+				{
+					ZoomCamera(&camera, pressedKey == SDLK_EQUALS ? 1 : -1);
+				}
+			}
+		}
+
+		if (returnCode != 0 || !isRunning)
+		{
+			break;
+		}
+
+		// take every snapshot that came in and send the turns right away, so they make the next tick
+		if (PollNetClient(client) < 0 || !FlushNetClient(client))
+		{
+			SDL_SetError("Failed to talk to server %s:%d. (socket error)", host, port);
+			PrintError();
+			returnCode = -2;
+			break;
+		}
+
+		// the bytes coming in each second, measured over about a second
+		Uint64 timeNow = SDL_GetTicks64();
+		if (timeNow - lastTime >= 1000)
+		{
+			kilobytesPerSecond = (double) (client->socket->bytesReceived - lastBytes) / (double) (timeNow - lastTime);
+			lastBytes = client->socket->bytesReceived;
+			lastTime = timeNow;
+		}
+
+		if (!DueFramePacer(pacer))
+		{
+			continue;
+		}
+
+		if (client->mirror && !hasCamera)
+		{
+			InitCamera(&camera, (SDL_Rect) {0, 0, 800, WINDOW_HEIGHT < 800 ? WINDOW_HEIGHT : 800}, client->mirror->width, client->mirror->height, 20);
+			hasCamera = true;
+		}
+
+		char hudText[64];
+		snprintf(hudText, sizeof(hudText), "Tick %lu %.1fkB/s", (unsigned long) client->appliedTick, kilobytesPerSecond);
+		if (SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF) != 0 || SDL_RenderClear(renderer) != 0)
+		{
+			PrintError();
+			returnCode = -2;
+			break;
+		}
+
+		// only what the camera sees goes into the batches, which are drawn with one call each
+		if (hasCamera && client->isSynced)
+		{
+			World *mirror = client->mirror;
+			if (mirror->isAlive[client->firstSnake])
+			{
+				FollowCamera(&camera, mirror->headX[client->firstSnake], mirror->headY[client->firstSnake]);
+			}
+
+			int xOrigin, yOrigin;
+			GetCameraOrigin(&camera, &xOrigin, &yOrigin);
+			ClearRenderBatch(snakeBatch);
+			ClearRenderBatch(foodBatch);
+			if (!BatchWorld(snakeBatch, foodBatch, mirror, &camera.cells, xOrigin, yOrigin, camera.cellSize, camera.cellSize)
+					|| !DrawRenderBatch(renderer, snakeBatch, NULL) || !DrawRenderBatch(renderer, foodBatch, apple.texture))
+			{
+				PrintError();
+				returnCode = -2;
+				break;
+			}
+		}
+
+		if (!AddTextGlyphAtlas(hud, hudText, 820, 20, &hudColor) || !RenderGlyphAtlas(renderer, hud))
+		{
+			PrintError();
+			returnCode = -2;
+			break;
+		}
+
+		SDL_RenderPresent(renderer);
+	}
+
+	if (foodBatch)
+		DestroyRenderBatch(foodBatch);
+	if (snakeBatch)
+		DestroyRenderBatch(snakeBatch);
+	if (pacer)
+		DestroyFramePacer(pacer);
+	if (hud)
+		DestroyGlyphAtlas(hud);
+	if (font)
+		ReleaseFontAsset(assets, font);
+	if (apple.texture)
+		ReleaseTextureAsset(assets, apple.texture);
+	if (client)
+		DestroyNetClient(client);
+
+	return returnCode;
+}
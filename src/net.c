@@ -0,0 +1,230 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "net.h"
+#include "allocator.h"
+#include <string.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+
+#define NET_SOCKET_BUFFER (4 << 20)	// bytes asked for the send and receive buffers
+
+
+NetSocket *OpenNetSocket(int port)
+{
+	NetSocket *netSocket = CallocMemory(1, sizeof(NetSocket));
+	if (!netSocket)
+	{
+		return NULL;
+	}
+
+	// listen on every interface, so both loopback and LAN peers get through. port 0 takes any free one
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons((uint16_t) port);
+
+	// a socket that never blocks, so a frame or tick is never held up waiting for the network
+	netSocket->fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (netSocket->fd < 0 || bind(netSocket->fd, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+		fcntl(netSocket->fd, F_SETFL, fcntl(netSocket->fd, F_GETFL, 0) | O_NONBLOCK) != 0)
+	{
+		CloseNetSocket(netSocket);
+		return NULL;
+	}
+
+	// a full snapshot of a big world goes out as one burst of packets, which the default buffers drop
+	// most of. ask for more, the system caps it at what it allows
+	int bufferSize = NET_SOCKET_BUFFER;
+	setsockopt(netSocket->fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+	setsockopt(netSocket->fd, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+	return netSocket;
+}
+
+bool ResolveNetAddress(const char *host, int port, NetAddress *address)
+{
+	// look up the first IPv4 address of the host, which may be a name or a dotted address
+	struct addrinfo hints, *found = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if (getaddrinfo(host, NULL, &hints, &found) != 0 || !found)
+	{
+		return false;
+	}
+
+	address->host = ntohl(((struct sockaddr_in *) found->ai_addr)->sin_addr.s_addr);
+	address->port = (uint16_t) port;
+	freeaddrinfo(found);
+
+	return true;
+}
+
+bool SendNetSocket(NetSocket *netSocket, const NetAddress *address, const NetPacket *packet)
+{
+	// a bad packet went past its end while it was written, so it is not sent at all
+	if (packet->isBad)
+	{
+		return false;
+	}
+
+	struct sockaddr_in to;
+	memset(&to, 0, sizeof(to));
+	to.sin_family = AF_INET;
+	to.sin_addr.s_addr = htonl(address->host);
+	to.sin_port = htons(address->port);
+
+	if (sendto(netSocket->fd, packet->data, (size_t) packet->size, 0, (struct sockaddr *) &to, sizeof(to)) != packet->size)
+	{
+		return false;
+	}
+
+	netSocket->bytesSent += (uint64_t) packet->size;
+	++netSocket->packetsSent;
+
+	return true;
+}
+
+bool ReceiveNetSocket(NetSocket *netSocket, NetAddress *address, NetPacket *packet)
+{
+	// take the next datagram if one is waiting, skipping any that are not ours
+	for (;;)
+	{
+		struct sockaddr_in from;
+		socklen_t fromSize = sizeof(from);
+		ssize_t size = recvfrom(netSocket->fd, packet->data, sizeof(packet->data), 0, (struct sockaddr *) &from, &fromSize);
+		if (size < 0)
+		{
+			return false;
+		}
+
+		netSocket->bytesReceived += (uint64_t) size;
+		++netSocket->packetsReceived;
+
+		packet->size = (int) size;
+		packet->offset = 0;
+		packet->isBad = false;
+		if (GetNetU8(packet) != NET_PROTOCOL || packet->isBad)
+		{
+			continue;
+		}
+
+		address->host = ntohl(from.sin_addr.s_addr);
+		address->port = ntohs(from.sin_port);
+
+		return true;
+	}
+}
+
+bool WaitNetSocket(NetSocket *netSocket, int milliseconds)
+{
+	// sleep until a datagram arrives or the time is up
+	struct pollfd wait = {netSocket->fd, POLLIN, 0};
+
+	return poll(&wait, 1, milliseconds > 0 ? milliseconds : 0) > 0;
+}
+
+void CloseNetSocket(NetSocket *netSocket)
+{
+	if (netSocket->fd >= 0)
+	{
+		close(netSocket->fd);
+	}
+
+	FreeMemory(netSocket);
+}
+
+void StartNetPacket(NetPacket *packet, NetMessage message)
+{
+	packet->size = packet->offset = 0;
+	packet->isBad = false;
+	PutNetU8(packet, NET_PROTOCOL);
+	PutNetU8(packet, (uint8_t) message);
+}
+
+void PutNetU8(NetPacket *packet, uint8_t value)
+{
+	if (packet->size >= NET_MAX_PACKET)
+	{
+		packet->isBad = true;
+		return;
+	}
+
+	packet->data[packet->size++] = value;
+}
+
+void PutNetU16(NetPacket *packet, uint16_t value)
+{
+	// little endian, like the replay log
+	PutNetU8(packet, (uint8_t) value);
+	PutNetU8(packet, (uint8_t) (value >> 8));
+}
+
+void PutNetU32(NetPacket *packet, uint32_t value)
+{
+	PutNetU16(packet, (uint16_t) value);
+	PutNetU16(packet, (uint16_t) (value >> 16));
+}
+
+void PutNetVarint(NetPacket *packet, uint32_t value)
+{
+	// seven bits a byte, low bits first, the high bit set on every byte but the last
+	while (value >= 0x80)
+	{
+		PutNetU8(packet, (uint8_t) (value | 0x80));
+		value >>= 7;
+	}
+
+	PutNetU8(packet, (uint8_t) value);
+}
+
+uint8_t GetNetU8(NetPacket *packet)
+{
+	if (packet->offset >= packet->size)
+	{
+		packet->isBad = true;
+		return 0;
+	}
+
+	return packet->data[packet->offset++];
+}
+
+uint16_t GetNetU16(NetPacket *packet)
+{
+	uint16_t low = GetNetU8(packet);
+
+	return (uint16_t) (low | GetNetU8(packet) << 8);
+}
+
+uint32_t GetNetU32(NetPacket *packet)
+{
+	uint32_t low = GetNetU16(packet);
+
+	return low | (uint32_t) GetNetU16(packet) << 16;
+}
+
+uint32_t GetNetVarint(NetPacket *packet)
+{
+	uint32_t value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		uint8_t byte = GetNetU8(packet);
+		value |= (uint32_t) (byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			return value;
+		}
+	}
+
+	// more bytes than a 32 bit number needs
+	packet->isBad = true;
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// bytes in one datagram, small enough that it is never split up on the way
+#define NET_MAX_PACKET 1200
+// port a server listens on when none is given
+#define NET_DEFAULT_PORT 7777
+// first byte of every packet, so stray datagrams and other versions are dropped
+#define NET_PROTOCOL 1
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare NetMessage enum.
+ */
+
+// kinds of packet, the second byte of every packet. numbers are varints unless a size is given
+typedef enum
+{
+	NET_JOIN = 1,	// client asks for snakes: snake count
+	NET_WELCOME,	// server gives them: first snake, snake count, width u32, height u32, food count, tick rate
+	NET_INPUT,	// client turns its snakes: applied tick u32, needs full u8, turn count, (own snake, direction u8) per turn
+	NET_LEAVE,	// client is gone, its snakes are taken off the board
+	NET_DELTA,	// what changed in one tick: tick u32, part u16, part count u16, records
+	NET_FULL	// the whole world at one tick: tick u32, part u16, part count u16, records
+} NetMessage;
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare NetAddress, NetPacket, NetSocket structs.
+ */
+
+// an IPv4 address and port, in host byte order
+typedef struct NetAddress
+{
+	uint32_t host;
+	uint16_t port;
+} NetAddress;
+
+// one datagram, written and read front to back. running past either end marks it bad instead of
+// overflowing, so a packet is only checked once it is done
+typedef struct NetPacket
+{
+	uint8_t data[NET_MAX_PACKET];
+	int size;	// bytes written, or bytes received
+	int offset;	// next byte to read
+	bool isBad;
+} NetPacket;
+
+// a non-blocking UDP socket and the traffic that went through it
+typedef struct NetSocket
+{
+	int fd;
+	uint64_t bytesSent, bytesReceived;
+	uint64_t packetsSent, packetsReceived;
+} NetSocket;
+
+NetSocket *OpenNetSocket(int port);
+bool ResolveNetAddress(const char *host, int port, NetAddress *address);
+bool SendNetSocket(NetSocket *socket, const NetAddress *address, const NetPacket *packet);
+bool ReceiveNetSocket(NetSocket *socket, NetAddress *address, NetPacket *packet);
+bool WaitNetSocket(NetSocket *socket, int milliseconds);
+void CloseNetSocket(NetSocket *socket);
+
+void StartNetPacket(NetPacket *packet, NetMessage message);
+void PutNetU8(NetPacket *packet, uint8_t value);
+void PutNetU16(NetPacket *packet, uint16_t value);
+void PutNetU32(NetPacket *packet, uint32_t value);
+void PutNetVarint(NetPacket *packet, uint32_t value);
+uint8_t GetNetU8(NetPacket *packet);
+uint16_t GetNetU16(NetPacket *packet);
+uint32_t GetNetU32(NetPacket *packet);
+uint32_t GetNetVarint(NetPacket *packet);
+
+static inline bool IsSameNetAddress(const NetAddress *a, const NetAddress *b)
+{
+	return a->host == b->host && a->port == b->port;
+}
+
+#endif
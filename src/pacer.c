@@ -0,0 +1,108 @@
+#include "pacer.h"
+
+
+// how close to a deadline, in milliseconds, the pacer stops sleeping and starts spinning
+#define PACER_SPIN_MS 2
+
+FramePacer *CreateFramePacer(int rate, bool isVsync)
+{
+	FramePacer *pacer = malloc(sizeof(FramePacer));
+	if (!pacer)
+	{
+		SDL_SetError("Failed to create frame pacer. (Failed to create FramePacer struct)");
+		return NULL;
+	}
+
+	// with vsync, or without a rate, every loop presents and the display sets the pace
+	pacer->frequency = SDL_GetPerformanceFrequency();
+	pacer->period = (rate > 0 && !isVsync) ? pacer->frequency / rate : 0;
+	pacer->nextFrameTime = SDL_GetPerformanceCounter() + pacer->period;
+	pacer->isVsync = isVsync;
+
+	return pacer;
+}
+
+int GetWindowFrameRate(SDL_Window *window, int rate)
+{
+	// a set rate wins. otherwise frames follow the refresh of the display the window is on, so a high
+	// refresh display gets every frame it can show, and 60 if the display does not say
+	SDL_DisplayMode mode;
+	if (rate > 0)
+	{
+		return rate;
+	}
+
+	int display = SDL_GetWindowDisplayIndex(window);
+	if (display >= 0 && SDL_GetCurrentDisplayMode(display, &mode) == 0 && mode.refresh_rate > 0)
+	{
+		return mode.refresh_rate;
+	}
+
+	return 60;
+}
+
+bool WaitFramePacer(FramePacer *pacer, SDL_Event *event, Uint64 wakeTime)
+{
+	// turn the wake time from SDL_GetTicks64 milliseconds into a performance counter value
+	Uint64 deadline = pacer->nextFrameTime;
+	if (wakeTime > 0)
+	{
+		Uint64 ticksNow = SDL_GetTicks64();
+		Uint64 counterNow = SDL_GetPerformanceCounter();
+		Uint64 wakeCounter = wakeTime > ticksNow ? counterNow + (wakeTime - ticksNow) * pacer->frequency / 1000 : counterNow;
+		if (wakeCounter < deadline)
+		{
+			deadline = wakeCounter;
+		}
+	}
+
+	while (true)
+	{
+		// hand out any event that is already waiting
+		if (SDL_PollEvent(event))
+		{
+			return true;
+		}
+
+		Uint64 now = SDL_GetPerformanceCounter();
+		if (now >= deadline)
+		{
+			return false;
+		}
+
+		// sleep until shortly before the deadline, waking early for events. the rest is spun
+		Uint64 remainingMs = (deadline - now) * 1000 / pacer->frequency;
+		if (remainingMs > PACER_SPIN_MS && SDL_WaitEventTimeout(event, (int) (remainingMs - PACER_SPIN_MS)))
+		{
+			return true;
+		}
+		else if (remainingMs == PACER_SPIN_MS)
+		{
+			SDL_Delay(1);
+		}
+	}
+}
+
+bool DueFramePacer(FramePacer *pacer)
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (now < pacer->nextFrameTime)
+	{
+		return false;
+	}
+
+	// schedule the next frame one period on. if the loop fell more than a frame behind,
+	// start over from now instead of rushing out frames to catch up
+	pacer->nextFrameTime += pacer->period;
+	if (pacer->nextFrameTime <= now)
+	{
+		pacer->nextFrameTime = now + pacer->period;
+	}
+
+	return true;
+}
+
+void DestroyFramePacer(FramePacer *pacer)
+{
+	free(pacer);
+}
@@ -0,0 +1,30 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare FramePacer struct.
+ */
+
+// schedules frames at a fixed rate and sleeps in between instead of spinning. the
+// waiting is done in SDL_WaitEventTimeout so input still wakes the loop right away,
+// and only the last moment before a frame is spun to keep frame times even
+typedef struct FramePacer
+{
+	Uint64 frequency;	// performance counter ticks per second
+	Uint64 period;	// performance counter ticks per frame, 0 to present every loop
+	Uint64 nextFrameTime;	// performance counter value when the next frame is due
+	bool isVsync;	// presenting waits for the display, so frames are never held back here
+} FramePacer;
+
+FramePacer *CreateFramePacer(int rate, bool isVsync);
+// rate, or the refresh rate of the window's display if rate is 0
+int GetWindowFrameRate(SDL_Window *window, int rate);
+bool WaitFramePacer(FramePacer *pacer, SDL_Event *event, Uint64 wakeTime);
+bool DueFramePacer(FramePacer *pacer);
+void DestroyFramePacer(FramePacer *pacer);
+
+#endif
@@ -0,0 +1,311 @@
+#include "profiler.h"
+#include "allocator.h"
+#include <stdio.h>
+
+
+// names of the phases in the overlay and the dumps
+static const char *PHASE_NAMES[PROFILE_PHASE_COUNT] = {"wait", "events", "step", "render", "copy", "present", "frame"};
+
+static int BucketOfProfile(Uint32 microseconds);
+static Uint32 BoundOfProfileBucket(int bucket);
+static Uint32 PercentileOfProfile(const Uint64 *buckets, Uint64 count, double fraction);
+
+FrameProfiler *CreateFrameProfiler(void)
+{
+	// the histograms start out empty
+	FrameProfiler *profiler = calloc(1, sizeof(FrameProfiler));
+	if (!profiler)
+	{
+		SDL_SetError("Failed to create frame profiler. (Failed to create FrameProfiler struct)");
+		return NULL;
+	}
+
+	profiler->frequency = SDL_GetPerformanceFrequency();
+	profiler->lastMark = SDL_GetPerformanceCounter();
+	profiler->lastAllocations = GetMemoryStats().allocations;
+
+	return profiler;
+}
+
+void MarkFrameProfiler(FrameProfiler *profiler, ProfilePhase phase)
+{
+	// charge the time since the previous mark to the phase that just ended
+	Uint64 now = SDL_GetPerformanceCounter();
+	profiler->pending[phase] += now - profiler->lastMark;
+	profiler->lastMark = now;
+}
+
+void CommitFrameProfiler(FrameProfiler *profiler)
+{
+	Uint32 *slot = profiler->window[profiler->windowHead];
+	bool isFull = profiler->frameCount >= PROFILE_WINDOW;
+
+	// the frame time is the sum of its phases
+	profiler->pending[PROFILE_FRAME] = 0;
+	for (int phase = 0; phase < PROFILE_FRAME; ++phase)
+	{
+		profiler->pending[PROFILE_FRAME] += profiler->pending[phase];
+	}
+
+	for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+	{
+		// the oldest frame leaves the rolling histogram once the window is full
+		if (isFull)
+		{
+			--profiler->windowBuckets[phase][BucketOfProfile(slot[phase])];
+		}
+
+		Uint64 microseconds = profiler->pending[phase] * 1000000 / profiler->frequency;
+		slot[phase] = microseconds > 0xFFFFFFFF ? 0xFFFFFFFF : (Uint32) microseconds;
+		profiler->pending[phase] = 0;
+
+		int bucket = BucketOfProfile(slot[phase]);
+		++profiler->windowBuckets[phase][bucket];
+		++profiler->sessionBuckets[phase][bucket];
+		profiler->sessionTotal[phase] += slot[phase];
+		if (slot[phase] > profiler->sessionMax[phase])
+		{
+			profiler->sessionMax[phase] = slot[phase];
+		}
+	}
+
+	profiler->windowHead = (profiler->windowHead + 1) % PROFILE_WINDOW;
+	++profiler->frameCount;
+
+	// charge the allocations since the last commit to this frame
+	Uint64 allocations = GetMemoryStats().allocations;
+	profiler->frameAllocations = allocations - profiler->lastAllocations;
+	profiler->sessionAllocations += profiler->frameAllocations;
+	profiler->allocatingFrames += profiler->frameAllocations > 0;
+	profiler->lastAllocations = allocations;
+
+	// the inputs taken since the last commit are on screen now that this frame is presented
+	Uint64 now = SDL_GetTicks64();
+	for (int i = 0; i < profiler->inputCount; ++i)
+	{
+		Uint64 microseconds = (now > profiler->inputTimes[i] ? now - profiler->inputTimes[i] : 0) * 1000;
+		Uint32 latency = microseconds > 0xFFFFFFFF ? 0xFFFFFFFF : (Uint32) microseconds;
+		++profiler->latencyBuckets[BucketOfProfile(latency)];
+		++profiler->latencyCount;
+		profiler->latencyTotal += latency;
+		if (latency > profiler->latencyMax)
+		{
+			profiler->latencyMax = latency;
+		}
+	}
+	profiler->inputCount = 0;
+}
+
+void SkipFrameProfiler(FrameProfiler *profiler)
+{
+	// drop the time since the last commit, e.g. time spent outside the loop in a menu
+	for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+	{
+		profiler->pending[phase] = 0;
+	}
+	profiler->lastMark = SDL_GetPerformanceCounter();
+	profiler->lastAllocations = GetMemoryStats().allocations;
+
+	// inputs that waited out the skipped time would count it as latency
+	profiler->inputCount = 0;
+}
+
+void AddInputFrameProfiler(FrameProfiler *profiler, Uint64 inputTime)
+{
+	// an input the game just took, with the time its event was made. it is timed at the next commit.
+	// more inputs than fit between two commits are not timed
+	if (profiler->inputCount < PROFILE_MAX_INPUTS)
+	{
+		profiler->inputTimes[profiler->inputCount++] = inputTime;
+	}
+}
+
+void QueryFrameProfiler(FrameProfiler *profiler, ProfilePhase phase, Uint32 *p50, Uint32 *p99, Uint32 *max)
+{
+	Uint32 count = profiler->frameCount < PROFILE_WINDOW ? (Uint32) profiler->frameCount : PROFILE_WINDOW;
+
+	// percentiles come from the histogram, to within a bucket. the max is exact
+	*p50 = PercentileOfProfile(profiler->windowBuckets[phase], count, 0.50);
+	*p99 = PercentileOfProfile(profiler->windowBuckets[phase], count, 0.99);
+	*max = 0;
+	for (Uint32 i = 0; i < count; ++i)
+	{
+		if (profiler->window[i][phase] > *max)
+		{
+			*max = profiler->window[i][phase];
+		}
+	}
+}
+
+bool OverlayFrameProfiler(FrameProfiler *profiler, GlyphAtlas *atlas, int x, int y, SDL_Color *color)
+{
+	// one line per phase with the rolling p50, p99 and max in milliseconds
+	char line[64];
+	snprintf(line, sizeof(line), "%-8s %7s %7s %7s", "ms", "p50", "p99", "max");
+	if (!AddTextGlyphAtlas(atlas, line, x, y, color))
+	{
+		return false;
+	}
+
+	for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+	{
+		Uint32 p50, p99, max;
+		QueryFrameProfiler(profiler, phase, &p50, &p99, &max);
+		snprintf(line, sizeof(line), "%-8s %7.2f %7.2f %7.2f", PHASE_NAMES[phase], p50 / 1000.0, p99 / 1000.0, max / 1000.0);
+
+		y += atlas->lineHeight;
+		if (!AddTextGlyphAtlas(atlas, line, x, y, color))
+		{
+			return false;
+		}
+	}
+
+	// then the input to present latency over the whole session
+	snprintf(line, sizeof(line), "%-8s %7.2f %7.2f %7.2f", "input", PercentileOfProfile(profiler->latencyBuckets, profiler->latencyCount, 0.50) / 1000.0,
+			PercentileOfProfile(profiler->latencyBuckets, profiler->latencyCount, 0.99) / 1000.0, profiler->latencyMax / 1000.0);
+	y += atlas->lineHeight;
+	if (!AddTextGlyphAtlas(atlas, line, x, y, color))
+	{
+		return false;
+	}
+
+	// then the heap allocations of the last frame and of the whole session
+	snprintf(line, sizeof(line), "%-8s %7llu %15llu", "allocs", (unsigned long long) profiler->frameAllocations, (unsigned long long) profiler->sessionAllocations);
+
+	return AddTextGlyphAtlas(atlas, line, x, y + atlas->lineHeight, color);
+}
+
+bool WriteFrameProfiler(FrameProfiler *profiler, const char *basePath)
+{
+	char path[256];
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Write the microseconds of every phase of the recent frames, oldest first, as CSV.
+	 */
+
+	snprintf(path, sizeof(path), "%s.csv", basePath);
+	FILE *file = fopen(path, "w");
+	if (!file)
+	{
+		SDL_SetError("Failed to write frame profile. (Failed to open %s)", path);
+		return false;
+	}
+
+	fprintf(file, "frame");
+	for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+	{
+		fprintf(file, ",%s_us", PHASE_NAMES[phase]);
+	}
+	fprintf(file, "\n");
+
+	Uint64 count = profiler->frameCount < PROFILE_WINDOW ? profiler->frameCount : PROFILE_WINDOW;
+	for (Uint64 i = 0; i < count; ++i)
+	{
+		Uint64 frame = profiler->frameCount - count + i;
+		Uint32 *slot = profiler->window[frame % PROFILE_WINDOW];
+		fprintf(file, "%llu", (unsigned long long) frame);
+		for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+		{
+			fprintf(file, ",%u", (unsigned) slot[phase]);
+		}
+		fprintf(file, "\n");
+	}
+
+	if (fclose(file) != 0)
+	{
+		SDL_SetError("Failed to write frame profile. (Failed to write %s)", path);
+		return false;
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Write the statistics of every phase over the whole session as JSON.
+	 */
+
+	snprintf(path, sizeof(path), "%s.json", basePath);
+	file = fopen(path, "w");
+	if (!file)
+	{
+		SDL_SetError("Failed to write frame profile. (Failed to open %s)", path);
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"frames\": %llu,\n\t\"phases\": {\n", (unsigned long long) profiler->frameCount);
+	for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+	{
+		const Uint64 *buckets = profiler->sessionBuckets[phase];
+		Uint64 frames = profiler->frameCount;
+		fprintf(file, "\t\t\"%s\": {\"meanUs\": %.1f, \"p50Us\": %u, \"p90Us\": %u, \"p99Us\": %u, \"p999Us\": %u, \"maxUs\": %u}%s\n",
+				PHASE_NAMES[phase], frames ? (double) profiler->sessionTotal[phase] / frames : 0.0,
+				(unsigned) PercentileOfProfile(buckets, frames, 0.50), (unsigned) PercentileOfProfile(buckets, frames, 0.90),
+				(unsigned) PercentileOfProfile(buckets, frames, 0.99), (unsigned) PercentileOfProfile(buckets, frames, 0.999),
+				(unsigned) profiler->sessionMax[phase], phase + 1 < PROFILE_PHASE_COUNT ? "," : "");
+	}
+	fprintf(file, "\t},\n\t\"inputLatency\": {\"inputs\": %llu, \"meanUs\": %.1f, \"p50Us\": %u, \"p90Us\": %u, \"p99Us\": %u, \"maxUs\": %u},\n",
+			(unsigned long long) profiler->latencyCount, profiler->latencyCount ? (double) profiler->latencyTotal / profiler->latencyCount : 0.0,
+			(unsigned) PercentileOfProfile(profiler->latencyBuckets, profiler->latencyCount, 0.50), (unsigned) PercentileOfProfile(profiler->latencyBuckets, profiler->latencyCount, 0.90),
+			(unsigned) PercentileOfProfile(profiler->latencyBuckets, profiler->latencyCount, 0.99), (unsigned) profiler->latencyMax);
+	fprintf(file, "\t\"heapAllocations\": %llu,\n\t\"allocatingFrames\": %llu\n}\n",
+			(unsigned long long) profiler->sessionAllocations, (unsigned long long) profiler->allocatingFrames);
+
+	if (fclose(file) != 0)
+	{
+		SDL_SetError("Failed to write frame profile. (Failed to write %s)", path);
+		return false;
+	}
+
+	return true;
+}
+
+void DestroyFrameProfiler(FrameProfiler *profiler)
+{
+	free(profiler);
+}
+
+static int BucketOfProfile(Uint32 microseconds)
+{
+	if (microseconds < 16)
+	{
+		return (int) microseconds;
+	}
+
+	// the top bit picks the power of two, the 3 bits below it pick one of 8 buckets within it
+	int exponent = 31;
+	while (!(microseconds & (1u << exponent)))
+	{
+		--exponent;
+	}
+
+	return 16 + (exponent - 4) * 8 + (int) ((microseconds >> (exponent - 3)) & 7);
+}
+
+static Uint32 BoundOfProfileBucket(int bucket)
+{
+	// the largest value that falls in the bucket, so percentiles never read low
+	if (bucket < 16)
+	{
+		return (Uint32) bucket;
+	}
+
+	int exponent = (bucket - 16) / 8 + 4;
+	Uint64 lower = (Uint64) (8 + (bucket - 16) % 8) << (exponent - 3);
+	Uint64 upper = lower + ((Uint64) 1 << (exponent - 3)) - 1;
+
+	return upper > 0xFFFFFFFF ? 0xFFFFFFFF : (Uint32) upper;
+}
+
+static Uint32 PercentileOfProfile(const Uint64 *buckets, Uint64 count, double fraction)
+{
+	// walk the buckets until the given fraction of the samples is covered
+	Uint64 rank = (Uint64) (count * fraction);
+	Uint64 seen = 0;
+	for (int bucket = 0; bucket < PROFILE_BUCKET_COUNT; ++bucket)
+	{
+		seen += buckets[bucket];
+		if (seen > rank)
+		{
+			return BoundOfProfileBucket(bucket);
+		}
+	}
+
+	return 0;
+}
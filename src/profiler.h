@@ -0,0 +1,78 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "texture.h"
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare ProfilePhase enum.
+ */
+
+// parts of a frame the play loop is split into. PROFILE_FRAME is the sum of the others
+typedef enum ProfilePhase
+{
+	PROFILE_WAIT,	// sleeping and spinning in the frame pacer
+	PROFILE_EVENTS,	// handling the events the pacer hands out
+	PROFILE_STEP,	// taking the newest snapshot of the game and catching up on its ticks
+	PROFILE_RENDER,	// drawing the board onto the buffer and the text on top
+	PROFILE_COPY,	// copying the buffer to the screen
+	PROFILE_PRESENT,	// presenting the frame
+	PROFILE_FRAME,
+	PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+// frames the rolling statistics and the CSV dump cover
+#define PROFILE_WINDOW 256
+// histogram buckets per phase: exact below 16 microseconds, then 8 per power of two
+#define PROFILE_BUCKET_COUNT 240
+// most inputs that can wait for one present to show them
+#define PROFILE_MAX_INPUTS 16
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare FrameProfiler struct.
+ */
+
+// times each phase of every frame with the performance counter. a mark charges the time since the
+// previous mark to a phase, so the loop only reads the counter once per phase. committed frames
+// go into a rolling histogram of the last PROFILE_WINDOW frames and into one for the whole session.
+// it also counts the heap allocations each frame makes through the allocator, which should be none
+// once the loop is running, and times every input from its key going down to the present that
+// first shows it
+typedef struct FrameProfiler
+{
+	Uint64 frequency;	// performance counter ticks per second
+	Uint64 lastMark;	// performance counter value of the previous mark
+	Uint64 pending[PROFILE_PHASE_COUNT];	// ticks charged to each phase since the last commit
+	Uint32 window[PROFILE_WINDOW][PROFILE_PHASE_COUNT];	// microseconds of the recent frames, a ring
+	int windowHead;	// slot the next frame goes into
+	Uint64 windowBuckets[PROFILE_PHASE_COUNT][PROFILE_BUCKET_COUNT];	// histogram of the recent frames
+	Uint64 sessionBuckets[PROFILE_PHASE_COUNT][PROFILE_BUCKET_COUNT];	// histogram of every frame
+	Uint64 sessionTotal[PROFILE_PHASE_COUNT];	// microseconds over every frame
+	Uint32 sessionMax[PROFILE_PHASE_COUNT];
+	Uint64 frameCount;	// frames committed
+	Uint64 lastAllocations;	// heap allocations made by the program up to the previous commit or skip
+	Uint64 frameAllocations;	// heap allocations made during the last committed frame
+	Uint64 sessionAllocations;	// heap allocations made during every committed frame
+	Uint64 allocatingFrames;	// committed frames that allocated at all
+	Uint64 inputTimes[PROFILE_MAX_INPUTS];	// SDL_GetTicks64 time of each input taken since the last commit
+	int inputCount;
+	Uint64 latencyBuckets[PROFILE_BUCKET_COUNT];	// histogram of the input to present latency of every input
+	Uint64 latencyCount;	// inputs timed
+	Uint64 latencyTotal;	// microseconds over every input
+	Uint32 latencyMax;
+} FrameProfiler;
+
+FrameProfiler *CreateFrameProfiler(void);
+void MarkFrameProfiler(FrameProfiler *profiler, ProfilePhase phase);
+void CommitFrameProfiler(FrameProfiler *profiler);
+void SkipFrameProfiler(FrameProfiler *profiler);
+void AddInputFrameProfiler(FrameProfiler *profiler, Uint64 inputTime);
+void QueryFrameProfiler(FrameProfiler *profiler, ProfilePhase phase, Uint32 *p50, Uint32 *p99, Uint32 *max);
+bool OverlayFrameProfiler(FrameProfiler *profiler, GlyphAtlas *atlas, int x, int y, SDL_Color *color);
+bool WriteFrameProfiler(FrameProfiler *profiler, const char *basePath);
+void DestroyFrameProfiler(FrameProfiler *profiler);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare Random struct.
+ */
+
+// small seedable generator (PCG32) owned by each game or world instead of the global rand(),
+// so the same seed and inputs always play out the same, on any platform and C library
+typedef struct Random
+{
+	uint64_t state;
+	uint64_t increment;	// always odd
+} Random;
+
+static inline uint32_t NextRandom(Random *random)
+{
+	uint64_t state = random->state;
+	random->state = state * 6364136223846793005ULL + random->increment;
+
+	// permute the old state into the output
+	uint32_t xorShifted = (uint32_t) (((state >> 18) ^ state) >> 27);
+	uint32_t rotation = (uint32_t) (state >> 59);
+	return (xorShifted >> rotation) | (xorShifted << ((-rotation) & 31));
+}
+
+static inline void SeedRandom(Random *random, uint64_t seed)
+{
+	random->state = 0;
+	random->increment = (seed << 1) | 1;
+	NextRandom(random);
+	random->state += seed;
+	NextRandom(random);
+}
+
+// uniform value in [0, bound), bound must be above 0. values that would bias the result are redrawn
+static inline uint32_t RangeRandom(Random *random, uint32_t bound)
+{
+	uint32_t threshold = (0u - bound) % bound;
+	uint32_t value;
+	do
+	{
+		value = NextRandom(random);
+	}
+	while (value < threshold);
+
+	return value % bound;
+}
+
+#endif
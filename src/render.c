@@ -0,0 +1,437 @@
+#include "render.h"
+#include "allocator.h"
+
+
+static void CenterCamera(Camera *camera, int x, int y);
+static void ClampCamera(Camera *camera);
+static int GapToSpan(int position, int first, int count, int size);
+static bool BatchBoardCells(RenderBatch *batch, Board *board, const SDL_Rect *visible, SDL_Color color, int xOrigin, int yOrigin, int cellSize);
+static SDL_FRect SliceCell(int xOrigin, int yOrigin, int cellSize, SnakeCell *cell, int xToward, int yToward, float fraction);
+
+void InitCamera(Camera *camera, SDL_Rect view, int boardWidth, int boardHeight, int cellSize)
+{
+	camera->view = view;
+	camera->boardWidth = boardWidth;
+	camera->boardHeight = boardHeight;
+	camera->cellSize = cellSize < CAMERA_MIN_CELL ? CAMERA_MIN_CELL : cellSize > CAMERA_MAX_CELL ? CAMERA_MAX_CELL : cellSize;
+	camera->isFollowing = true;
+
+	// start on the middle of the board
+	CenterCamera(camera, boardWidth / 2, boardHeight / 2);
+}
+
+void FollowCamera(Camera *camera, int x, int y)
+{
+	if (!camera->isFollowing)
+	{
+		return;
+	}
+
+	// move only once the cell nears an edge of the view, so on most ticks the view stays put and the
+	// board layer keeps drawing just the changed cells
+	SDL_Rect *cells = &camera->cells;
+	int xMargin = cells->w / 4, yMargin = cells->h / 4;
+	if (x < cells->x + xMargin || x >= cells->x + cells->w - xMargin || y < cells->y + yMargin || y >= cells->y + cells->h - yMargin)
+	{
+		CenterCamera(camera, x, y);
+	}
+}
+
+void PanCamera(Camera *camera, int xCells, int yCells)
+{
+	// a panned camera stays where it was put until it is told to follow again
+	camera->isFollowing = false;
+	camera->cells.x += xCells;
+	camera->cells.y += yCells;
+	ClampCamera(camera);
+}
+
+void ZoomCamera(Camera *camera, int steps)
+{
+	// each step doubles or halves the size of a cell, keeping the middle of the view in place.
+	// zooming out stops once the whole board is in view
+	int x = camera->cells.x + camera->cells.w / 2, y = camera->cells.y + camera->cells.h / 2;
+	for (; steps < 0 && camera->cellSize / 2 >= CAMERA_MIN_CELL && (camera->cells.w < camera->boardWidth || camera->cells.h < camera->boardHeight); ++steps)
+	{
+		camera->cellSize /= 2;
+		CenterCamera(camera, x, y);
+	}
+
+	for (; steps > 0 && camera->cellSize * 2 <= CAMERA_MAX_CELL; --steps)
+	{
+		camera->cellSize *= 2;
+	}
+
+	CenterCamera(camera, x, y);
+}
+
+BoardLayer *CreateBoardLayer(const Camera *camera)
+{
+	BoardLayer *layer = AllocMemory(sizeof(BoardLayer));
+	if (!layer)
+	{
+		SDL_SetError("Failed to create board layer. (Failed to create BoardLayer struct)");
+		return NULL;
+	}
+
+	// nothing is on the target yet
+	layer->shownCells = (SDL_Rect) {0, 0, 0, 0};
+	layer->shownCellSize = 0;
+
+	// a few ticks worth of changes fit before the layer gives up and redraws in full
+	layer->dirtyCapacity = GAME_MAX_CHANGES * 16;
+	layer->dirtyCount = 0;
+	layer->dirtyCells = AllocMemory(layer->dirtyCapacity * sizeof(SnakeCell));
+	// a full redraw batches a quad for every cell in view, so the batch is made big enough for the
+	// most cells the camera can show instead of growing the first time it zooms out
+	int columns = camera->view.w / CAMERA_MIN_CELL < camera->boardWidth ? camera->view.w / CAMERA_MIN_CELL : camera->boardWidth;
+	int rows = camera->view.h / CAMERA_MIN_CELL < camera->boardHeight ? camera->view.h / CAMERA_MIN_CELL : camera->boardHeight;
+	layer->batch = CreateRenderBatch(columns * rows > layer->dirtyCapacity ? columns * rows : layer->dirtyCapacity);
+	if (!(layer->dirtyCells && layer->batch))
+	{
+		SDL_SetError("Failed to create board layer. (Failed to create dirty cell list)");
+		FreeMemory(layer->dirtyCells);
+		if (layer->batch)
+		{
+			DestroyRenderBatch(layer->batch);
+		}
+		FreeMemory(layer);
+		return NULL;
+	}
+
+	// nothing has been drawn yet
+	layer->isStale = true;
+
+	return layer;
+}
+
+void MarkBoardLayer(BoardLayer *layer, const SnakeCell *cells, int count)
+{
+	// once stale, every cell is drawn anyway
+	if (layer->isStale)
+	{
+		return;
+	}
+
+	if (layer->dirtyCount + count > layer->dirtyCapacity)
+	{
+		InvalidateBoardLayer(layer);
+		return;
+	}
+
+	memcpy(layer->dirtyCells + layer->dirtyCount, cells, count * sizeof(SnakeCell));
+	layer->dirtyCount += count;
+}
+
+void InvalidateBoardLayer(BoardLayer *layer)
+{
+	layer->isStale = true;
+	layer->dirtyCount = 0;
+}
+
+bool UpdateBoardLayer(SDL_Renderer *renderer, BoardLayer *layer, Game *game, const Camera *camera, Texture *foodTexture)
+{
+	SDL_Color background = {0xe0, 0xb0, 0xff, 0xff};
+	SDL_Color snakeColor = {game->player->color.r, game->player->color.g, game->player->color.b, game->player->color.a};
+	const SDL_Rect *cells = &camera->cells;
+	int cellSize = camera->cellSize;
+	int xOrigin, yOrigin;
+	GetCameraOrigin(camera, &xOrigin, &yOrigin);
+	bool isFoodDirty = false;
+
+	// a camera that moved or zoomed puts every cell somewhere else on the target
+	if (cellSize != layer->shownCellSize || cells->x != layer->shownCells.x || cells->y != layer->shownCells.y || cells->w != layer->shownCells.w || cells->h != layer->shownCells.h)
+	{
+		InvalidateBoardLayer(layer);
+	}
+
+	ClearRenderBatch(layer->batch);
+
+	if (layer->isStale)
+	{
+		// clear frame, draw the play area in view and the snake in it
+		SDL_Rect area = {camera->view.x, camera->view.y, cells->w * cellSize, cells->h * cellSize};
+		if (SDL_SetRenderDrawColor(renderer, 0xad, 0xd8, 0xe6, 0xff) != 0 || SDL_RenderClear(renderer) != 0 ||
+			SDL_SetRenderDrawColor(renderer, background.r, background.g, background.b, background.a) != 0 || SDL_RenderFillRect(renderer, &area) != 0)
+		{
+			SDL_SetError("Failed to update board layer. (Play area failed to render)");
+			return false;
+		}
+
+		// walk whichever is shorter, the snake or the cells in view, so a long snake on a big board
+		// costs no more than the view
+		bool isBatched = game->player->length <= cells->w * cells->h ?
+			BatchSnake(layer->batch, game->player, cells, xOrigin, yOrigin, cellSize, cellSize) :
+			BatchBoardCells(layer->batch, game->board, cells, snakeColor, xOrigin, yOrigin, cellSize);
+		if (!isBatched)
+		{
+			return false;
+		}
+
+		layer->shownCells = *cells;
+		layer->shownCellSize = cellSize;
+		isFoodDirty = true;
+	}
+	else
+	{
+		// draw each dirty cell in view as whatever is on it now, covering what was there before
+		for (int i = 0; i < layer->dirtyCount; ++i)
+		{
+			SnakeCell *cell = &layer->dirtyCells[i];
+			if (!IsVisibleCell(cells, cell->xPos, cell->yPos))
+			{
+				continue;
+			}
+
+			SDL_FRect rect = {xOrigin + cell->xPos * cellSize, yOrigin + cell->yPos * cellSize, cellSize, cellSize};
+			SDL_Color color = IsFreeBoardCell(game->board, cell->xPos, cell->yPos) ? background : snakeColor;
+
+			if (!AddQuadRenderBatch(layer->batch, &rect, color, NULL))
+			{
+				return false;
+			}
+
+			isFoodDirty = isFoodDirty || (cell->xPos == game->food.xPos && cell->yPos == game->food.yPos);
+		}
+	}
+
+	// the food goes on top of its cell's background
+	if (!DrawRenderBatch(renderer, layer->batch, NULL) || (isFoodDirty && !RenderFood(renderer, &game->food, foodTexture, cells, xOrigin, yOrigin, cellSize, cellSize)))
+	{
+		return false;
+	}
+
+	layer->isStale = false;
+	layer->dirtyCount = 0;
+
+	return true;
+}
+
+bool RenderSnakeMotion(SDL_Renderer *renderer, BoardLayer *layer, Game *game, const Camera *camera, float progress)
+{
+	SDL_Color background = {0xe0, 0xb0, 0xff, 0xff};
+	Snake *player = game->player;
+	SDL_Color snakeColor = {player->color.r, player->color.g, player->color.b, player->color.a};
+	const SDL_Rect *cells = &camera->cells;
+	int xOrigin, yOrigin;
+	GetCameraOrigin(camera, &xOrigin, &yOrigin);
+
+	// a finished game or one that has not moved yet holds still, and so does one whose next tick is due
+	if (game->isOver || game->changeCount < 2 || progress >= 1)
+	{
+		return true;
+	}
+	progress = progress < 0 ? 0 : progress;
+
+	ClearRenderBatch(layer->batch);
+
+	// the head comes in from the side of the cell it left, in the direction it moved
+	SnakeCell *head = SnakeHead(player);
+	int xMove = player->currentDirection == SNAKE_RIGHT ? 1 : player->currentDirection == SNAKE_LEFT ? -1 : 0;
+	int yMove = player->currentDirection == SNAKE_DOWN ? 1 : player->currentDirection == SNAKE_UP ? -1 : 0;
+	if (IsVisibleCell(cells, head->xPos, head->yPos))
+	{
+		SDL_FRect cell = SliceCell(xOrigin, yOrigin, camera->cellSize, head, 0, 0, 1);
+		SDL_FRect slice = SliceCell(xOrigin, yOrigin, camera->cellSize, head, -xMove, -yMove, progress);
+		if (!AddQuadRenderBatch(layer->batch, &cell, background, NULL) || !AddQuadRenderBatch(layer->batch, &slice, snakeColor, NULL))
+		{
+			return false;
+		}
+	}
+
+	// the tail leaves its old cell toward the new tail, unless the snake grew and the old tail stayed
+	SnakeCell *oldTail = &game->changes[0];
+	if (IsFreeBoardCell(game->board, oldTail->xPos, oldTail->yPos) && IsVisibleCell(cells, oldTail->xPos, oldTail->yPos))
+	{
+		// the new tail is a neighbour, or on the far edge when the tail wrapped around the board
+		SnakeCell *tail = SnakeTail(player);
+		int xToward = tail->xPos - oldTail->xPos, yToward = tail->yPos - oldTail->yPos;
+		xToward = xToward > 1 ? -1 : xToward < -1 ? 1 : xToward;
+		yToward = yToward > 1 ? -1 : yToward < -1 ? 1 : yToward;
+
+		SDL_FRect slice = SliceCell(xOrigin, yOrigin, camera->cellSize, oldTail, xToward, yToward, 1 - progress);
+		if (!AddQuadRenderBatch(layer->batch, &slice, snakeColor, NULL))
+		{
+			return false;
+		}
+	}
+
+	return DrawRenderBatch(renderer, layer->batch, NULL);
+}
+
+void DestroyBoardLayer(BoardLayer *layer)
+{
+	DestroyRenderBatch(layer->batch);
+	FreeMemory(layer->dirtyCells);
+	FreeMemory(layer);
+}
+
+bool BatchSnake(RenderBatch *batch, Snake *snake, const SDL_Rect *visible, int xOrigin, int yOrigin, int xMultiplier, int yMultiplier)
+{
+	SDL_Color color = {snake->color.r, snake->color.g, snake->color.b, snake->color.a};
+
+	for (int i = 0; i < snake->length; ++i)
+	{
+		SnakeCell *cur = SnakeCellAt(snake, i);
+		if (!IsVisibleCell(visible, cur->xPos, cur->yPos))
+		{
+			continue;
+		}
+
+		SDL_FRect rect = {xOrigin + cur->xPos * xMultiplier, yOrigin + cur->yPos * yMultiplier, xMultiplier, yMultiplier};
+		if (!AddQuadRenderBatch(batch, &rect, color, NULL))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool BatchWorld(RenderBatch *snakeBatch, RenderBatch *foodBatch, World *world, const SDL_Rect *visible, int xOrigin, int yOrigin, int xMultiplier, int yMultiplier)
+{
+	// every living snake goes in one batch, each in its own color
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		// every cell of a body is fewer steps from its head than the body is long, so a snake whose
+		// head is farther than that from the view is passed over without walking its body
+		int length = world->length[snake];
+		if (visible && GapToSpan(world->headX[snake], visible->x, visible->w, world->width) + GapToSpan(world->headY[snake], visible->y, visible->h, world->height) >= length)
+		{
+			continue;
+		}
+
+		SDL_Color color = {world->color[snake].r, world->color[snake].g, world->color[snake].b, world->color[snake].a};
+
+		for (int i = 0; i < length; ++i)
+		{
+			SnakeCell *cur = WorldSnakeCellAt(world, snake, i);
+			if (!IsVisibleCell(visible, cur->xPos, cur->yPos))
+			{
+				continue;
+			}
+
+			SDL_FRect rect = {xOrigin + cur->xPos * xMultiplier, yOrigin + cur->yPos * yMultiplier, xMultiplier, yMultiplier};
+			if (!AddQuadRenderBatch(snakeBatch, &rect, color, NULL))
+			{
+				return false;
+			}
+		}
+	}
+
+	// the food is drawn with the whole food texture, which the caller passes to DrawRenderBatch
+	SDL_FRect textureRect = {0, 0, 1, 1};
+	for (int food = 0; food < world->foodCount; ++food)
+	{
+		if (world->foods[food].xPos < 0 || !IsVisibleCell(visible, world->foods[food].xPos, world->foods[food].yPos))
+		{
+			continue;
+		}
+
+		SDL_FRect rect = {xOrigin + world->foods[food].xPos * xMultiplier, yOrigin + world->foods[food].yPos * yMultiplier, xMultiplier, yMultiplier};
+		if (!AddQuadRenderBatch(foodBatch, &rect, (SDL_Color) {0xFF, 0xFF, 0xFF, 0xFF}, &textureRect))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool RenderFood(SDL_Renderer *renderer, Food *food, Texture *texture, const SDL_Rect *visible, int xOrigin, int yOrigin, int xMultiplier, int yMultiplier)
+{
+	// food out of view has nothing to draw
+	if (!IsVisibleCell(visible, food->xPos, food->yPos))
+	{
+		return true;
+	}
+
+	// draw the food texture over the food's cell, at the cell's size so it follows the zoom
+	SDL_Rect rect = {xOrigin + food->xPos * xMultiplier, yOrigin + food->yPos * yMultiplier, xMultiplier, yMultiplier};
+	if (SDL_RenderCopy(renderer, texture->texture, NULL, &rect) != 0)
+	{
+		return false;
+	}
+
+	return true;	
+}
+
+static void CenterCamera(Camera *camera, int x, int y)
+{
+	// show as many whole cells as fit in the view, up to the whole board
+	int columns = camera->view.w / camera->cellSize, rows = camera->view.h / camera->cellSize;
+	camera->cells.w = columns < camera->boardWidth ? columns : camera->boardWidth;
+	camera->cells.h = rows < camera->boardHeight ? rows : camera->boardHeight;
+	camera->cells.x = x - camera->cells.w / 2;
+	camera->cells.y = y - camera->cells.h / 2;
+	ClampCamera(camera);
+}
+
+static void ClampCamera(Camera *camera)
+{
+	// keep the view on the board, so the origin and multipliers place every cell in view without
+	// having to wrap it around the board's edges
+	int xMax = camera->boardWidth - camera->cells.w, yMax = camera->boardHeight - camera->cells.h;
+	camera->cells.x = camera->cells.x < 0 ? 0 : camera->cells.x > xMax ? xMax : camera->cells.x;
+	camera->cells.y = camera->cells.y < 0 ? 0 : camera->cells.y > yMax ? yMax : camera->cells.y;
+}
+
+static int GapToSpan(int position, int first, int count, int size)
+{
+	// steps from position to the nearest of the count cells from first, going either way around a
+	// board edge size cells long
+	int offset = ((position - first) % size + size) % size;
+	if (offset < count)
+	{
+		return 0;
+	}
+
+	int after = offset - count + 1, before = size - offset;
+
+	return after < before ? after : before;
+}
+
+static bool BatchBoardCells(RenderBatch *batch, Board *board, const SDL_Rect *visible, SDL_Color color, int xOrigin, int yOrigin, int cellSize)
+{
+	// a quad for every taken cell in view
+	for (int y = visible->y; y < visible->y + visible->h; ++y)
+	{
+		for (int x = visible->x; x < visible->x + visible->w; ++x)
+		{
+			if (IsFreeBoardCell(board, x, y))
+			{
+				continue;
+			}
+
+			SDL_FRect rect = {xOrigin + x * cellSize, yOrigin + y * cellSize, cellSize, cellSize};
+			if (!AddQuadRenderBatch(batch, &rect, color, NULL))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static SDL_FRect SliceCell(int xOrigin, int yOrigin, int cellSize, SnakeCell *cell, int xToward, int yToward, float fraction)
+{
+	// the part of a cell along its side facing xToward, yToward, fraction of the cell deep. a side of
+	// 0, 0 takes the whole cell
+	SDL_FRect rect = {xOrigin + cell->xPos * cellSize, yOrigin + cell->yPos * cellSize, cellSize, cellSize};
+	float depth = fraction * cellSize;
+
+	if (xToward != 0)
+	{
+		rect.x += xToward > 0 ? cellSize - depth : 0;
+		rect.w = depth;
+	}
+
+	if (yToward != 0)
+	{
+		rect.y += yToward > 0 ? cellSize - depth : 0;
+		rect.h = depth;
+	}
+
+	return rect;
+}
@@ -0,0 +1,83 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "game.h"
+#include "snake.h"
+#include "texture.h"
+#include "world.h"
+
+
+// smallest and biggest size of a cell on screen, in pixels
+#define CAMERA_MIN_CELL 4
+#define CAMERA_MAX_CELL 64
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare Camera, BoardLayer structs.
+ */
+
+// the part of a board shown in a view on the render target. only whole cells are shown, and the
+// cells in view are what gets drawn, so a frame costs the view instead of the board
+typedef struct Camera
+{
+	SDL_Rect view;	// most of the render target the board may cover
+	int boardWidth, boardHeight;	// size of the board in cells
+	int cellSize;	// size of each cell on the render target, changed by zooming
+	SDL_Rect cells;	// first column and row in view, and the number of each
+	bool isFollowing;	// keep the followed cell in view, until the camera is panned
+} Camera;
+
+// draws a game onto a render target that keeps its contents between frames. after one full
+// draw, only the cells marked dirty are drawn again, so a tick costs a few cells instead of
+// the whole board. the layer is redrawn in full when it goes stale, e.g. after the target was lost
+// or the camera moved
+typedef struct BoardLayer
+{
+	SDL_Rect shownCells;	// cells of the board on the target, the camera's when the layer was drawn
+	int shownCellSize;	// size of those cells on the target
+	SnakeCell *dirtyCells;	// cells to draw on the next update
+	int dirtyCount, dirtyCapacity;
+	bool isStale;	// the whole target has to be drawn on the next update
+	RenderBatch *batch;	// cell quads of one update
+} BoardLayer;
+
+void InitCamera(Camera *camera, SDL_Rect view, int boardWidth, int boardHeight, int cellSize);
+void FollowCamera(Camera *camera, int x, int y);
+void PanCamera(Camera *camera, int xCells, int yCells);
+void ZoomCamera(Camera *camera, int steps);
+
+// where cell 0, 0 would be drawn, to pass as the origin of the draw calls below
+static inline void GetCameraOrigin(const Camera *camera, int *xOrigin, int *yOrigin)
+{
+	*xOrigin = camera->view.x - camera->cells.x * camera->cellSize;
+	*yOrigin = camera->view.y - camera->cells.y * camera->cellSize;
+}
+
+BoardLayer *CreateBoardLayer(const Camera *camera);
+void MarkBoardLayer(BoardLayer *layer, const SnakeCell *cells, int count);
+void InvalidateBoardLayer(BoardLayer *layer);
+bool UpdateBoardLayer(SDL_Renderer *renderer, BoardLayer *layer, Game *game, const Camera *camera, Texture *foodTexture);
+// the layer shows the game at its last tick. this slides the player's head into its cell and the tail
+// out of the cell it left, progress being how far the clock is from that tick to the next, 0 to 1.
+// it draws over a copy of the layer on the current target, never into the layer itself
+bool RenderSnakeMotion(SDL_Renderer *renderer, BoardLayer *layer, Game *game, const Camera *camera, float progress);
+void DestroyBoardLayer(BoardLayer *layer);
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare functions that draw the game objects from the headless core. Each draws only the cells
+ * inside visible, e.g. a camera's cells, or every cell if visible is NULL.
+ */
+
+bool BatchSnake(RenderBatch *batch, Snake *snake, const SDL_Rect *visible, int xOrigin, int yOrigin, int xMultiplier, int yMultiplier);
+bool BatchWorld(RenderBatch *snakeBatch, RenderBatch *foodBatch, World *world, const SDL_Rect *visible, int xOrigin, int yOrigin, int xMultiplier, int yMultiplier);
+bool RenderFood(SDL_Renderer *renderer, Food *food, Texture *texture, const SDL_Rect *visible, int xOrigin, int yOrigin, int xMultiplier, int yMultiplier);
+
+static inline bool IsVisibleCell(const SDL_Rect *visible, int x, int y)
+{
+	return !visible || (x >= visible->x && x < visible->x + visible->w && y >= visible->y && y < visible->y + visible->h);
+}
+
+#endif
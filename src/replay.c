@@ -0,0 +1,267 @@
+#include "replay.h"
+#include "allocator.h"
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+
+// first bytes of every replay log, the last one is the format version
+static const unsigned char REPLAY_MAGIC[5] = {'M', 'S', 'R', 'P', 1};
+// inputs a replay has room for from the start, more turns than a round usually takes, so
+// recording does not touch the heap while the round is played
+#define REPLAY_MIN_INPUTS 4096
+
+static void WriteReplayVarint(FILE *file, uint64_t value);
+static bool ReadReplayVarint(FILE *file, uint64_t *value);
+static void WriteReplayFixed(FILE *file, uint64_t value);
+static bool ReadReplayFixed(FILE *file, uint64_t *value);
+static bool IsReplayDirection(uint64_t direction);
+
+Replay *CreateReplay(const GameConfig *config)
+{
+	Replay *replay = AllocMemory(sizeof(Replay));
+	if (!replay)
+	{
+		return NULL;
+	}
+
+	replay->config = *config;
+	replay->inputs = AllocMemory(REPLAY_MIN_INPUTS * sizeof(ReplayInput));
+	if (!replay->inputs)
+	{
+		FreeMemory(replay);
+		return NULL;
+	}
+	replay->inputCount = 0;
+	replay->inputCapacity = REPLAY_MIN_INPUTS;
+	replay->tickCount = 0;
+	replay->finalHash = 0;
+
+	return replay;
+}
+
+bool RecordReplay(Replay *replay, uint64_t tick, const GameInput *input)
+{
+	// inputs that change nothing are not worth a byte
+	if (!input || !input->direction)
+	{
+		return true;
+	}
+
+	if (replay->inputCount == replay->inputCapacity)
+	{
+		int capacity = replay->inputCapacity * 2;
+		ReplayInput *inputs = ReallocMemory(replay->inputs, capacity * sizeof(ReplayInput));
+		if (!inputs)
+		{
+			return false;
+		}
+
+		replay->inputs = inputs;
+		replay->inputCapacity = capacity;
+	}
+
+	replay->inputs[replay->inputCount++] = (ReplayInput) {tick, input->direction};
+
+	return true;
+}
+
+void FinishReplay(Replay *replay, Game *game)
+{
+	replay->tickCount = game->tick;
+	replay->finalHash = HashGame(game);
+}
+
+void InputReplay(Replay *replay, int *cursor, uint64_t tick, GameInput *input)
+{
+	// hand out the input recorded for this tick, if any, and move past it
+	input->direction = 0;
+	while (*cursor < replay->inputCount && replay->inputs[*cursor].tick <= tick)
+	{
+		if (replay->inputs[*cursor].tick == tick)
+		{
+			input->direction = replay->inputs[*cursor].direction;
+		}
+		++*cursor;
+	}
+}
+
+bool SaveReplay(Replay *replay, const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	// the config, as variable length integers except for the seed and hash, which are random bits
+	GameConfig *config = &replay->config;
+	fwrite(REPLAY_MAGIC, 1, sizeof(REPLAY_MAGIC), file);
+	WriteReplayVarint(file, (uint32_t) config->width);
+	WriteReplayVarint(file, (uint32_t) config->height);
+	WriteReplayVarint(file, (uint32_t) config->xStart);
+	WriteReplayVarint(file, (uint32_t) config->yStart);
+	WriteReplayVarint(file, (uint32_t) config->length);
+	WriteReplayVarint(file, (uint32_t) config->direction);
+	WriteReplayVarint(file, config->speed);
+	WriteReplayVarint(file, (uint32_t) config->nodeWidth);
+	WriteReplayVarint(file, (uint32_t) config->nodeHeight);
+	WriteReplayFixed(file, (uint64_t) config->color.r | (uint64_t) config->color.g << 8 | (uint64_t) config->color.b << 16 | (uint64_t) config->color.a << 24);
+	WriteReplayFixed(file, config->seed);
+	WriteReplayVarint(file, replay->tickCount);
+	WriteReplayFixed(file, replay->finalHash);
+
+	// the inputs, each one as the ticks since the one before and the direction
+	WriteReplayVarint(file, (uint64_t) replay->inputCount);
+	uint64_t lastTick = 0;
+	for (int i = 0; i < replay->inputCount; ++i)
+	{
+		WriteReplayVarint(file, replay->inputs[i].tick - lastTick);
+		fputc(replay->inputs[i].direction, file);
+		lastTick = replay->inputs[i].tick;
+	}
+
+	bool isWritten = !ferror(file);
+	return fclose(file) == 0 && isWritten;
+}
+
+Replay *LoadReplay(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+	{
+		return NULL;
+	}
+
+	unsigned char magic[sizeof(REPLAY_MAGIC)];
+	uint64_t fields[9], color, seed, tickCount, finalHash, inputCount;
+	bool isRead = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, REPLAY_MAGIC, sizeof(magic)) == 0;
+	for (int i = 0; i < 9 && isRead; ++i)
+	{
+		isRead = ReadReplayVarint(file, &fields[i]);
+	}
+	isRead = isRead && ReadReplayFixed(file, &color) && ReadReplayFixed(file, &seed) && ReadReplayVarint(file, &tickCount)
+		&& ReadReplayFixed(file, &finalHash) && ReadReplayVarint(file, &inputCount) && inputCount < (1u << 30);
+	// the config sizes the board and places the snake on it, so one that does not fit is refused
+	// before anything is made from it
+	uint64_t width = fields[0], height = fields[1], xStart = fields[2], yStart = fields[3], length = fields[4];
+	bool isValid = isRead && width >= 1 && height >= 1 && width <= INT_MAX && height <= INT_MAX && width * height <= INT_MAX
+		&& xStart < width && yStart < height && length >= 1 && length <= width * height && IsReplayDirection(fields[5])
+		&& fields[7] >= 1 && fields[7] <= INT_MAX && fields[8] >= 1 && fields[8] <= INT_MAX;
+	if (!isValid)
+	{
+		fclose(file);
+		return NULL;
+	}
+
+	GameConfig config =
+	{
+		(int) fields[0], (int) fields[1], (int) fields[2], (int) fields[3], (int) fields[4], (SnakeDirection) fields[5], fields[6],
+		(int) fields[7], (int) fields[8], {color & 0xFF, color >> 8 & 0xFF, color >> 16 & 0xFF, color >> 24 & 0xFF}, seed
+	};
+
+	Replay *replay = CreateReplay(&config);
+	if (!replay)
+	{
+		fclose(file);
+		return NULL;
+	}
+	replay->tickCount = tickCount;
+	replay->finalHash = finalHash;
+
+	// read the inputs back, turning the tick deltas into ticks again
+	uint64_t tick = 0;
+	for (uint64_t i = 0; i < inputCount; ++i)
+	{
+		uint64_t delta;
+		int direction;
+		if (!ReadReplayVarint(file, &delta) || (direction = fgetc(file)) == EOF || (direction != 0 && !IsReplayDirection((uint64_t) direction)))
+		{
+			DestroyReplay(replay);
+			fclose(file);
+			return NULL;
+		}
+
+		tick += delta;
+		GameInput input = {(SnakeDirection) direction};
+		if (!RecordReplay(replay, tick, &input))
+		{
+			DestroyReplay(replay);
+			fclose(file);
+			return NULL;
+		}
+	}
+
+	fclose(file);
+
+	return replay;
+}
+
+void DestroyReplay(Replay *replay)
+{
+	FreeMemory(replay->inputs);
+	FreeMemory(replay);
+}
+
+static void WriteReplayVarint(FILE *file, uint64_t value)
+{
+	// seven bits per byte, low bits first, with the top bit set on every byte but the last
+	while (value >= 0x80)
+	{
+		fputc((int) (value & 0x7F) | 0x80, file);
+		value >>= 7;
+	}
+	fputc((int) value, file);
+}
+
+static bool ReadReplayVarint(FILE *file, uint64_t *value)
+{
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		int byte = fgetc(file);
+		if (byte == EOF)
+		{
+			return false;
+		}
+
+		*value |= (uint64_t) (byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void WriteReplayFixed(FILE *file, uint64_t value)
+{
+	// little endian, whatever the machine is
+	for (int i = 0; i < 8; ++i)
+	{
+		fputc((int) (value >> (8 * i) & 0xFF), file);
+	}
+}
+
+static bool ReadReplayFixed(FILE *file, uint64_t *value)
+{
+	*value = 0;
+	for (int i = 0; i < 8; ++i)
+	{
+		int byte = fgetc(file);
+		if (byte == EOF)
+		{
+			return false;
+		}
+
+		*value |= (uint64_t) byte << (8 * i);
+	}
+
+	return true;
+}
+
+static bool IsReplayDirection(uint64_t direction)
+{
+	return direction == SNAKE_RIGHT || direction == SNAKE_UP || direction == SNAKE_LEFT || direction == SNAKE_DOWN;
+}
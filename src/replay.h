@@ -0,0 +1,40 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "game.h"
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare ReplayInput, Replay structs.
+ */
+
+// an input and the tick it was applied on
+typedef struct ReplayInput
+{
+	uint64_t tick;
+	SnakeDirection direction;
+} ReplayInput;
+
+// everything needed to play a game again exactly: its config, seed included, and every input
+// that changed something, stamped with its tick. games only depend on these, so stepping the
+// inputs back in gives the same game at any speed. saved as a compact binary log
+typedef struct Replay
+{
+	GameConfig config;
+	ReplayInput *inputs;	// in tick order
+	int inputCount, inputCapacity;
+	uint64_t tickCount;	// ticks the recorded game ran for, set when it is finished
+	uint64_t finalHash;	// HashGame after the last tick, to check a replay against
+} Replay;
+
+Replay *CreateReplay(const GameConfig *config);
+bool RecordReplay(Replay *replay, uint64_t tick, const GameInput *input);
+void FinishReplay(Replay *replay, Game *game);
+void InputReplay(Replay *replay, int *cursor, uint64_t tick, GameInput *input);
+bool SaveReplay(Replay *replay, const char *path);
+Replay *LoadReplay(const char *path);
+void DestroyReplay(Replay *replay);
+
+#endif
@@ -0,0 +1,706 @@
+#include "server.h"
+#include "allocator.h"
+#include <string.h>
+
+
+// clients and snapshot packets a server has room for from the start
+#define SERVER_MIN_CLIENTS 8
+#define SERVER_MIN_PARTS 16
+// snakes one client may ask for at once
+#define SERVER_MAX_JOIN 65536
+// cells a snake starts with when it joins or comes back
+#define SERVER_SPAWN_LENGTH 3
+// seconds without a word from a client before its snakes are taken off the board
+#define SERVER_TIMEOUT_SECONDS 5
+// bytes the biggest snake and food records of a delta take
+#define SERVER_MAX_RECORD 19
+// bytes a body record takes before its direction codes
+#define SERVER_BODY_RECORD 29
+
+// marks of a snake between two ticks
+#define SERVER_SPAWNED 0x01
+#define SERVER_REMOVED 0x02
+
+static bool ReserveServerSnakes(Server *server, int capacity);
+static int FindServerClient(Server *server, const NetAddress *address);
+static void JoinServerClient(Server *server, const NetAddress *address, int snakeCount);
+static void InputServerClient(Server *server, int client, NetPacket *packet);
+static void DropServerClient(Server *server, int client);
+static void FreeServerRun(Server *server, int first, int count);
+static int TakeServerRun(Server *server, int count);
+static SnakeColor RandServerColor(Server *server);
+static bool StartServerSnapshot(ServerSnapshot *snapshot, NetMessage message, uint64_t tick);
+static NetPacket *RoomInServerSnapshot(ServerSnapshot *snapshot, int bytes);
+static void FinishServerSnapshot(ServerSnapshot *snapshot);
+static bool SendServerSnapshot(Server *server, ServerSnapshot *snapshot, const NetAddress *address, uint64_t *bytes);
+static bool WriteServerDelta(Server *server);
+static bool WriteServerFull(Server *server);
+
+Server *CreateServer(int port, int width, int height, int foodCount, int tickRate, uint64_t seed)
+{
+	Server *server = CallocMemory(1, sizeof(Server));
+	if (!server)
+	{
+		return NULL;
+	}
+
+	server->tickRate = tickRate > 0 ? tickRate : 1;
+	SeedRandom(&server->random, seed ^ 0x5EB7E5ULL);
+	server->world = CreateWorld(width, height, foodCount, seed);
+	server->socket = OpenNetSocket(port);
+	server->clientCapacity = SERVER_MIN_CLIENTS;
+	server->clients = CallocMemory(server->clientCapacity, sizeof(ServerClient));
+	server->lastFoods = AllocMemory((foodCount > 0 ? foodCount : 1) * sizeof(Food));
+	server->delta.partCapacity = server->full.partCapacity = SERVER_MIN_PARTS;
+	server->delta.parts = AllocMemory(SERVER_MIN_PARTS * sizeof(NetPacket));
+	server->full.parts = AllocMemory(SERVER_MIN_PARTS * sizeof(NetPacket));
+
+	if (!(server->world && server->socket && server->clients && server->lastFoods && server->delta.parts && server->full.parts && ReserveServerSnakes(server, SERVER_MIN_CLIENTS)))
+	{
+		DestroyServer(server);
+		return NULL;
+	}
+
+	// the first delta only tells about food that moved after the world was made
+	memcpy(server->lastFoods, server->world->foods, server->world->foodCount * sizeof(Food));
+
+	return server;
+}
+
+void PollServer(Server *server)
+{
+	// handle every packet that is waiting, without blocking
+	NetAddress address;
+	NetPacket *packet = &server->packet;
+	while (ReceiveNetSocket(server->socket, &address, packet))
+	{
+		int client = FindServerClient(server, &address);
+		switch (GetNetU8(packet))
+		{
+			case NET_JOIN:
+				JoinServerClient(server, &address, (int) GetNetVarint(packet));
+				break;
+			case NET_INPUT:
+				if (client >= 0)
+				{
+					InputServerClient(server, client, packet);
+				}
+				break;
+			case NET_LEAVE:
+				if (client >= 0)
+				{
+					DropServerClient(server, client);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+bool StepServer(Server *server)
+{
+	World *world = server->world;
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Bring back every dead snake a client still steers, then step the world.
+	 */
+
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		int x, y;
+		if (server->owner[snake] >= 0 && !world->isAlive[snake] && RandFreeWorldCell(world, &x, &y) && SpawnWorldSnake(world, snake, x, y, SERVER_SPAWN_LENGTH, SNAKE_UP))
+		{
+			server->marks[snake] |= SERVER_SPAWNED;
+		}
+
+		server->lengthBefore[snake] = world->length[snake];
+	}
+
+	StepWorld(world);
+
+	// a client that went quiet is taken to be gone
+	for (int client = 0; client < server->clientCount; ++client)
+	{
+		if (server->clients[client].isConnected && world->tick - server->clients[client].lastHeard > (uint64_t) SERVER_TIMEOUT_SECONDS * server->tickRate)
+		{
+			DropServerClient(server, client);
+		}
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Write what changed once and send it to every client that is in step. A client that is not is
+	 * sent the whole world instead, written at most once a tick however many clients need it.
+	 */
+
+	if (!WriteServerDelta(server))
+	{
+		return false;
+	}
+
+	bool isFullWritten = false;
+	for (int client = 0; client < server->clientCount; ++client)
+	{
+		ServerClient *cur = &server->clients[client];
+		if (!cur->isConnected)
+		{
+			continue;
+		}
+
+		if (!cur->needsFull)
+		{
+			SendServerSnapshot(server, &server->delta, &cur->address, &server->deltaBytes);
+			continue;
+		}
+
+		if (!isFullWritten && !WriteServerFull(server))
+		{
+			return false;
+		}
+		isFullWritten = true;
+
+		SendServerSnapshot(server, &server->full, &cur->address, &server->fullBytes);
+		cur->needsFull = false;
+		cur->lastFull = world->tick;
+	}
+
+	// every client has been told, so the next delta starts from here
+	memset(server->marks, 0, world->snakeCount * sizeof(uint8_t));
+	memcpy(server->lastFoods, world->foods, world->foodCount * sizeof(Food));
+
+	return true;
+}
+
+int CountServerClients(Server *server)
+{
+	int count = 0;
+	for (int client = 0; client < server->clientCount; ++client)
+	{
+		count += server->clients[client].isConnected;
+	}
+
+	return count;
+}
+
+void DestroyServer(Server *server)
+{
+	if (server->world)
+	{
+		DestroyWorld(server->world);
+	}
+
+	if (server->socket)
+	{
+		CloseNetSocket(server->socket);
+	}
+
+	FreeMemory(server->clients);
+	FreeMemory(server->owner);
+	FreeMemory(server->lengthBefore);
+	FreeMemory(server->marks);
+	FreeMemory(server->lastFoods);
+	FreeMemory(server->freeRuns);
+	FreeMemory(server->delta.parts);
+	FreeMemory(server->full.parts);
+	FreeMemory(server);
+}
+
+static bool ReserveServerSnakes(Server *server, int capacity)
+{
+	if (capacity <= server->snakeCapacity)
+	{
+		return true;
+	}
+
+	// grow to at least double, so joining snakes one by one stays cheap
+	capacity = capacity > server->snakeCapacity * 2 ? capacity : server->snakeCapacity * 2;
+	int *owner = ReallocMemory(server->owner, capacity * sizeof(int));
+	if (owner)
+	{
+		server->owner = owner;
+	}
+
+	int *lengthBefore = ReallocMemory(server->lengthBefore, capacity * sizeof(int));
+	if (lengthBefore)
+	{
+		server->lengthBefore = lengthBefore;
+	}
+
+	uint8_t *marks = ReallocMemory(server->marks, capacity * sizeof(uint8_t));
+	if (marks)
+	{
+		server->marks = marks;
+	}
+
+	if (!(owner && lengthBefore && marks))
+	{
+		return false;
+	}
+
+	for (int snake = server->snakeCapacity; snake < capacity; ++snake)
+	{
+		server->owner[snake] = -1;
+		server->lengthBefore[snake] = 0;
+		server->marks[snake] = 0;
+	}
+	server->snakeCapacity = capacity;
+
+	return true;
+}
+
+static int FindServerClient(Server *server, const NetAddress *address)
+{
+	for (int client = 0; client < server->clientCount; ++client)
+	{
+		if (server->clients[client].isConnected && IsSameNetAddress(&server->clients[client].address, address))
+		{
+			return client;
+		}
+	}
+
+	return -1;
+}
+
+static void JoinServerClient(Server *server, const NetAddress *address, int snakeCount)
+{
+	World *world = server->world;
+
+	// a client that asks again lost the welcome, so it is only sent that again
+	int client = FindServerClient(server, address);
+	if (client < 0)
+	{
+		if (snakeCount < 1 || snakeCount > SERVER_MAX_JOIN)
+		{
+			return;
+		}
+
+		// take the first free slot, or a new one
+		client = 0;
+		while (client < server->clientCount && server->clients[client].isConnected)
+		{
+			++client;
+		}
+		if (client == server->clientCapacity)
+		{
+			ServerClient *clients = ReallocMemory(server->clients, server->clientCapacity * 2 * sizeof(ServerClient));
+			if (!clients)
+			{
+				return;
+			}
+
+			server->clients = clients;
+			server->clientCapacity *= 2;
+		}
+		server->clientCount += client == server->clientCount;
+
+		// the client's snakes take slots that clients who left gave up, if enough of them are in a row
+		ServerClient *cur = &server->clients[client];
+		int first = TakeServerRun(server, snakeCount);
+		if (first >= 0)
+		{
+			*cur = (ServerClient) {*address, first, snakeCount, world->tick, world->tick, true, true};
+			for (int snake = first; snake < first + snakeCount; ++snake)
+			{
+				// a snake with no room yet is brought back by a later tick like any dead one. one that
+				// spawns starts over on the client too, even if it was removed this very tick
+				int x, y;
+				world->color[snake] = RandServerColor(server);
+				server->owner[snake] = client;
+				if (RandFreeWorldCell(world, &x, &y) && SpawnWorldSnake(world, snake, x, y, SERVER_SPAWN_LENGTH, SNAKE_UP))
+				{
+					server->marks[snake] = SERVER_SPAWNED;
+				}
+			}
+		}
+		else
+		{
+			// otherwise they go after every snake there is
+			*cur = (ServerClient) {*address, world->snakeCount, 0, world->tick, world->tick, true, true};
+			if (!ReserveServerSnakes(server, world->snakeCount + snakeCount))
+			{
+				cur->isConnected = false;
+				return;
+			}
+
+			for (int i = 0; i < snakeCount; ++i)
+			{
+				int x, y;
+				SnakeColor color = RandServerColor(server);
+				int snake = RandFreeWorldCell(world, &x, &y) ? AddWorldSnake(world, x, y, SERVER_SPAWN_LENGTH, SNAKE_UP, 1, &color) : -1;
+				if (snake < 0)
+				{
+					break;
+				}
+
+				server->owner[snake] = client;
+				server->marks[snake] = SERVER_SPAWNED;
+				++cur->snakeCount;
+			}
+		}
+	}
+
+	// tell the client which snakes are its own and how to mirror the world
+	ServerClient *cur = &server->clients[client];
+	NetPacket *packet = &server->packet;
+	StartNetPacket(packet, NET_WELCOME);
+	PutNetVarint(packet, (uint32_t) cur->firstSnake);
+	PutNetVarint(packet, (uint32_t) cur->snakeCount);
+	PutNetU32(packet, (uint32_t) world->width);
+	PutNetU32(packet, (uint32_t) world->height);
+	PutNetVarint(packet, (uint32_t) world->foodCount);
+	PutNetVarint(packet, (uint32_t) server->tickRate);
+	SendNetSocket(server->socket, address, packet);
+}
+
+static void InputServerClient(Server *server, int client, NetPacket *packet)
+{
+	ServerClient *cur = &server->clients[client];
+	cur->lastHeard = server->world->tick;
+
+	uint32_t appliedTick = GetNetU32(packet);
+	bool needsFull = GetNetU8(packet) != 0;
+	int turnCount = (int) GetNetVarint(packet);
+
+	// turn the client's own snakes only
+	for (int i = 0; i < turnCount && !packet->isBad; ++i)
+	{
+		uint32_t own = GetNetVarint(packet);
+		uint8_t code = GetNetU8(packet);
+		if (!packet->isBad && own < (uint32_t) cur->snakeCount && code <= SNAPSHOT_DIRECTION && server->world->isAlive[cur->firstSnake + own])
+		{
+			SteerWorldSnake(server->world, cur->firstSnake + (int) own, DecodeSnapshotDirection(code));
+		}
+	}
+
+	// a client that lost a packet asks for the whole world, but a request sent before the last full
+	// arrived is old news, unless that full looks lost too
+	bool hasSeenFull = (int32_t) (appliedTick - (uint32_t) cur->lastFull) >= 0;
+	bool isFullOverdue = server->world->tick - cur->lastFull >= (uint64_t) server->tickRate;
+	if (needsFull && (hasSeenFull || isFullOverdue))
+	{
+		cur->needsFull = true;
+	}
+}
+
+static void DropServerClient(Server *server, int client)
+{
+	// take the client's snakes off the board, and free its slot
+	ServerClient *cur = &server->clients[client];
+	for (int snake = cur->firstSnake; snake < cur->firstSnake + cur->snakeCount; ++snake)
+	{
+		RemoveWorldSnake(server->world, snake);
+		server->owner[snake] = -1;
+		server->marks[snake] |= SERVER_REMOVED;
+	}
+
+	FreeServerRun(server, cur->firstSnake, cur->snakeCount);
+	cur->isConnected = false;
+}
+
+static void FreeServerRun(Server *server, int first, int count)
+{
+	if (count < 1)
+	{
+		return;
+	}
+
+	// join the run with the free runs right before and after it, so a big client fits again later
+	for (int run = 0; run < server->freeRunCount; ++run)
+	{
+		ServerRun *cur = &server->freeRuns[run];
+		if (cur->first + cur->count == first || first + count == cur->first)
+		{
+			first = cur->first < first ? cur->first : first;
+			count += cur->count;
+			*cur = server->freeRuns[--server->freeRunCount];
+			--run;
+		}
+	}
+
+	if (server->freeRunCount == server->freeRunCapacity)
+	{
+		// a run there is no room to keep is only lost to later clients, its slots stay empty
+		int capacity = server->freeRunCapacity > 0 ? server->freeRunCapacity * 2 : SERVER_MIN_CLIENTS;
+		ServerRun *runs = ReallocMemory(server->freeRuns, capacity * sizeof(ServerRun));
+		if (!runs)
+		{
+			return;
+		}
+
+		server->freeRuns = runs;
+		server->freeRunCapacity = capacity;
+	}
+
+	server->freeRuns[server->freeRunCount++] = (ServerRun) {first, count};
+}
+
+static int TakeServerRun(Server *server, int count)
+{
+	// the first free run that is long enough gives up its first slots
+	for (int run = 0; run < server->freeRunCount; ++run)
+	{
+		ServerRun *cur = &server->freeRuns[run];
+		if (cur->count < count)
+		{
+			continue;
+		}
+
+		int first = cur->first;
+		cur->first += count;
+		cur->count -= count;
+		if (cur->count == 0)
+		{
+			*cur = server->freeRuns[--server->freeRunCount];
+		}
+
+		return first;
+	}
+
+	return -1;
+}
+
+static SnakeColor RandServerColor(Server *server)
+{
+	uint32_t rgb = NextRandom(&server->random);
+
+	return (SnakeColor) {(uint8_t) rgb, (uint8_t) (rgb >> 8), (uint8_t) (rgb >> 16), 0xFF};
+}
+
+static bool StartServerSnapshot(ServerSnapshot *snapshot, NetMessage message, uint64_t tick)
+{
+	snapshot->partCount = 0;
+	if (!RoomInServerSnapshot(snapshot, NET_MAX_PACKET))
+	{
+		return false;
+	}
+
+	// the header goes in the first part, and is copied into every part after it
+	NetPacket *packet = &snapshot->parts[0];
+	StartNetPacket(packet, message);
+	PutNetU32(packet, (uint32_t) tick);
+	PutNetU16(packet, 0);
+	PutNetU16(packet, 0);
+
+	return true;
+}
+
+static NetPacket *RoomInServerSnapshot(ServerSnapshot *snapshot, int bytes)
+{
+	// the last part if the bytes still fit in it
+	NetPacket *last = snapshot->partCount > 0 ? &snapshot->parts[snapshot->partCount - 1] : NULL;
+	if (last && last->size + bytes <= NET_MAX_PACKET)
+	{
+		return last;
+	}
+
+	// otherwise a new part with the same header
+	if (snapshot->partCount == snapshot->partCapacity)
+	{
+		NetPacket *parts = ReallocMemory(snapshot->parts, snapshot->partCapacity * 2 * sizeof(NetPacket));
+		if (!parts)
+		{
+			return NULL;
+		}
+
+		snapshot->parts = parts;
+		snapshot->partCapacity *= 2;
+	}
+
+	NetPacket *part = &snapshot->parts[snapshot->partCount];
+	if (snapshot->partCount > 0)
+	{
+		memcpy(part->data, snapshot->parts[0].data, 10);
+		part->size = 10;
+		part->offset = 0;
+		part->isBad = false;
+		part->data[6] = (uint8_t) snapshot->partCount;
+		part->data[7] = (uint8_t) (snapshot->partCount >> 8);
+	}
+	++snapshot->partCount;
+
+	return part;
+}
+
+static void FinishServerSnapshot(ServerSnapshot *snapshot)
+{
+	// every part learns how many there are, so a client knows when it has the whole tick
+	for (int i = 0; i < snapshot->partCount; ++i)
+	{
+		snapshot->parts[i].data[8] = (uint8_t) snapshot->partCount;
+		snapshot->parts[i].data[9] = (uint8_t) (snapshot->partCount >> 8);
+	}
+}
+
+static bool SendServerSnapshot(Server *server, ServerSnapshot *snapshot, const NetAddress *address, uint64_t *bytes)
+{
+	bool isSent = true;
+	for (int i = 0; i < snapshot->partCount; ++i)
+	{
+		isSent = SendNetSocket(server->socket, address, &snapshot->parts[i]) && isSent;
+		*bytes += (uint64_t) snapshot->parts[i].size;
+	}
+
+	return isSent;
+}
+
+static bool WriteServerDelta(Server *server)
+{
+	World *world = server->world;
+	if (!StartServerSnapshot(&server->delta, NET_DELTA, world->tick))
+	{
+		return false;
+	}
+
+	// a record for every snake that moved, died, came back or left
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		uint8_t marks = server->marks[snake];
+		uint8_t events = world->events[snake];
+		if (!marks && !(events & (GAME_EVENT_MOVED | GAME_EVENT_DIED)))
+		{
+			continue;
+		}
+
+		uint8_t tag = (uint8_t) EncodeSnapshotDirection(world->direction[snake]);
+		if ((marks & SERVER_REMOVED) || (events & GAME_EVENT_DIED) || !world->isAlive[snake])
+		{
+			tag |= SNAPSHOT_DIED;
+		}
+		else
+		{
+			tag |= (events & GAME_EVENT_MOVED) ? SNAPSHOT_MOVED : 0;
+			tag |= (events & GAME_EVENT_MOVED) && world->length[snake] > server->lengthBefore[snake] ? SNAPSHOT_GREW : 0;
+			tag |= (marks & SERVER_SPAWNED) ? SNAPSHOT_SPAWNED : 0;
+		}
+
+		NetPacket *packet = RoomInServerSnapshot(&server->delta, SERVER_MAX_RECORD);
+		if (!packet)
+		{
+			return false;
+		}
+
+		PutNetU8(packet, tag);
+		PutNetVarint(packet, (uint32_t) snake);
+		if (tag & SNAPSHOT_SPAWNED)
+		{
+			// a snake grows out of the cell it came back on, so that cell is still its tail
+			SnakeCell *spawn = WorldSnakeCellAt(world, snake, world->length[snake] - 1);
+			PutNetVarint(packet, (uint32_t) spawn->xPos);
+			PutNetVarint(packet, (uint32_t) spawn->yPos);
+			PutNetU8(packet, world->color[snake].r);
+			PutNetU8(packet, world->color[snake].g);
+			PutNetU8(packet, world->color[snake].b);
+		}
+	}
+
+	// and one for every food that moved
+	for (int food = 0; food < world->foodCount; ++food)
+	{
+		Food *cur = &world->foods[food];
+		if (cur->xPos == server->lastFoods[food].xPos && cur->yPos == server->lastFoods[food].yPos)
+		{
+			continue;
+		}
+
+		NetPacket *packet = RoomInServerSnapshot(&server->delta, SERVER_MAX_RECORD);
+		if (!packet)
+		{
+			return false;
+		}
+
+		PutNetU8(packet, SNAPSHOT_FOOD);
+		PutNetVarint(packet, (uint32_t) food);
+		PutNetVarint(packet, (uint32_t) (cur->xPos + 1));
+		PutNetVarint(packet, (uint32_t) (cur->yPos + 1));
+	}
+
+	FinishServerSnapshot(&server->delta);
+
+	return true;
+}
+
+static bool WriteServerFull(Server *server)
+{
+	World *world = server->world;
+	if (!StartServerSnapshot(&server->full, NET_FULL, world->tick))
+	{
+		return false;
+	}
+
+	// every living body, cut into as many records as it takes to fit the packets
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		int length = world->isAlive[snake] ? world->length[snake] : 0;
+		for (int offset = 0; offset < length;)
+		{
+			NetPacket *packet = RoomInServerSnapshot(&server->full, SERVER_BODY_RECORD + 4);
+			if (!packet)
+			{
+				return false;
+			}
+
+			// as many cells as the rest of the packet holds, four direction codes to a byte
+			int room = NET_MAX_PACKET - packet->size - SERVER_BODY_RECORD;
+			int count = length - offset < 1 + room * 4 ? length - offset : 1 + room * 4;
+			SnakeCell *first = WorldSnakeCellAt(world, snake, offset);
+
+			PutNetU8(packet, (uint8_t) (SNAPSHOT_BODY | EncodeSnapshotDirection(world->direction[snake])));
+			PutNetVarint(packet, (uint32_t) snake);
+			PutNetU8(packet, world->color[snake].r);
+			PutNetU8(packet, world->color[snake].g);
+			PutNetU8(packet, world->color[snake].b);
+			PutNetVarint(packet, (uint32_t) offset);
+			PutNetVarint(packet, (uint32_t) count);
+			PutNetVarint(packet, (uint32_t) first->xPos);
+			PutNetVarint(packet, (uint32_t) first->yPos);
+
+			uint8_t codes = 0;
+			for (int i = 1; i < count; ++i)
+			{
+				// the code that leads from each cell to the next one toward the tail
+				SnakeCell *from = WorldSnakeCellAt(world, snake, offset + i - 1);
+				SnakeCell *to = WorldSnakeCellAt(world, snake, offset + i);
+				int code = 0;
+				SnakeCell next = MoveSnapshotCell(*from, code, world->width, world->height);
+				while (code < 3 && (next.xPos != to->xPos || next.yPos != to->yPos))
+				{
+					next = MoveSnapshotCell(*from, ++code, world->width, world->height);
+				}
+
+				codes |= (uint8_t) (code << ((i - 1) % 4 * 2));
+				if ((i - 1) % 4 == 3 || i == count - 1)
+				{
+					PutNetU8(packet, codes);
+					codes = 0;
+				}
+			}
+
+			offset += count;
+		}
+	}
+
+	// and every food in play
+	for (int food = 0; food < world->foodCount; ++food)
+	{
+		Food *cur = &world->foods[food];
+		if (cur->xPos < 0)
+		{
+			continue;
+		}
+
+		NetPacket *packet = RoomInServerSnapshot(&server->full, SERVER_MAX_RECORD);
+		if (!packet)
+		{
+			return false;
+		}
+
+		PutNetU8(packet, SNAPSHOT_FOOD);
+		PutNetVarint(packet, (uint32_t) food);
+		PutNetVarint(packet, (uint32_t) (cur->xPos + 1));
+		PutNetVarint(packet, (uint32_t) (cur->yPos + 1));
+	}
+
+	FinishServerSnapshot(&server->full);
+
+	return true;
+}
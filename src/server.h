@@ -0,0 +1,119 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "net.h"
+#include "random.h"
+#include "world.h"
+
+
+// tags of the records in DELTA and FULL packets. a snake record is the tag, the snake, then what
+// the tag asks for, and the low two bits of its tag are a direction code. a tick costs a couple of
+// bytes for every snake that moved, no matter how long the snakes are
+#define SNAPSHOT_DIRECTION 0x03
+#define SNAPSHOT_MOVED 0x04	// the head moved one cell in the direction
+#define SNAPSHOT_GREW 0x08	// and the tail stayed
+#define SNAPSHOT_DIED 0x10	// the snake is gone
+#define SNAPSHOT_SPAWNED 0x20	// the snake starts over as a head facing the direction, before it moves: x, y, r, g, b
+#define SNAPSHOT_BODY 0x40	// cells of a whole body from offset: r, g, b, offset, count, x, y, then count - 1 codes four to a byte
+#define SNAPSHOT_FOOD 0x80	// not a snake record, a food was put on a cell: food, x + 1, y + 1, 0 if out of play
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare ServerClient, ServerRun, ServerSnapshot, Server structs.
+ */
+
+// someone steering snakes from the other end of the socket. a player steers one, a bot client many
+typedef struct ServerClient
+{
+	NetAddress address;
+	int firstSnake, snakeCount;	// the client's snakes, one after another in the world
+	uint64_t lastHeard;	// tick the client last sent anything
+	uint64_t lastFull;	// tick the client was last sent the whole world
+	bool needsFull;	// send the whole world instead of the next delta
+	bool isConnected;	// false once the slot is free again
+} ServerClient;
+
+// snakes one after another that no client steers, left behind by clients that are gone
+typedef struct ServerRun
+{
+	int first, count;
+} ServerRun;
+
+// one snapshot cut into packets. every packet holds whole records, so it can be used without the others
+typedef struct ServerSnapshot
+{
+	NetPacket *parts;
+	int partCount, partCapacity;
+} ServerSnapshot;
+
+// runs the one true world at a fixed tick rate. clients send their turns, and after every tick
+// each client is sent only what changed, which it applies to its own copy of the world. a client
+// that lost a packet is sent the whole world once and carries on from there
+typedef struct Server
+{
+	World *world;
+	NetSocket *socket;
+	int tickRate;	// ticks per second
+	Random random;	// picks the colors of new snakes
+
+	ServerClient *clients;
+	int clientCount, clientCapacity;
+
+	// per-snake state the deltas are made from, sized like the world's snakes
+	int *owner;	// client steering each snake, -1 if none
+	int *lengthBefore;	// length of each snake before the tick
+	uint8_t *marks;	// spawned and removed between the last two ticks
+	int snakeCapacity;
+	Food *lastFoods;	// the food as the last delta left it
+
+	// slots of snakes given up by clients that left, handed to the next clients that join
+	ServerRun *freeRuns;
+	int freeRunCount, freeRunCapacity;
+
+	ServerSnapshot delta, full;
+	NetPacket packet;	// the last packet received
+
+	uint64_t deltaBytes, fullBytes;	// bytes of one copy of each delta and of every full sent
+} Server;
+
+Server *CreateServer(int port, int width, int height, int foodCount, int tickRate, uint64_t seed);
+void PollServer(Server *server);
+bool StepServer(Server *server);
+int CountServerClients(Server *server);
+void DestroyServer(Server *server);
+
+static inline int EncodeSnapshotDirection(SnakeDirection direction)
+{
+	switch (direction)
+	{
+		case SNAKE_UP: return 1;
+		case SNAKE_LEFT: return 2;
+		case SNAKE_DOWN: return 3;
+		default: return 0;
+	}
+}
+
+static inline SnakeDirection DecodeSnapshotDirection(int code)
+{
+	static const SnakeDirection directions[4] = {SNAKE_RIGHT, SNAKE_UP, SNAKE_LEFT, SNAKE_DOWN};
+
+	return directions[code & SNAPSHOT_DIRECTION];
+}
+
+// the cell next to a cell in the direction of a code, looping around the edges of the board
+static inline SnakeCell MoveSnapshotCell(SnakeCell cell, int code, int width, int height)
+{
+	switch (code & SNAPSHOT_DIRECTION)
+	{
+		case 0: cell.xPos = cell.xPos + 1 < width ? cell.xPos + 1 : 0; break;
+		case 1: cell.yPos = cell.yPos > 0 ? cell.yPos - 1 : height - 1; break;
+		case 2: cell.xPos = cell.xPos > 0 ? cell.xPos - 1 : width - 1; break;
+		case 3: cell.yPos = cell.yPos + 1 < height ? cell.yPos + 1 : 0; break;
+	}
+
+	return cell;
+}
+
+#endif
@@ -0,0 +1,226 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "simulation.h"
+#include "allocator.h"
+#include <string.h>
+#include <time.h>
+
+
+#define SIM_FRESH 4	// set on middle when it holds a snapshot the caller has not taken yet
+#define SIM_INDEX 3	// the snapshot index in back, middle and front
+#define SIM_SLEEP_MS 10	// longest the thread sleeps at once, so a stop is noticed quickly
+
+static void *RunSimulation(void *data);
+static void TakeSimCommands(Simulation *simulation);
+static void PublishSimulation(Simulation *simulation);
+static void SleepSimulation(uint64_t milliseconds);
+
+Simulation *CreateSimulation(Game *game, const GameConfig *config, Replay *replay, Autopilot *autopilot, int inputDepth, uint64_t (*clock)(void))
+{
+	Simulation *simulation = CallocMemory(1, sizeof(Simulation));
+	if (!simulation)
+	{
+		return NULL;
+	}
+
+	simulation->game = game;
+	simulation->replay = replay;
+	simulation->autopilot = autopilot;
+	simulation->clock = clock;
+	InitInputQueue(&simulation->turns, inputDepth);
+
+	// each snapshot is a game of its own, made from the same config so the copies always fit
+	for (int i = 0; i < 3; ++i)
+	{
+		simulation->snapshots[i].game = CreateGame(config);
+		if (!simulation->snapshots[i].game)
+		{
+			DestroySimulation(simulation);
+			return NULL;
+		}
+	}
+
+	simulation->back = 0;
+	simulation->middle = 1;
+	simulation->front = 2;
+
+	return simulation;
+}
+
+bool StartSimulation(Simulation *simulation)
+{
+	if (simulation->isRunning)
+	{
+		return true;
+	}
+
+	// the caller gets the game as it is now until the first tick
+	PublishSimulation(simulation);
+
+	simulation->isStopping = false;
+	if (pthread_create(&simulation->thread, NULL, RunSimulation, simulation) != 0)
+	{
+		return false;
+	}
+	simulation->isRunning = true;
+
+	return true;
+}
+
+void StopSimulation(Simulation *simulation)
+{
+	if (!simulation->isRunning)
+	{
+		return;
+	}
+
+	// the thread ends within one sleep, and joining it hands the game back to the caller
+	__atomic_store_n(&simulation->isStopping, true, __ATOMIC_RELEASE);
+	pthread_join(simulation->thread, NULL);
+	simulation->isRunning = false;
+}
+
+bool SendSimulation(Simulation *simulation, const SimCommand *command)
+{
+	// only this side moves the tail, so it is read plainly. a full ring turns the command away
+	unsigned tail = simulation->commandTail;
+	if (tail - __atomic_load_n(&simulation->commandHead, __ATOMIC_ACQUIRE) >= SIM_COMMAND_CAPACITY)
+	{
+		return false;
+	}
+
+	simulation->commands[tail & (SIM_COMMAND_CAPACITY - 1)] = *command;
+	__atomic_store_n(&simulation->commandTail, tail + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+const SimSnapshot *ReadSimulation(Simulation *simulation)
+{
+	// take the newest snapshot if there is one, giving back the one read before. otherwise keep it
+	if (__atomic_load_n(&simulation->middle, __ATOMIC_ACQUIRE) & SIM_FRESH)
+	{
+		simulation->front = __atomic_exchange_n(&simulation->middle, simulation->front, __ATOMIC_ACQ_REL) & SIM_INDEX;
+	}
+
+	return &simulation->snapshots[simulation->front];
+}
+
+void DestroySimulation(Simulation *simulation)
+{
+	StopSimulation(simulation);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		if (simulation->snapshots[i].game)
+		{
+			DestroyGame(simulation->snapshots[i].game);
+		}
+	}
+
+	FreeMemory(simulation);
+}
+
+static void *RunSimulation(void *data)
+{
+	Simulation *simulation = data;
+	Game *game = simulation->game;
+	Snake *player = game->player;
+
+	// a finished game is not stepped anymore, its last snapshot tells the caller how it ended
+	while (!game->isOver && !__atomic_load_n(&simulation->isStopping, __ATOMIC_ACQUIRE))
+	{
+		TakeSimCommands(simulation);
+
+		uint64_t timeNow = simulation->clock();
+		if (timeNow < player->nextMoveTime)
+		{
+			uint64_t wait = player->nextMoveTime - timeNow;
+			SleepSimulation(wait < SIM_SLEEP_MS ? wait : SIM_SLEEP_MS);
+			continue;
+		}
+
+		// the next move is due one period after this one was due, not after it happened, so a late
+		// wake does not push every later tick back. a thread more than a whole tick behind skips
+		// ahead instead of stepping the missed ticks in a burst
+		player->lastMoveTime = player->nextMoveTime;
+		player->nextMoveTime += player->speed;
+		if (player->nextMoveTime <= timeNow)
+		{
+			player->nextMoveTime = timeNow + player->speed;
+		}
+
+		// the autopilot sets the turn just like a key press would, so the replay logs it the same.
+		// otherwise the oldest queued turn is taken, one per move, and timed until it is shown
+		SimTick *record = &simulation->history[(game->tick + 1) % SIM_HISTORY];
+		SnakeDirection turn;
+		record->isTurnTimed = false;
+		if (simulation->isAutopilotOn)
+		{
+			ClearInputQueue(&simulation->turns);
+			SteerAutopilot(simulation->autopilot, player, game->board, &game->food);
+		}
+		else if (PopInputQueue(&simulation->turns, &turn, &record->turnTime) && SteerSnake(player, turn))
+		{
+			record->isTurnTimed = true;
+		}
+
+		// log the turn, then step the game with it. a turn that could not be logged leaves the replay
+		// short, so the game ends there with an error
+		GameInput input = {player->pendingDirection != player->currentDirection ? player->pendingDirection : 0};
+		bool isRecorded = !simulation->replay || RecordReplay(simulation->replay, game->tick, &input);
+		record->events = StepGame(game, &input);
+		if (!isRecorded)
+		{
+			record->events |= GAME_EVENT_ERROR;
+			game->isOver = true;
+		}
+
+		record->tick = game->tick;
+		memcpy(record->changes, game->changes, sizeof(record->changes));
+		record->changeCount = game->changeCount;
+
+		PublishSimulation(simulation);
+	}
+
+	return NULL;
+}
+
+static void TakeSimCommands(Simulation *simulation)
+{
+	// only this side moves the head, so it is read plainly
+	unsigned head = simulation->commandHead;
+	unsigned tail = __atomic_load_n(&simulation->commandTail, __ATOMIC_ACQUIRE);
+
+	for (; head != tail; ++head)
+	{
+		SimCommand *command = &simulation->commands[head & (SIM_COMMAND_CAPACITY - 1)];
+		if (command->kind == SIM_TURN)
+		{
+			PushInputQueue(&simulation->turns, simulation->game->player->currentDirection, command->direction, command->time);
+		}
+		else if (command->kind == SIM_AUTOPILOT)
+		{
+			simulation->isAutopilotOn = command->isOn;
+		}
+	}
+
+	__atomic_store_n(&simulation->commandHead, head, __ATOMIC_RELEASE);
+}
+
+static void PublishSimulation(Simulation *simulation)
+{
+	// the snapshot games are made from the same config as the game, so the copy always fits
+	SimSnapshot *snapshot = &simulation->snapshots[simulation->back];
+	CopyGame(snapshot->game, simulation->game);
+	memcpy(snapshot->ticks, simulation->history, sizeof(snapshot->ticks));
+
+	// hand it over and take back whichever snapshot the caller is not holding
+	simulation->back = __atomic_exchange_n(&simulation->middle, simulation->back | SIM_FRESH, __ATOMIC_ACQ_REL) & SIM_INDEX;
+}
+
+static void SleepSimulation(uint64_t milliseconds)
+{
+	struct timespec wait = {(time_t) (milliseconds / 1000), (long) (milliseconds % 1000) * 1000000L};
+	nanosleep(&wait, NULL);
+}
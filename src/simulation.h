@@ -0,0 +1,98 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "autopilot.h"
+#include "game.h"
+#include "input.h"
+#include "replay.h"
+
+
+// most commands waiting for the simulation thread, a power of two
+#define SIM_COMMAND_CAPACITY 64
+// ticks each snapshot keeps a record of, so a reader that skipped snapshots can catch up
+#define SIM_HISTORY 32
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare SimCommandKind enum.
+ */
+
+// what a command asks the simulation thread to do
+typedef enum
+{
+	SIM_TURN = 1,	// queue a turn for the player
+	SIM_AUTOPILOT	// switch the autopilot on or off
+} SimCommandKind;
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare SimCommand, SimTick, SimSnapshot, Simulation structs.
+ */
+
+// an input forwarded to the simulation thread
+typedef struct SimCommand
+{
+	SimCommandKind kind;
+	SnakeDirection direction;	// the turn, for SIM_TURN
+	uint64_t time;	// when the turn was asked for, in milliseconds of the simulation's clock
+	bool isOn;	// for SIM_AUTOPILOT
+} SimCommand;
+
+// what happened on one tick
+typedef struct SimTick
+{
+	uint64_t tick;	// the game's tick after it was stepped
+	int events;	// GameEvent flags
+	SnakeCell changes[GAME_MAX_CHANGES];	// cells whose contents changed
+	int changeCount;
+	bool isTurnTimed;	// a queued turn was taken on this tick
+	uint64_t turnTime;	// when that turn was asked for
+} SimTick;
+
+// the game as it was after one tick, never changed while it is being read. records of the last ticks
+// come with it, so a reader that only sees some snapshots still learns every changed cell and turn
+typedef struct SimSnapshot
+{
+	Game *game;	// a copy, with its own board and body
+	SimTick ticks[SIM_HISTORY];	// the record of tick t is in ticks[t % SIM_HISTORY]
+} SimSnapshot;
+
+// steps a game on its own thread, one tick every player->speed milliseconds of clock, however long
+// the thread that draws it takes. inputs come in through a ring with one writer and one reader, and
+// each tick goes out as a snapshot through a triple buffer, so neither side ever waits on the other.
+// while stopped, the game, replay and autopilot belong to the caller again
+typedef struct Simulation
+{
+	Game *game;	// stepped by the thread, touched by the caller only while stopped
+	Replay *replay;	// logs every turn, may be NULL
+	Autopilot *autopilot;	// steers instead of the queued turns while it is on
+	bool isAutopilotOn;
+	InputQueue turns;	// turns waiting for their moves
+	uint64_t (*clock)(void);	// milliseconds, the clock the move times are in
+
+	// commands ring. the caller only moves the tail and the thread only moves the head
+	SimCommand commands[SIM_COMMAND_CAPACITY];
+	unsigned commandHead, commandTail;
+
+	// triple buffer. the thread fills back while the caller reads front, and middle is swapped
+	// between them, with SIM_FRESH set when it holds a snapshot the caller has not taken yet
+	SimSnapshot snapshots[3];
+	int back, middle, front;
+	SimTick history[SIM_HISTORY];	// records of the last ticks, copied into each snapshot
+
+	pthread_t thread;
+	bool isRunning;	// the thread was started and not yet joined
+	bool isStopping;	// set by the caller to end the thread
+} Simulation;
+
+Simulation *CreateSimulation(Game *game, const GameConfig *config, Replay *replay, Autopilot *autopilot, int inputDepth, uint64_t (*clock)(void));
+bool StartSimulation(Simulation *simulation);
+void StopSimulation(Simulation *simulation);
+bool SendSimulation(Simulation *simulation, const SimCommand *command);
+const SimSnapshot *ReadSimulation(Simulation *simulation);
+void DestroySimulation(Simulation *simulation);
+
+#endif
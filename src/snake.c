@@ -1,16 +1,34 @@
 #include "snake.h"
+#include "allocator.h"
+#include <stdlib.h>
+#include <string.h>
 
 
-Snake *CreateSnake(int xPos, int yPos, int nodeWidth, int nodeHeight, Uint64 speed, int length, SnakeDirection direction, SDL_Color *color)
+// smallest ring buffer a snake is given, so short snakes can grow a few times before reallocating
+#define SNAKE_MIN_CAPACITY 16
+
+// round up to the next power of two so ring buffer indices can wrap with a mask
+static int RoundUpPow2(int n)
+{
+	int pow2 = 1;
+	while (pow2 < n)
+	{
+		pow2 <<= 1;
+	}
+
+	return pow2;
+}
+
+Snake *CreateSnake(Board *board, int xPos, int yPos, int nodeWidth, int nodeHeight, uint64_t speed, int length, SnakeDirection direction, SnakeColor *color)
 {
 	// a snake cannot have zero length. if less than 1, return NULL
 	if (length < 1)
-    	{
+	{
 		return NULL;
-    	}
+	}
 
 	// create snake struct and set speed and direction
-    	Snake *snake = malloc(sizeof(Snake));
+	Snake *snake = AllocMemory(sizeof(Snake));
 
 	if (!snake)
 	{
@@ -20,235 +38,202 @@ Snake *CreateSnake(int xPos, int yPos, int nodeWidth, int nodeHeight, Uint64 spe
 	snake->speed = speed;
 	snake->currentDirection = snake->pendingDirection = direction;
 
-	// set shape of each SnakeNode
+	// set shape of each SnakeCell
 	snake->nodeWidth = nodeWidth;
 	snake->nodeHeight = nodeHeight;
 
-	// create snake head and set starting position and size of each node
-    	snake->head = snake->tail = malloc(sizeof(SnakeNode));    
-	if (!snake->head)
+	// create the ring buffer that holds the body
+	snake->capacity = RoundUpPow2(length > SNAKE_MIN_CAPACITY ? length : SNAKE_MIN_CAPACITY);
+	snake->cells = AllocMemory(snake->capacity * sizeof(SnakeCell));
+	if (!snake->cells)
 	{
-		free(snake);
+		FreeMemory(snake);
 		return NULL;
 	}
 
-    	snake->head->xPos = xPos;
-    	snake->head->yPos = yPos;
+	// set starting position of the head and lay out the rest of the snake behind it,
+	// looping to the top of the board if it runs off the bottom
+	snake->headIndex = 0;
 	snake->length = length;
-
-	// create the rest of the snake
-    	for (int i = 1; i < length; ++i)
-    	{
-		//FIXME check snake node malloc
-    	    	snake->tail->next = malloc(sizeof(SnakeNode));
-    	    	snake->tail->next->xPos = snake->tail->xPos;
-    	    	snake->tail->next->yPos = snake->tail->yPos + 1;
-    	    	snake->tail = snake->tail->next;
-    	} //FIXME Make it so that snake can start in different directions.
-    	snake->tail->next = NULL;
+	for (int i = 0; i < length; ++i)
+	{
+		snake->cells[i].xPos = xPos;
+		snake->cells[i].yPos = (yPos + i) % board->height;
+		OccupyBoardCell(board, snake->cells[i].xPos, snake->cells[i].yPos);
+	} //FIXME Make it so that snake can start in different directions.
 
 	snake->color = *color;
 
-    	return snake;
+	return snake;
 }
 
-void StepSnake(Snake *snake, int xMax, int yMax)
+bool SteerSnake(Snake *snake, SnakeDirection direction)
 {
-    	snake->currentDirection = snake->pendingDirection;
-    	int xDelta, yDelta;
-    	// displace the snake depending on the direction it was set to move
-    	switch (snake->currentDirection)
-    	{
+	// a snake cannot turn back into itself, so skip a direction opposite to the current one
+	switch (direction)
+	{
 		case SNAKE_RIGHT:
-			xDelta = 1;
-    	        	yDelta = 0;
-    	        	break;
-    	    	case SNAKE_UP:
-    	    	    	xDelta = 0;
-    	    	    	yDelta = -1;
-    	    	    	break;
-    	    	case SNAKE_LEFT:
-    	    	    	xDelta = -1;
-    	    	    	yDelta = 0;
-    	    	    	break;
-    	    	case SNAKE_DOWN:
-    	    	    	xDelta = 0;
-    	    	    	yDelta = 1;
-    	    	    	break;
-    	    	default:
-    	    	    	return;
-    	}
-    	SnakeNode *cur = snake->head;
-    	int xNext = cur->xPos + xDelta;
-    	int yNext = cur->yPos + yDelta;
-
-    	// if the snake is out of bounds, loop to other side
-    	if (xNext < 0) // snake went left out of bounds
-    	{
-    	    	xNext += xMax;
-    	}
-
-    	if (xNext >= xMax) // snake went right out of bounds
-    	{
-    	    	xNext = 0;
-    	}
-
-    	if (yNext < 0) // snake went up out of bounds
-    	{
-    	    	yNext += yMax;
-    	}
-
-    	if (yNext >= yMax) // snake went down out of bounds
-    	{
-    	    	yNext = 0;
-    	}
-
-    	// update each node of snake to move it
-    	while (cur)
-    	{
-    	    	int xLast = cur->xPos;
-    	    	int yLast = cur->yPos;
-    	    	cur->xPos = xNext;
-    	    	cur->yPos = yNext;
-    	    	xNext = xLast;
-    	    	yNext = yLast;
-    	    	cur = cur->next;
-    	}
-}
+			if (snake->currentDirection == SNAKE_LEFT)
+				return false;
+			break;
+		case SNAKE_UP:
+			if (snake->currentDirection == SNAKE_DOWN)
+				return false;
+			break;
+		case SNAKE_LEFT:
+			if (snake->currentDirection == SNAKE_RIGHT)
+				return false;
+			break;
+		case SNAKE_DOWN:
+			if (snake->currentDirection == SNAKE_UP)
+				return false;
+			break;
+		default:
+			return false;
+	}
 
-void GrowSnake(Snake *snake, int xNew, int yNew)
-{
-	snake->tail->next = malloc(sizeof(SnakeNode));
-	//FIXME Add validation for malloc.
-	snake->tail = snake->tail->next;
-	snake->tail->xPos = xNew;
-	snake->tail->yPos = yNew;
-	snake->tail->next = NULL;
-	++snake->length;
+	snake->pendingDirection = direction;
+
+	return true;
 }
 
-bool CheckCollisionSnake(Snake *snake)
+void StepSnake(Snake *snake, Board *board)
 {
-	// a snake of less than 5 nodes cannot collide with itself
-	if (snake->length < 5)
+	int xMax = board->width;
+	int yMax = board->height;
+	snake->currentDirection = snake->pendingDirection;
+	int xDelta, yDelta;
+	// displace the snake depending on the direction it was set to move
+	switch (snake->currentDirection)
 	{
-		return false;
+		case SNAKE_RIGHT:
+			xDelta = 1;
+			yDelta = 0;
+			break;
+		case SNAKE_UP:
+			xDelta = 0;
+			yDelta = -1;
+			break;
+		case SNAKE_LEFT:
+			xDelta = -1;
+			yDelta = 0;
+			break;
+		case SNAKE_DOWN:
+			xDelta = 0;
+			yDelta = 1;
+			break;
+		default:
+			return;
 	}
+	SnakeCell *head = SnakeHead(snake);
+	int xNext = head->xPos + xDelta;
+	int yNext = head->yPos + yDelta;
 
-	// a snake of minimum 5 nodes has a 5th node to start from
-	SnakeNode *cur = snake->head->next->next->next->next;
-	while (cur)
+	// if the snake is out of bounds, loop to other side
+	if (xNext < 0) // snake went left out of bounds
 	{
-		// if the position of a node is the same as the head, then collision
-		if (cur->xPos == snake->head->xPos && cur->yPos == snake->head->yPos)
-		{
-			return true;
-		}
+		xNext += xMax;
+	}
 
-		cur = cur->next;
+	if (xNext >= xMax) // snake went right out of bounds
+	{
+		xNext = 0;
 	}
 
-	return false;
+	if (yNext < 0) // snake went up out of bounds
+	{
+		yNext += yMax;
+	}
+
+	if (yNext >= yMax) // snake went down out of bounds
+	{
+		yNext = 0;
+	}
+
+	// the tail leaves its cell before the head enters the next one, so the head may
+	// follow right behind the tail without colliding
+	SnakeCell *tail = SnakeTail(snake);
+	VacateBoardCell(board, tail->xPos, tail->yPos);
+	OccupyBoardCell(board, xNext, yNext);
+
+	// push the new head one slot behind the old one. the tail slot falls out of the
+	// snake's length, or is overwritten when the ring buffer is full
+	snake->headIndex = (snake->headIndex - 1) & (snake->capacity - 1);
+	snake->cells[snake->headIndex].xPos = xNext;
+	snake->cells[snake->headIndex].yPos = yNext;
 }
 
-bool RenderSnake(SDL_Renderer *renderer, Snake *snake, int xOrigin, int yOrigin, int xMultiplier, int yMultiplier)
+bool ReserveSnake(Snake *snake, int capacity)
 {
-	SnakeNode *cur = snake->head;
-
-	if (SDL_SetRenderDrawColor(renderer, snake->color.r, snake->color.g, snake->color.b, snake->color.a) != 0)
+	capacity = RoundUpPow2(capacity);
+	if (capacity <= snake->capacity)
 	{
-		return false;
+		return true;
 	}
 
-	while (cur)
+	// move the body into the bigger ring buffer, unrolled so the head is at index 0
+	SnakeCell *cells = AllocMemory(capacity * sizeof(SnakeCell));
+	if (!cells)
 	{
-		SDL_Rect rect = {xOrigin + cur->xPos * xMultiplier, yOrigin + cur->yPos * yMultiplier, snake->nodeWidth, snake->nodeHeight};
-		if (SDL_RenderFillRect(renderer, &rect) != 0)
-		{
-			return false;
-		}
-		cur = cur->next;
+		return false;
 	}
 
-	return true;
-}
+	int headSpan = snake->capacity - snake->headIndex;
+	int bodySpan = snake->length < headSpan ? snake->length : headSpan;
+	memcpy(cells, snake->cells + snake->headIndex, bodySpan * sizeof(SnakeCell));
+	memcpy(cells + bodySpan, snake->cells, (snake->length - bodySpan) * sizeof(SnakeCell));
 
-void DestroySnake(Snake *snake)
-{
-	// loop through every SnakeNode and free it
-    	while (snake->head)
-    	{
-    	    	SnakeNode *next = snake->head->next;
-    	    	free(snake->head);
-    	    	snake->head = next;
-    	}
-
-	// free Snake struct
-    	free(snake);
+	FreeMemory(snake->cells);
+	snake->cells = cells;
+	snake->capacity = capacity;
+	snake->headIndex = 0;
+
+	return true;
 }
 
-Food *CreateFood(SDL_Renderer *renderer, FoodType type, int xPos, int yPos, int textureWidth, int textureHeight, const char *filepath)
+bool GrowSnake(Snake *snake, Board *board, int xNew, int yNew)
 {
-	Food *food = malloc(sizeof(Food));
-	//FIXME Validate food malloc.
-	food->type = type;
-	food->texture = IMG_LoadTexture(renderer, filepath);
-	if (!(food && filepath))
+	// if the ring buffer is full, double it
+	if (snake->length == snake->capacity && !ReserveSnake(snake, snake->capacity * 2))
 	{
-		free(food);
-		return NULL;
+		return false;
 	}
 
-	food->xPos = xPos;
-	food->yPos = yPos;
-	food->textureWidth = textureWidth;
-	food->textureHeight = textureHeight;
+	// the new cell goes right after the tail
+	++snake->length;
+	SnakeCell *tail = SnakeTail(snake);
+	tail->xPos = xNew;
+	tail->yPos = yNew;
+	OccupyBoardCell(board, xNew, yNew);
 
-	return food;
+	return true;
 }
 
-void RandPosFood(Food *food, Snake *snake, int xMax, int yMax)
+bool CheckCollisionSnake(Snake *snake, Board *board)
 {
-	//FIXME Check if snake spans entire screen.
-	
-	bool validPos = false;
-	while (!validPos)
-	{
-		//FIXME I should probably set these to a temporary variable just in case.
-		// get a random x and y position in a grid layout
-		food->xPos = rand() % xMax;
-		food->yPos = rand() % yMax;
-
-		validPos = true;
-		SnakeNode *cur = snake->head;
-		while(cur)
-		{
-			// if the food exists in the same place as the snake, find new random position
-			if (food->xPos == cur->xPos && food->yPos == cur->yPos) // I fixed a bug here! Can you guess it? :)
-			{
-				validPos = false;
-				break;
-			}
-
-			cur = cur->next;
-		}
-	}
+	// the head collided if something else shares its cell
+	SnakeCell *head = SnakeHead(snake);
+	return CountBoardCell(board, head->xPos, head->yPos) > 1;
+}
+
+void DestroySnake(Snake *snake)
+{
+	// free the body, then the Snake struct
+	FreeMemory(snake->cells);
+	FreeMemory(snake);
 }
 
-bool RenderFood(SDL_Renderer *renderer, Food *food, int xOrigin, int yOrigin, int xMultiplier, int yMultiplier)
+bool RandPosFood(Food *food, Board *board, Random *random)
 {
-	SDL_Rect rect = {xOrigin + food->xPos * xMultiplier, yOrigin + food->yPos * yMultiplier, food->textureWidth, food->textureHeight};
-	if (SDL_RenderCopy(renderer, food->texture, NULL, &rect) != 0)
+	// pick a random free cell. if the snake fills the board, there is none and the food stays put
+	int xPos, yPos;
+	if (!RandFreeBoardCell(board, random, &xPos, &yPos))
 	{
 		return false;
 	}
 
-	return true;	
-}
+	food->xPos = xPos;
+	food->yPos = yPos;
 
-void DestroyFood(Food *food)
-{
-	SDL_DestroyTexture(food->texture);
-	free(food);
+	return true;
 }
-
@@ -2,8 +2,8 @@
 #define SNAKE_H
 
 #include <stdbool.h>
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_image.h>
+#include <stdint.h>
+#include "board.h"
 
 
 /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -13,65 +13,86 @@
 // directions that snakes can take
 typedef enum
 {
-   	SNAKE_RIGHT = 'r',
-   	SNAKE_UP = 'u',
-   	SNAKE_LEFT = 'l',
-   	SNAKE_DOWN = 'd'
+	SNAKE_RIGHT = 'r',
+	SNAKE_UP = 'u',
+	SNAKE_LEFT = 'l',
+	SNAKE_DOWN = 'd'
 } SnakeDirection;
 
 // different types of foods that can appear
 typedef enum
 {
-    	FOOD_APPLE = 'a'
+	FOOD_APPLE = 'a'
 } FoodType;
 
 
 /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
- * Declare Snake, SnakeNode, Food structs.
+ * Declare SnakeColor, Snake, SnakeCell, Food structs.
  */	
 
-// the parts of the snake that are displayed to screen and their properties
-// in the form of a linked list node
-typedef struct SnakeNode
+// color of a snake, laid out the same as SDL_Color so the renderer can use it directly
+typedef struct SnakeColor
+{
+	uint8_t r, g, b, a;
+} SnakeColor;
+
+// the parts of the snake that are displayed to screen, stored by position only
+typedef struct SnakeCell
 {
-    	struct SnakeNode *next;
 	int xPos, yPos;
-} SnakeNode;
+} SnakeCell;
 
-// snake container struct that holds overall properties and the head SnakeNode
+// snake container struct that holds overall properties and the body cells
+// the body is a ring buffer: cells[headIndex] is the head and the cells that follow
+// it (wrapping around at capacity) lead to the tail. moving pushes a new head and
+// drops the tail, so a step costs the same no matter how long the snake is.
 typedef struct Snake
 {
-    	SnakeNode *head, *tail;
-    	Uint64 speed;	// in units of milliseconds per block
-    	int nodeWidth, nodeHeight;	// width and height of each SnakeNode
-	int length;	// number of SnakeNodes
+	SnakeCell *cells;	// ring buffer of body cells
+	int capacity;	// number of cells the ring buffer can hold, always a power of two
+	int headIndex;	// index of the head cell in the ring buffer
+	uint64_t speed;	// in units of milliseconds per block
+	int nodeWidth, nodeHeight;	// width and height of each SnakeCell
+	int length;	// number of SnakeCells
 	SnakeDirection currentDirection;	// current direction of the snake
-    	SnakeDirection pendingDirection;	// direction for the next move of the snake
-    	Uint64 lastMoveTime;	// time in milliseconds since last move
-    	Uint64 nextMoveTime;	// time in milliseconds until next move
-	SDL_Color color;	// color of SnakeNodes
+	SnakeDirection pendingDirection;	// direction for the next move of the snake
+	uint64_t lastMoveTime;	// time in milliseconds since last move
+	uint64_t nextMoveTime;	// time in milliseconds until next move
+	SnakeColor color;	// color of SnakeCells
 } Snake;
 
 // food for the snake to eat!!
 typedef struct Food
 {
-    	FoodType type;
+	FoodType type;
 	int xPos, yPos;
-	int textureWidth, textureHeight;
-    	SDL_Texture *texture;	// food texture
 } Food;
 
-Snake *CreateSnake(int xPos, int yPos, int nodeWidth, int nodeHeight, Uint64 speed, int length, SnakeDirection direction, SDL_Color *color);
-void StepSnake(Snake *snake, int xMax, int yMax);
-void GrowSnake(Snake *snake, int xNew, int yNew);
-bool CheckCollisionSnake(Snake *snake);
-bool RenderSnake(SDL_Renderer *renderer, Snake *snake, int xOrigin, int yOrigin, int xMultiplier, int yMultiplier);
+// get the i-th cell of the snake counting from the head (0 is the head, length - 1 is the tail)
+static inline SnakeCell *SnakeCellAt(Snake *snake, int i)
+{
+	return &snake->cells[(snake->headIndex + i) & (snake->capacity - 1)];
+}
+
+static inline SnakeCell *SnakeHead(Snake *snake)
+{
+	return &snake->cells[snake->headIndex];
+}
+
+static inline SnakeCell *SnakeTail(Snake *snake)
+{
+	return SnakeCellAt(snake, snake->length - 1);
+}
+
+Snake *CreateSnake(Board *board, int xPos, int yPos, int nodeWidth, int nodeHeight, uint64_t speed, int length, SnakeDirection direction, SnakeColor *color);
+bool SteerSnake(Snake *snake, SnakeDirection direction);
+bool ReserveSnake(Snake *snake, int capacity);
+void StepSnake(Snake *snake, Board *board);
+bool GrowSnake(Snake *snake, Board *board, int xNew, int yNew);
+bool CheckCollisionSnake(Snake *snake, Board *board);
 void DestroySnake(Snake *snake);
 
-Food *CreateFood(SDL_Renderer *renderer, FoodType type, int xPos, int yPos, int textureWidth, int textureHeight, const char *filepath);
-void RandPosFood(Food *food, Snake *snake, int xMax, int yMax);
-bool RenderFood(SDL_Renderer *renderer, Food *food, int xOrigin, int yOrigin, int xMultiplier, int yMultiplier);
-void DestroyFood(Food *food);
+bool RandPosFood(Food *food, Board *board, Random *random);
 
 
 #endif
@@ -0,0 +1,321 @@
+#include "sparse.h"
+#include "allocator.h"
+#include <string.h>
+
+
+// smallest map and tile list a sparse board starts with
+#define SPARSE_MIN_SLOTS 64
+#define SPARSE_MIN_TILES 16
+// random cells RandFreeSparseBoardCell tries before giving up on a crowded board
+#define SPARSE_FREE_TRIES 64
+
+static bool GrowSparseMap(SparseMap *map);
+static void ReleaseSparseBoardTile(SparseBoard *board, int index);
+
+SparseMap *CreateSparseMap(int capacity)
+{
+	SparseMap *map = AllocMemory(sizeof(SparseMap));
+	if (!map)
+	{
+		return NULL;
+	}
+
+	// round up to a power of two so slots wrap with a mask
+	map->capacity = SPARSE_MIN_SLOTS;
+	while (map->capacity < capacity)
+	{
+		map->capacity <<= 1;
+	}
+	map->count = 0;
+	map->keys = AllocMemory(map->capacity * sizeof(int64_t));
+	map->values = AllocMemory(map->capacity * sizeof(int));
+	if (!(map->keys && map->values))
+	{
+		DestroySparseMap(map);
+		return NULL;
+	}
+
+	// every slot starts out empty
+	memset(map->keys, 0xFF, map->capacity * sizeof(int64_t));
+
+	return map;
+}
+
+bool PutSparseMap(SparseMap *map, int64_t key, int value)
+{
+	int slot = SlotOfSparseMap(map, key);
+	while (map->keys[slot] >= 0 && map->keys[slot] != key)
+	{
+		slot = (slot + 1) & (map->capacity - 1);
+	}
+
+	// a key already in the map only gets its value changed
+	if (map->keys[slot] == key)
+	{
+		map->values[slot] = value;
+		return true;
+	}
+
+	// keep the map at most half full so the walks stay short
+	if ((map->count + 1) * 2 > map->capacity)
+	{
+		if (!GrowSparseMap(map))
+		{
+			return false;
+		}
+
+		slot = SlotOfSparseMap(map, key);
+		while (map->keys[slot] >= 0)
+		{
+			slot = (slot + 1) & (map->capacity - 1);
+		}
+	}
+
+	map->keys[slot] = key;
+	map->values[slot] = value;
+	++map->count;
+
+	return true;
+}
+
+void RemoveSparseMap(SparseMap *map, int64_t key)
+{
+	int mask = map->capacity - 1;
+	int slot = SlotOfSparseMap(map, key);
+	while (map->keys[slot] != key)
+	{
+		if (map->keys[slot] < 0)
+		{
+			return;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	// empty the slot, then move back any later key of the same run that can no longer be found
+	// past the gap. no tombstones are left, so lookups never slow down as keys come and go
+	int gap = slot;
+	for (int next = (gap + 1) & mask; map->keys[next] >= 0; next = (next + 1) & mask)
+	{
+		int home = SlotOfSparseMap(map, map->keys[next]);
+		if (((next - home) & mask) >= ((next - gap) & mask))
+		{
+			map->keys[gap] = map->keys[next];
+			map->values[gap] = map->values[next];
+			gap = next;
+		}
+	}
+	map->keys[gap] = -1;
+	--map->count;
+}
+
+void DestroySparseMap(SparseMap *map)
+{
+	FreeMemory(map->keys);
+	FreeMemory(map->values);
+	FreeMemory(map);
+}
+
+SparseBoard *CreateSparseBoard(int width, int height)
+{
+	// a board needs at least one cell
+	if (width < 1 || height < 1)
+	{
+		return NULL;
+	}
+
+	SparseBoard *board = CallocMemory(1, sizeof(SparseBoard));
+	if (!board)
+	{
+		return NULL;
+	}
+
+	board->width = width;
+	board->height = height;
+	board->tileCapacity = SPARSE_MIN_TILES;
+	board->tileMap = CreateSparseMap(SPARSE_MIN_TILES * 2);
+	board->tiles = AllocMemory(board->tileCapacity * sizeof(SparseTile *));
+	board->spareTiles = AllocMemory(board->tileCapacity * sizeof(SparseTile *));
+	if (!(board->tileMap && board->tiles && board->spareTiles))
+	{
+		DestroySparseBoard(board);
+		return NULL;
+	}
+
+	return board;
+}
+
+SparseTile *TouchSparseBoardTile(SparseBoard *board, int x, int y)
+{
+	SparseTile *tile = FindSparseBoardTile(board, x, y);
+	if (tile)
+	{
+		return tile;
+	}
+
+	// make room for one more tile in both lists, so a tile can always be put back as a spare
+	if (board->tileCount == board->tileCapacity)
+	{
+		int capacity = board->tileCapacity * 2;
+		SparseTile **tiles = ReallocMemory(board->tiles, capacity * sizeof(SparseTile *));
+		if (!tiles)
+		{
+			return NULL;
+		}
+		board->tiles = tiles;
+
+		SparseTile **spareTiles = ReallocMemory(board->spareTiles, capacity * sizeof(SparseTile *));
+		if (!spareTiles)
+		{
+			return NULL;
+		}
+		board->spareTiles = spareTiles;
+		board->tileCapacity = capacity;
+	}
+
+	// reuse an emptied tile if there is one, its counts are all 0 already
+	tile = board->spareCount > 0 ? board->spareTiles[--board->spareCount] : CallocMemory(1, sizeof(SparseTile));
+	if (!tile)
+	{
+		return NULL;
+	}
+
+	tile->xTile = x >> SPARSE_TILE_SHIFT;
+	tile->yTile = y >> SPARSE_TILE_SHIFT;
+	tile->used = 0;
+	if (!PutSparseMap(board->tileMap, KeyOfSparseTile(tile->xTile, tile->yTile), board->tileCount))
+	{
+		board->spareTiles[board->spareCount++] = tile;
+		return NULL;
+	}
+	board->tiles[board->tileCount++] = tile;
+
+	return tile;
+}
+
+void TrimSparseBoardTile(SparseBoard *board, int x, int y)
+{
+	int index = FindSparseMap(board->tileMap, KeyOfSparseTile(x >> SPARSE_TILE_SHIFT, y >> SPARSE_TILE_SHIFT));
+	if (index >= 0 && board->tiles[index]->used == 0)
+	{
+		ReleaseSparseBoardTile(board, index);
+	}
+}
+
+bool OccupySparseBoardCell(SparseBoard *board, int x, int y)
+{
+	SparseTile *tile = TouchSparseBoardTile(board, x, y);
+	if (!tile)
+	{
+		return false;
+	}
+
+	if (tile->counts[(y & SPARSE_TILE_MASK) << SPARSE_TILE_SHIFT | (x & SPARSE_TILE_MASK)]++ == 0)
+	{
+		++tile->used;
+	}
+
+	return true;
+}
+
+void VacateSparseBoardCell(SparseBoard *board, int x, int y)
+{
+	int index = FindSparseMap(board->tileMap, KeyOfSparseTile(x >> SPARSE_TILE_SHIFT, y >> SPARSE_TILE_SHIFT));
+	SparseTile *tile = board->tiles[index];
+
+	// the last cell to leave a tile takes the tile with it
+	if (--tile->counts[(y & SPARSE_TILE_MASK) << SPARSE_TILE_SHIFT | (x & SPARSE_TILE_MASK)] == 0 && --tile->used == 0)
+	{
+		ReleaseSparseBoardTile(board, index);
+	}
+}
+
+bool RandFreeSparseBoardCell(SparseBoard *board, Random *random, int *x, int *y)
+{
+	// a sparse board is almost all free, so a few random picks find a free cell without keeping a
+	// free list as long as the board's area
+	for (int i = 0; i < SPARSE_FREE_TRIES; ++i)
+	{
+		int xPos = (int) RangeRandom(random, (uint32_t) board->width);
+		int yPos = (int) RangeRandom(random, (uint32_t) board->height);
+		if (IsFreeSparseBoardCell(board, xPos, yPos))
+		{
+			*x = xPos;
+			*y = yPos;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void DestroySparseBoard(SparseBoard *board)
+{
+	for (int i = 0; i < board->tileCount; ++i)
+	{
+		FreeMemory(board->tiles[i]);
+	}
+	for (int i = 0; i < board->spareCount; ++i)
+	{
+		FreeMemory(board->spareTiles[i]);
+	}
+
+	if (board->tileMap)
+	{
+		DestroySparseMap(board->tileMap);
+	}
+	FreeMemory(board->tiles);
+	FreeMemory(board->spareTiles);
+	FreeMemory(board);
+}
+
+static bool GrowSparseMap(SparseMap *map)
+{
+	// put every key again into a map twice the size
+	SparseMap grown = {NULL, NULL, map->capacity * 2, 0};
+	grown.keys = AllocMemory(grown.capacity * sizeof(int64_t));
+	grown.values = AllocMemory(grown.capacity * sizeof(int));
+	if (!(grown.keys && grown.values))
+	{
+		FreeMemory(grown.keys);
+		FreeMemory(grown.values);
+		return false;
+	}
+	memset(grown.keys, 0xFF, grown.capacity * sizeof(int64_t));
+
+	for (int slot = 0; slot < map->capacity; ++slot)
+	{
+		if (map->keys[slot] >= 0)
+		{
+			int target = SlotOfSparseMap(&grown, map->keys[slot]);
+			while (grown.keys[target] >= 0)
+			{
+				target = (target + 1) & (grown.capacity - 1);
+			}
+			grown.keys[target] = map->keys[slot];
+			grown.values[target] = map->values[slot];
+			++grown.count;
+		}
+	}
+
+	FreeMemory(map->keys);
+	FreeMemory(map->values);
+	*map = grown;
+
+	return true;
+}
+
+static void ReleaseSparseBoardTile(SparseBoard *board, int index)
+{
+	// take the tile out of the map and fill its slot in the list with the last tile
+	SparseTile *tile = board->tiles[index];
+	RemoveSparseMap(board->tileMap, KeyOfSparseTile(tile->xTile, tile->yTile));
+
+	SparseTile *last = board->tiles[--board->tileCount];
+	if (last != tile)
+	{
+		board->tiles[index] = last;
+		PutSparseMap(board->tileMap, KeyOfSparseTile(last->xTile, last->yTile), index);
+	}
+
+	board->spareTiles[board->spareCount++] = tile;
+}
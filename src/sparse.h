@@ -0,0 +1,128 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "random.h"
+
+
+// cells on a side of a tile, a power of two so a cell splits into tile and offset with shifts
+#define SPARSE_TILE_SHIFT 4
+#define SPARSE_TILE_SIDE (1 << SPARSE_TILE_SHIFT)
+#define SPARSE_TILE_MASK (SPARSE_TILE_SIDE - 1)
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare SparseMap, SparseTile, SparseBoard structs.
+ */
+
+// hash map from 64 bit keys to ints with open addressing, so a lookup is a multiply and a short
+// walk through one array. keys must not be negative, -1 marks an empty slot
+typedef struct SparseMap
+{
+	int64_t *keys;
+	int *values;
+	int capacity;	// number of slots, always a power of two
+	int count;	// number of keys in the map
+} SparseMap;
+
+// a square of the board's occupancy counts, laid out like Board's
+typedef struct SparseTile
+{
+	int xTile, yTile;	// position of the tile in tiles
+	int used;	// cells on the tile with a nonzero count
+	uint16_t counts[SPARSE_TILE_SIDE * SPARSE_TILE_SIDE];	// indexed by y offset * SPARSE_TILE_SIDE + x offset
+} SparseTile;
+
+// occupancy of a board too big to keep every cell of. the board is cut into tiles that exist only
+// while something sits on them, found through a hash from tile position to tile, so memory follows
+// the snakes instead of the board's area. a tile that empties out is kept for the next one needed
+typedef struct SparseBoard
+{
+	int width, height;	// size of the board in cells, the edges wrap around like Board's
+	SparseMap *tileMap;	// tile key to index in tiles
+	SparseTile **tiles;	// tiles in use, the first tileCount entries are valid
+	int tileCount;
+	SparseTile **spareTiles;	// emptied tiles kept for reuse
+	int spareCount;
+	int tileCapacity;	// entries allocated in tiles and in spareTiles
+} SparseBoard;
+
+SparseMap *CreateSparseMap(int capacity);
+bool PutSparseMap(SparseMap *map, int64_t key, int value);
+void RemoveSparseMap(SparseMap *map, int64_t key);
+void DestroySparseMap(SparseMap *map);
+
+SparseBoard *CreateSparseBoard(int width, int height);
+SparseTile *TouchSparseBoardTile(SparseBoard *board, int x, int y);
+void TrimSparseBoardTile(SparseBoard *board, int x, int y);
+bool OccupySparseBoardCell(SparseBoard *board, int x, int y);
+void VacateSparseBoardCell(SparseBoard *board, int x, int y);
+bool RandFreeSparseBoardCell(SparseBoard *board, Random *random, int *x, int *y);
+void DestroySparseBoard(SparseBoard *board);
+
+// slot a key hashes to. the multiply spreads neighbouring keys over the whole map
+static inline int SlotOfSparseMap(const SparseMap *map, int64_t key)
+{
+	return (int) (((uint64_t) key * 0x9E3779B97F4A7C15ULL) >> 32) & (map->capacity - 1);
+}
+
+// value of a key, or -1 if the key is not in the map
+static inline int FindSparseMap(const SparseMap *map, int64_t key)
+{
+	for (int slot = SlotOfSparseMap(map, key); map->keys[slot] >= 0; slot = (slot + 1) & (map->capacity - 1))
+	{
+		if (map->keys[slot] == key)
+		{
+			return map->values[slot];
+		}
+	}
+
+	return -1;
+}
+
+static inline int64_t KeyOfSparseTile(int xTile, int yTile)
+{
+	return (int64_t) yTile << 32 | (uint32_t) xTile;
+}
+
+// tile that holds the cell at x, y, or NULL if nothing sits anywhere on it
+static inline SparseTile *FindSparseBoardTile(const SparseBoard *board, int x, int y)
+{
+	int index = FindSparseMap(board->tileMap, KeyOfSparseTile(x >> SPARSE_TILE_SHIFT, y >> SPARSE_TILE_SHIFT));
+	return index >= 0 ? board->tiles[index] : NULL;
+}
+
+static inline int CountSparseBoardCell(const SparseBoard *board, int x, int y)
+{
+	SparseTile *tile = FindSparseBoardTile(board, x, y);
+	return tile ? tile->counts[(y & SPARSE_TILE_MASK) << SPARSE_TILE_SHIFT | (x & SPARSE_TILE_MASK)] : 0;
+}
+
+static inline bool IsFreeSparseBoardCell(const SparseBoard *board, int x, int y)
+{
+	return CountSparseBoardCell(board, x, y) == 0;
+}
+
+// change the count of a cell while other threads may be changing counts too, like AddBoardCellCount.
+// the cell's tile must already exist, see TouchSparseBoardTile, and a tile left empty stays until
+// TrimSparseBoardTile is called for it
+static inline void AddSparseBoardCellCount(SparseBoard *board, int x, int y, int delta)
+{
+	SparseTile *tile = FindSparseBoardTile(board, x, y);
+	uint16_t *count = &tile->counts[(y & SPARSE_TILE_MASK) << SPARSE_TILE_SHIFT | (x & SPARSE_TILE_MASK)];
+	int before = __atomic_fetch_add(count, (uint16_t) delta, __ATOMIC_RELAXED);
+	int after = (uint16_t) (before + delta);
+
+	if (before == 0 && after != 0)
+	{
+		__atomic_fetch_add(&tile->used, 1, __ATOMIC_RELAXED);
+	}
+	else if (before != 0 && after == 0)
+	{
+		__atomic_fetch_sub(&tile->used, 1, __ATOMIC_RELAXED);
+	}
+}
+
+#endif
@@ -0,0 +1,648 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "state.h"
+#include "allocator.h"
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+
+// first bytes of every state file
+static const uint8_t STATE_MAGIC[4] = {'M', 'S', 'S', 'T'};
+#define STATE_BYTE_ORDER 0x01020304u
+// sections start on a multiple of this, so every array in a mapped file is aligned for any type
+#define STATE_ALIGN 64
+// most pieces of memory one state is gathered from: the header, then up to two pieces and a pad per section
+#define STATE_MAX_PARTS (1 + 3 * STATE_MAX_SECTIONS)
+
+// every field of a game that is not an array, in one block
+typedef struct GameStateFields
+{
+	GameConfig config;
+	uint64_t tick;
+	Random random;
+	Food food;
+	bool isOver;
+	int width, height;	// of the board
+	int freeCount;
+	int length;	// of the player
+	SnakeDirection currentDirection, pendingDirection;
+	uint64_t speed, lastMoveTime, nextMoveTime;
+	int nodeWidth, nodeHeight;
+	SnakeColor color;
+} GameStateFields;
+
+// every field of a world that is not an array, in one block
+typedef struct WorldStateFields
+{
+	int width, height;
+	uint64_t tick;
+	Random random;
+	int snakeCount;
+	int poolUsed;
+	int foodCount;
+	int freeCount;
+} WorldStateFields;
+
+// the pieces of memory a state is written from, in file order, and where each section lands
+typedef struct StateWriter
+{
+	StateHeader header;
+	struct iovec parts[STATE_MAX_PARTS];
+	int partCount;
+	uint64_t size;	// bytes of the file so far
+} StateWriter;
+
+// a state file mapped into memory
+typedef struct StateReader
+{
+	const uint8_t *data;
+	size_t size;
+	const StateHeader *header;
+} StateReader;
+
+static void StartStateWriter(StateWriter *writer, StateKind kind);
+static void AddStateSection(StateWriter *writer, const void *data, size_t size);
+static void ExtendStateSection(StateWriter *writer, const void *data, size_t size);
+static bool WriteStateFile(StateWriter *writer, const char *path);
+static bool OpenStateReader(StateReader *reader, const char *path, StateKind kind);
+static const void *GetStateSection(StateReader *reader, int section, size_t size);
+static void CloseStateReader(StateReader *reader);
+static bool IsStateCellInside(int x, int y, int width, int height);
+static bool IsStateDirection(SnakeDirection direction);
+static bool IsStateBoardValid(const uint16_t *counts, const int *freeCells, const int *freeSlots, int freeCount, int cellCount);
+
+bool SaveGameState(Game *game, const GameConfig *config, const char *path)
+{
+	Board *board = game->board;
+	Snake *player = game->player;
+
+	// the fields, with the padding between them cleared so the same game always gives the same file
+	GameStateFields fields;
+	memset(&fields, 0, sizeof(fields));
+	fields.config = *config;
+	fields.tick = game->tick;
+	fields.random = game->random;
+	fields.food = game->food;
+	fields.isOver = game->isOver;
+	fields.width = board->width;
+	fields.height = board->height;
+	fields.freeCount = board->freeCount;
+	fields.length = player->length;
+	fields.currentDirection = player->currentDirection;
+	fields.pendingDirection = player->pendingDirection;
+	fields.speed = player->speed;
+	fields.lastMoveTime = player->lastMoveTime;
+	fields.nextMoveTime = player->nextMoveTime;
+	fields.nodeWidth = player->nodeWidth;
+	fields.nodeHeight = player->nodeHeight;
+	fields.color = player->color;
+
+	size_t cellCount = (size_t) board->width * board->height;
+	StateWriter writer;
+	StartStateWriter(&writer, STATE_GAME);
+	AddStateSection(&writer, &fields, sizeof(fields));
+
+	// the body from head to tail, in two pieces if it wraps around the end of the ring buffer
+	int headSpan = player->capacity - player->headIndex;
+	int bodySpan = player->length < headSpan ? player->length : headSpan;
+	AddStateSection(&writer, player->cells + player->headIndex, bodySpan * sizeof(SnakeCell));
+	ExtendStateSection(&writer, player->cells, (player->length - bodySpan) * sizeof(SnakeCell));
+
+	// the board as it is, free list order included, since that order decides where the food goes next
+	AddStateSection(&writer, board->counts, (cellCount + 1) * sizeof(uint16_t));
+	AddStateSection(&writer, board->freeCells, board->freeCount * sizeof(int));
+	AddStateSection(&writer, board->freeSlots, cellCount * sizeof(int));
+
+	return WriteStateFile(&writer, path);
+}
+
+Game *LoadGameState(const char *path, GameConfig *config)
+{
+	StateReader reader;
+	if (!OpenStateReader(&reader, path, STATE_GAME))
+	{
+		return NULL;
+	}
+
+	// check the fields against each other before sizing anything by them
+	const GameStateFields *fields = GetStateSection(&reader, 0, sizeof(GameStateFields));
+	if (!fields || fields->width < 1 || fields->height < 1 || (long long) fields->width * fields->height > INT_MAX
+		|| fields->length < 1 || fields->length > fields->width * fields->height || fields->freeCount < 0 || fields->freeCount > fields->width * fields->height)
+	{
+		CloseStateReader(&reader);
+		return NULL;
+	}
+
+	size_t cellCount = (size_t) fields->width * fields->height;
+	const SnakeCell *cells = GetStateSection(&reader, 1, fields->length * sizeof(SnakeCell));
+	const uint16_t *counts = GetStateSection(&reader, 2, (cellCount + 1) * sizeof(uint16_t));
+	const int *freeCells = GetStateSection(&reader, 3, fields->freeCount * sizeof(int));
+	const int *freeSlots = GetStateSection(&reader, 4, cellCount * sizeof(int));
+	if (!(cells && counts && freeCells && freeSlots))
+	{
+		CloseStateReader(&reader);
+		return NULL;
+	}
+
+	// everything copied in is checked first, since stepping the game indexes the board with the
+	// body, the food and the free list without looking
+	bool isValid = IsStateCellInside(fields->food.xPos, fields->food.yPos, fields->width, fields->height)
+		&& IsStateDirection(fields->currentDirection) && IsStateDirection(fields->pendingDirection)
+		&& IsStateBoardValid(counts, freeCells, freeSlots, fields->freeCount, (int) cellCount);
+	for (int i = 0; i < fields->length && isValid; ++i)
+	{
+		isValid = IsStateCellInside(cells[i].xPos, cells[i].yPos, fields->width, fields->height);
+	}
+	if (!isValid)
+	{
+		CloseStateReader(&reader);
+		return NULL;
+	}
+
+	// the player's ring buffer is as big as CreateGame makes it, so growing never touches the heap
+	int capacity = 1;
+	while (capacity < (int) cellCount)
+	{
+		capacity <<= 1;
+	}
+
+	Game *game = CallocMemory(1, sizeof(Game));
+	Snake *player = CallocMemory(1, sizeof(Snake));
+	Board *board = CreateBoard(fields->width, fields->height);
+	SnakeCell *ring = AllocMemory(capacity * sizeof(SnakeCell));
+	if (!(game && player && board && ring))
+	{
+		FreeMemory(ring);
+		if (board)
+			DestroyBoard(board);
+		FreeMemory(player);
+		FreeMemory(game);
+		CloseStateReader(&reader);
+		return NULL;
+	}
+
+	// every array is copied straight out of the file into place
+	memcpy(ring, cells, fields->length * sizeof(SnakeCell));
+	memcpy(board->counts, counts, (cellCount + 1) * sizeof(uint16_t));
+	memcpy(board->freeCells, freeCells, fields->freeCount * sizeof(int));
+	memcpy(board->freeSlots, freeSlots, cellCount * sizeof(int));
+	board->freeCount = fields->freeCount;
+
+	player->cells = ring;
+	player->capacity = capacity;
+	player->headIndex = 0;
+	player->length = fields->length;
+	player->speed = fields->speed;
+	player->nodeWidth = fields->nodeWidth;
+	player->nodeHeight = fields->nodeHeight;
+	player->currentDirection = fields->currentDirection;
+	player->pendingDirection = fields->pendingDirection;
+	player->lastMoveTime = fields->lastMoveTime;
+	player->nextMoveTime = fields->nextMoveTime;
+	player->color = fields->color;
+
+	game->board = board;
+	game->player = player;
+	game->food = fields->food;
+	game->random = fields->random;
+	game->tick = fields->tick;
+	game->isOver = fields->isOver;
+	game->changeCount = 0;
+	if (config)
+	{
+		*config = fields->config;
+	}
+
+	CloseStateReader(&reader);
+
+	return game;
+}
+
+bool SaveWorldState(World *world, const char *path)
+{
+	// the tiles of a sparse board are not saved
+	Board *board = world->board;
+	if (!board)
+	{
+		return false;
+	}
+
+	WorldStateFields fields;
+	memset(&fields, 0, sizeof(fields));
+	fields.width = world->width;
+	fields.height = world->height;
+	fields.tick = world->tick;
+	fields.random = world->random;
+	fields.snakeCount = world->snakeCount;
+	fields.foodCount = world->foodCount;
+	fields.freeCount = board->freeCount;
+
+	// the pool is saved packed, one snake's span after the other, leaving out the spans snakes have
+	// outgrown. that costs a copy of each span here, so loading never walks a body
+	size_t snakes = (size_t) world->snakeCount;
+	int poolUsed = 0;
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		poolUsed += world->bodyCapacity[snake];
+	}
+
+	SnakeCell *pool = AllocMemory((poolUsed > 0 ? poolUsed : 1) * sizeof(SnakeCell));
+	int *bodyStart = AllocMemory((snakes > 0 ? snakes : 1) * sizeof(int));
+	if (!(pool && bodyStart))
+	{
+		FreeMemory(pool);
+		FreeMemory(bodyStart);
+		return false;
+	}
+
+	int used = 0;
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		memcpy(pool + used, world->pool + world->bodyStart[snake], world->bodyCapacity[snake] * sizeof(SnakeCell));
+		bodyStart[snake] = used;
+		used += world->bodyCapacity[snake];
+	}
+	fields.poolUsed = poolUsed;
+
+	size_t cellCount = (size_t) world->width * world->height;
+	StateWriter writer;
+	StartStateWriter(&writer, STATE_WORLD);
+	AddStateSection(&writer, &fields, sizeof(fields));
+
+	AddStateSection(&writer, world->headX, snakes * sizeof(int));
+	AddStateSection(&writer, world->headY, snakes * sizeof(int));
+	AddStateSection(&writer, world->direction, snakes * sizeof(SnakeDirection));
+	AddStateSection(&writer, world->pendingDirection, snakes * sizeof(SnakeDirection));
+	AddStateSection(&writer, world->speed, snakes * sizeof(int));
+	AddStateSection(&writer, world->length, snakes * sizeof(int));
+	AddStateSection(&writer, world->growth, snakes * sizeof(int));
+	AddStateSection(&writer, world->color, snakes * sizeof(SnakeColor));
+	AddStateSection(&writer, world->isAlive, snakes * sizeof(bool));
+	AddStateSection(&writer, world->events, snakes * sizeof(uint8_t));
+	AddStateSection(&writer, bodyStart, snakes * sizeof(int));
+	AddStateSection(&writer, world->bodyCapacity, snakes * sizeof(int));
+	AddStateSection(&writer, world->bodyHead, snakes * sizeof(int));
+	AddStateSection(&writer, pool, (size_t) poolUsed * sizeof(SnakeCell));
+
+	// the food, whose cells are marked again on load, and the board with its free list in order
+	AddStateSection(&writer, world->foods, (size_t) world->foodCount * sizeof(Food));
+	AddStateSection(&writer, board->counts, (cellCount + 1) * sizeof(uint16_t));
+	AddStateSection(&writer, board->freeCells, board->freeCount * sizeof(int));
+	AddStateSection(&writer, board->freeSlots, cellCount * sizeof(int));
+
+	bool isWritten = WriteStateFile(&writer, path);
+	FreeMemory(pool);
+	FreeMemory(bodyStart);
+
+	return isWritten;
+}
+
+World *LoadWorldState(const char *path)
+{
+	StateReader reader;
+	if (!OpenStateReader(&reader, path, STATE_WORLD))
+	{
+		return NULL;
+	}
+
+	const WorldStateFields *fields = GetStateSection(&reader, 0, sizeof(WorldStateFields));
+	if (!fields || fields->width < 1 || fields->height < 1 || (long long) fields->width * fields->height > INT_MAX || fields->snakeCount < 0
+		|| fields->poolUsed < 0 || fields->foodCount < 0 || fields->freeCount < 0 || fields->freeCount > fields->width * fields->height)
+	{
+		CloseStateReader(&reader);
+		return NULL;
+	}
+
+	// find every section before allocating anything. a section of the wrong size fails the load
+	size_t snakes = (size_t) fields->snakeCount;
+	size_t cellCount = (size_t) fields->width * fields->height;
+	const size_t sizes[] =
+	{
+		sizeof(int), sizeof(int), sizeof(SnakeDirection), sizeof(SnakeDirection), sizeof(int), sizeof(int), sizeof(int),
+		sizeof(SnakeColor), sizeof(bool), sizeof(uint8_t), sizeof(int), sizeof(int), sizeof(int)
+	};
+	const void *arrays[13];
+	bool isFound = true;
+	for (int i = 0; i < 13; ++i)
+	{
+		arrays[i] = GetStateSection(&reader, 1 + i, snakes * sizes[i]);
+		isFound = isFound && arrays[i];
+	}
+	const SnakeCell *pool = GetStateSection(&reader, 14, (size_t) fields->poolUsed * sizeof(SnakeCell));
+	const Food *foods = GetStateSection(&reader, 15, (size_t) fields->foodCount * sizeof(Food));
+	const uint16_t *counts = GetStateSection(&reader, 16, (cellCount + 1) * sizeof(uint16_t));
+	const int *freeCells = GetStateSection(&reader, 17, fields->freeCount * sizeof(int));
+	const int *freeSlots = GetStateSection(&reader, 18, cellCount * sizeof(int));
+	if (!(isFound && pool && foods && counts && freeCells && freeSlots))
+	{
+		CloseStateReader(&reader);
+		return NULL;
+	}
+
+	// the bodies have to lie in the pool packed one after another, as they were saved, so none runs
+	// off it or into another. a snake that is alive has a body on the board with its head first, and
+	// a dead one has none
+	const int *headX = arrays[0], *headY = arrays[1], *speed = arrays[4], *length = arrays[5], *growth = arrays[6];
+	const int *bodyStart = arrays[10], *bodyCapacity = arrays[11], *bodyHead = arrays[12];
+	const SnakeDirection *direction = arrays[2], *pendingDirection = arrays[3];
+	const uint8_t *isAlive = arrays[8];
+	long long packed = 0;
+	bool isValid = IsStateBoardValid(counts, freeCells, freeSlots, fields->freeCount, (int) cellCount);
+	for (size_t snake = 0; snake < snakes && isValid; ++snake)
+	{
+		int capacity = bodyCapacity[snake];
+		bool isPow2 = capacity == 0 || (capacity > 0 && (capacity & (capacity - 1)) == 0);
+		isValid = isPow2 && bodyStart[snake] == packed && capacity <= fields->poolUsed - packed && length[snake] >= 0 && length[snake] <= capacity
+			&& bodyHead[snake] >= 0 && (capacity == 0 || bodyHead[snake] < capacity) && growth[snake] >= 0 && isAlive[snake] <= 1;
+		packed += capacity;
+
+		if (isValid && isAlive[snake])
+		{
+			const SnakeCell *head = &pool[bodyStart[snake] + bodyHead[snake]];
+			isValid = length[snake] >= 1 && speed[snake] >= 1 && IsStateDirection(direction[snake]) && IsStateDirection(pendingDirection[snake])
+				&& head->xPos == headX[snake] && head->yPos == headY[snake];
+		}
+		else if (isValid)
+		{
+			isValid = length[snake] == 0;
+		}
+
+		for (int i = 0; i < length[snake] && isValid; ++i)
+		{
+			const SnakeCell *cell = &pool[bodyStart[snake] + ((bodyHead[snake] + i) & (capacity - 1))];
+			isValid = IsStateCellInside(cell->xPos, cell->yPos, fields->width, fields->height);
+		}
+	}
+
+	// and the whole pool is theirs. a food is on a cell of the board or out of play
+	isValid = isValid && packed == fields->poolUsed;
+	for (int food = 0; food < fields->foodCount && isValid; ++food)
+	{
+		isValid = (foods[food].xPos == -1 && foods[food].yPos == -1) || IsStateCellInside(foods[food].xPos, foods[food].yPos, fields->width, fields->height);
+	}
+
+	if (!isValid)
+	{
+		CloseStateReader(&reader);
+		return NULL;
+	}
+
+	// a world of the same size and food has every array at the right size already, apart from the
+	// snakes and the pool. a board too big to keep dense cannot have been saved
+	World *world = CreateWorld(fields->width, fields->height, fields->foodCount, 0);
+	if (!world || !world->board || !ReserveWorld(world, fields->snakeCount, fields->poolUsed))
+	{
+		if (world)
+			DestroyWorld(world);
+		CloseStateReader(&reader);
+		return NULL;
+	}
+
+	// the new world's food is taken off its cells, then every array is copied straight out of the
+	// file over the new world's, and the saved food is put on its cells
+	for (int food = 0; food < world->foodCount; ++food)
+	{
+		if (world->foods[food].xPos >= 0)
+		{
+			world->foodAt[world->foods[food].yPos * world->width + world->foods[food].xPos] = -1;
+		}
+	}
+
+	void *targets[13] =
+	{
+		world->headX, world->headY, world->direction, world->pendingDirection, world->speed, world->length, world->growth,
+		world->color, world->isAlive, world->events, world->bodyStart, world->bodyCapacity, world->bodyHead
+	};
+	for (int i = 0; i < 13; ++i)
+	{
+		memcpy(targets[i], arrays[i], snakes * sizes[i]);
+	}
+	memcpy(world->pool, pool, (size_t) fields->poolUsed * sizeof(SnakeCell));
+	memcpy(world->foods, foods, (size_t) fields->foodCount * sizeof(Food));
+	memcpy(world->board->counts, counts, (cellCount + 1) * sizeof(uint16_t));
+	memcpy(world->board->freeCells, freeCells, fields->freeCount * sizeof(int));
+	memcpy(world->board->freeSlots, freeSlots, cellCount * sizeof(int));
+
+	world->board->freeCount = fields->freeCount;
+	for (int food = 0; food < world->foodCount; ++food)
+	{
+		// two foods never share a cell
+		Food *placed = &world->foods[food];
+		int *foodAt = placed->xPos >= 0 ? &world->foodAt[placed->yPos * world->width + placed->xPos] : NULL;
+		if (foodAt && *foodAt >= 0)
+		{
+			DestroyWorld(world);
+			CloseStateReader(&reader);
+			return NULL;
+		}
+
+		if (foodAt)
+		{
+			*foodAt = food;
+		}
+	}
+	world->snakeCount = fields->snakeCount;
+	world->poolUsed = fields->poolUsed;
+	world->tick = fields->tick;
+	world->random = fields->random;
+
+	CloseStateReader(&reader);
+
+	return world;
+}
+
+static void StartStateWriter(StateWriter *writer, StateKind kind)
+{
+	memset(&writer->header, 0, sizeof(writer->header));
+	memcpy(writer->header.magic, STATE_MAGIC, sizeof(STATE_MAGIC));
+	writer->header.version = STATE_VERSION;
+	writer->header.byteOrder = STATE_BYTE_ORDER;
+	writer->header.kind = (uint32_t) kind;
+
+	// the header goes first, then each section is gathered from where it already sits in memory
+	writer->parts[0].iov_base = &writer->header;
+	writer->parts[0].iov_len = sizeof(writer->header);
+	writer->partCount = 1;
+	writer->size = sizeof(writer->header);
+}
+
+static void AddStateSection(StateWriter *writer, const void *data, size_t size)
+{
+	static uint8_t padding[STATE_ALIGN];
+
+	// pad up to the next aligned offset, where the section starts
+	size_t padSize = (STATE_ALIGN - writer->size % STATE_ALIGN) % STATE_ALIGN;
+	writer->parts[writer->partCount].iov_base = padding;
+	writer->parts[writer->partCount++].iov_len = padSize;
+	writer->size += padSize;
+
+	StateSection *section = &writer->header.sections[writer->header.sectionCount++];
+	section->offset = writer->size;
+	section->size = 0;
+	ExtendStateSection(writer, data, size);
+}
+
+static void ExtendStateSection(StateWriter *writer, const void *data, size_t size)
+{
+	// add more bytes to the end of the last section
+	writer->parts[writer->partCount].iov_base = (void *) data;
+	writer->parts[writer->partCount++].iov_len = size;
+	writer->header.sections[writer->header.sectionCount - 1].size += size;
+	writer->size += size;
+}
+
+static bool WriteStateFile(StateWriter *writer, const char *path)
+{
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	// the whole state goes out in one gathering write, which the system may cut short and has to
+	// be picked up again where it stopped
+	writer->header.fileSize = writer->size;
+	struct iovec *part = writer->parts;
+	int partsLeft = writer->partCount;
+	while (partsLeft > 0)
+	{
+		ssize_t written = writev(fd, part, partsLeft);
+		if (written < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			close(fd);
+			return false;
+		}
+
+		// skip the pieces written whole, and move into the one written in part
+		while (partsLeft > 0 && (size_t) written >= part->iov_len)
+		{
+			written -= (ssize_t) part->iov_len;
+			++part;
+			--partsLeft;
+		}
+		if (partsLeft > 0)
+		{
+			part->iov_base = (uint8_t *) part->iov_base + written;
+			part->iov_len -= (size_t) written;
+		}
+	}
+
+	return close(fd) == 0;
+}
+
+static bool OpenStateReader(StateReader *reader, const char *path, StateKind kind)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	// map the whole file. the mapping stays after the descriptor is closed
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t) sizeof(StateHeader))
+	{
+		close(fd);
+		return false;
+	}
+
+	reader->size = (size_t) info.st_size;
+	void *data = mmap(NULL, reader->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	// every section is read front to back exactly once
+	posix_madvise(data, reader->size, POSIX_MADV_SEQUENTIAL);
+	reader->data = data;
+	reader->header = data;
+
+	// a state from another version, byte order or kind, or one cut short, is not read at all
+	const StateHeader *header = reader->header;
+	if (memcmp(header->magic, STATE_MAGIC, sizeof(STATE_MAGIC)) != 0 || header->version != STATE_VERSION || header->byteOrder != STATE_BYTE_ORDER
+		|| header->kind != (uint32_t) kind || header->fileSize != reader->size || header->sectionCount < 0 || header->sectionCount > STATE_MAX_SECTIONS)
+	{
+		CloseStateReader(reader);
+		return false;
+	}
+
+	return true;
+}
+
+static const void *GetStateSection(StateReader *reader, int section, size_t size)
+{
+	// the section has to exist, hold exactly the bytes expected and lie inside the file
+	const StateHeader *header = reader->header;
+	if (section >= header->sectionCount)
+	{
+		return NULL;
+	}
+
+	const StateSection *found = &header->sections[section];
+	if (found->size != size || found->offset % STATE_ALIGN != 0 || found->offset > reader->size || found->size > reader->size - found->offset)
+	{
+		return NULL;
+	}
+
+	return reader->data + found->offset;
+}
+
+static void CloseStateReader(StateReader *reader)
+{
+	munmap((void *) reader->data, reader->size);
+}
+
+static bool IsStateCellInside(int x, int y, int width, int height)
+{
+	return x >= 0 && x < width && y >= 0 && y < height;
+}
+
+static bool IsStateDirection(SnakeDirection direction)
+{
+	return direction == SNAKE_RIGHT || direction == SNAKE_UP || direction == SNAKE_LEFT || direction == SNAKE_DOWN;
+}
+
+static bool IsStateBoardValid(const uint16_t *counts, const int *freeCells, const int *freeSlots, int freeCount, int cellCount)
+{
+	// the spare cell past the end stays 0
+	if (counts[cellCount] != 0)
+	{
+		return false;
+	}
+
+	// every listed cell is free and points back at its own slot, so no cell is listed twice
+	for (int slot = 0; slot < freeCount; ++slot)
+	{
+		int cell = freeCells[slot];
+		if (cell < 0 || cell >= cellCount || counts[cell] != 0 || freeSlots[cell] != slot)
+		{
+			return false;
+		}
+	}
+
+	// and every free cell is listed. a taken cell keeps the slot it had when it was last free,
+	// which is still a cell index, since SyncBoardCell reads freeCells with it
+	for (int cell = 0; cell < cellCount; ++cell)
+	{
+		int slot = freeSlots[cell];
+		if (slot < 0 || slot >= cellCount || (counts[cell] == 0 && (slot >= freeCount || freeCells[slot] != cell)))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,65 @@
+#ifndef STATE_H
+#define STATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "game.h"
+#include "world.h"
+
+
+// version of the save state format. the arrays are saved in this build's own layout, so a change
+// to any saved struct or array has to bump it, and old states are refused instead of misread
+#define STATE_VERSION 1
+// most arrays one state can hold
+#define STATE_MAX_SECTIONS 24
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare StateKind enum.
+ */
+
+// what a save state holds
+typedef enum
+{
+	STATE_GAME = 1,
+	STATE_WORLD = 2
+} StateKind;
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare StateSection, StateHeader structs.
+ */
+
+// where one array sits in a state file
+typedef struct StateSection
+{
+	uint64_t offset;	// from the start of the file, a multiple of 64
+	uint64_t size;	// in bytes
+} StateSection;
+
+// start of every state file. the sections follow it, each one an array exactly as it sits in
+// memory, so loading maps the file and copies each array into place without reading it item by item
+typedef struct StateHeader
+{
+	uint8_t magic[4];	// M S S T
+	uint32_t version;	// STATE_VERSION of the build that wrote it
+	uint32_t byteOrder;	// 0x01020304 as the writer stored it, so the other byte order is refused
+	uint32_t kind;	// a StateKind
+	uint64_t fileSize;
+	int sectionCount;
+	StateSection sections[STATE_MAX_SECTIONS];
+} StateHeader;
+
+// a game and the config it was created with, saved whole: the board, the player's body, direction,
+// turn, speed and move times, the food, the tick and the random generator. resuming the state and
+// stepping the same inputs plays out exactly like the game it was saved from
+bool SaveGameState(Game *game, const GameConfig *config, const char *path);
+Game *LoadGameState(const char *path, GameConfig *config);
+
+// a world with every snake, the body pool, the food, the board and the random generator. only
+// worlds with a dense board can be saved. a loaded world steps on the calling thread until
+// SetWorldThreads is called
+bool SaveWorldState(World *world, const char *path);
+World *LoadWorldState(const char *path);
+
+#endif
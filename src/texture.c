@@ -1,10 +1,13 @@
 #include "texture.h"
+#include "allocator.h"
 
 
+static bool ReserveRenderBatch(RenderBatch *batch, int quadCapacity);
+
 Texture *CreateTexture(SDL_Renderer *renderer, SDL_Rect *box, const char *imagepath)
 {
 	// Create the struct.
-	Texture *texture = malloc(sizeof(Texture));
+	Texture *texture = AllocMemory(sizeof(Texture));
 	if (!texture)
 	{
 		SDL_SetError("Failed to create texture. (Failed to create Texture struct)");
@@ -19,7 +22,7 @@ Texture *CreateTexture(SDL_Renderer *renderer, SDL_Rect *box, const char *imagep
 		if (!texture->texture)
 		{
 			SDL_SetError("Failed to create texture. (Texture failed to load from imagepath)");
-			free(texture);
+			FreeMemory(texture);
 			return NULL;
 		}
 	}
@@ -37,7 +40,7 @@ Texture *CreateTexture(SDL_Renderer *renderer, SDL_Rect *box, const char *imagep
 Textbox *CreateTextbox(SDL_Renderer *renderer, SDL_Rect *box, int borderwidth, SDL_Color *boxcolor, SDL_Color *bordercolor, TTF_Font *font, SDL_Color *fontcolor, const char *text)
 {
 	// Create the struct.
-	Textbox *textbox = malloc(sizeof(Textbox));
+	Textbox *textbox = AllocMemory(sizeof(Textbox));
 	if (!textbox)
 	{
 		SDL_SetError("Failed to create textbox. (Failed to create Textbox struct)");
@@ -50,7 +53,7 @@ Textbox *CreateTextbox(SDL_Renderer *renderer, SDL_Rect *box, int borderwidth, S
 	{
 		SDL_ClearError();
 		SDL_SetError("Failed to create textbox. (Failed to create Texture)");
-		free(textbox);
+		FreeMemory(textbox);
 		return NULL;
 	}
 
@@ -59,8 +62,8 @@ Textbox *CreateTextbox(SDL_Renderer *renderer, SDL_Rect *box, int borderwidth, S
 	if (!surface)
 	{
 		SDL_SetError("Failed to create textbox. (Failed to create text SDL_Surface)");
-		free(textbox->texture);
-		free(textbox);
+		FreeMemory(textbox->texture);
+		FreeMemory(textbox);
 		return NULL;
 	}
 
@@ -71,8 +74,8 @@ Textbox *CreateTextbox(SDL_Renderer *renderer, SDL_Rect *box, int borderwidth, S
 	if (!textbox->texture->texture)
 	{
 		SDL_SetError("Failed to create textbox. (Failed to create text SDL_Texture from SDL_Surface)");
-		free(textbox->texture);
-		free(textbox);
+		FreeMemory(textbox->texture);
+		FreeMemory(textbox);
 		return NULL;
 	}
 
@@ -163,7 +166,7 @@ bool RenderTextboxes(SDL_Renderer *renderer, Textbox **textboxes, int size)
 void DestroyTexture(Texture *texture)
 {
 	SDL_DestroyTexture(texture->texture);
-	free(texture);
+	FreeMemory(texture);
 }
 
 void DestroyTextures(Texture **textures, int size)
@@ -177,7 +180,7 @@ void DestroyTextures(Texture **textures, int size)
 void DestroyTextbox(Textbox *textbox)
 {
 	DestroyTexture(textbox->texture);
-	free(textbox);
+	FreeMemory(textbox);
 }
 
 void DestroyTextboxes(Textbox **textboxes, int size)
@@ -190,7 +193,7 @@ void DestroyTextboxes(Textbox **textboxes, int size)
 
 Textbutton *CreateTextbutton(SDL_Rect *mouseArea, Textbox *button, Textbox *buttonHighlighted, Textbox *buttonPressed)
 {
-	Textbutton *textbutton = malloc(sizeof(Textbutton));
+	Textbutton *textbutton = AllocMemory(sizeof(Textbutton));
 	if (!textbutton)
 	{
 		return NULL;
@@ -238,5 +241,272 @@ bool RenderTextbutton(SDL_Renderer *renderer, Textbutton *textbutton, Uint32 mou
 
 void DestroyTextbutton(Textbutton *textbutton)
 {
-	free(textbutton);
+	FreeMemory(textbutton);
+}
+
+RenderBatch *CreateRenderBatch(int quadCapacity)
+{
+	RenderBatch *batch = AllocMemory(sizeof(RenderBatch));
+	if (!batch)
+	{
+		SDL_SetError("Failed to create render batch. (Failed to create RenderBatch struct)");
+		return NULL;
+	}
+
+	batch->vertices = NULL;
+	batch->indices = NULL;
+	batch->quadCount = 0;
+	batch->quadCapacity = 0;
+
+	// start with room for the given number of quads
+	if (quadCapacity > 0 && !ReserveRenderBatch(batch, quadCapacity))
+	{
+		DestroyRenderBatch(batch);
+		return NULL;
+	}
+
+	return batch;
+}
+
+void ClearRenderBatch(RenderBatch *batch)
+{
+	batch->quadCount = 0;
+}
+
+bool AddQuadRenderBatch(RenderBatch *batch, const SDL_FRect *rect, SDL_Color color, const SDL_FRect *textureRect)
+{
+	// double the buffers when full
+	if (batch->quadCount == batch->quadCapacity && !ReserveRenderBatch(batch, batch->quadCapacity > 0 ? batch->quadCapacity * 2 : 64))
+	{
+		return false;
+	}
+
+	// corners go clockwise from the top left. without a texture the coordinates are unused
+	SDL_FRect uv = textureRect ? *textureRect : (SDL_FRect) {0, 0, 0, 0};
+	SDL_Vertex *vertex = &batch->vertices[batch->quadCount * 4];
+	vertex[0] = (SDL_Vertex) {{rect->x, rect->y}, color, {uv.x, uv.y}};
+	vertex[1] = (SDL_Vertex) {{rect->x + rect->w, rect->y}, color, {uv.x + uv.w, uv.y}};
+	vertex[2] = (SDL_Vertex) {{rect->x + rect->w, rect->y + rect->h}, color, {uv.x + uv.w, uv.y + uv.h}};
+	vertex[3] = (SDL_Vertex) {{rect->x, rect->y + rect->h}, color, {uv.x, uv.y + uv.h}};
+	++batch->quadCount;
+
+	return true;
+}
+
+bool DrawRenderBatch(SDL_Renderer *renderer, RenderBatch *batch, SDL_Texture *texture)
+{
+	if (batch->quadCount == 0)
+	{
+		return true;
+	}
+
+	if (SDL_RenderGeometry(renderer, texture, batch->vertices, batch->quadCount * 4, batch->indices, batch->quadCount * 6) != 0)
+	{
+		SDL_SetError("Failed to draw render batch. (Geometry failed to render)");
+		return false;
+	}
+
+	return true;
+}
+
+void DestroyRenderBatch(RenderBatch *batch)
+{
+	FreeMemory(batch->vertices);
+	FreeMemory(batch->indices);
+	FreeMemory(batch);
+}
+
+static bool ReserveRenderBatch(RenderBatch *batch, int quadCapacity)
+{
+	SDL_Vertex *vertices = ReallocMemory(batch->vertices, quadCapacity * 4 * sizeof(SDL_Vertex));
+	if (!vertices)
+	{
+		SDL_SetError("Failed to grow render batch. (Failed to grow vertex buffer)");
+		return false;
+	}
+	batch->vertices = vertices;
+
+	int *indices = ReallocMemory(batch->indices, quadCapacity * 6 * sizeof(int));
+	if (!indices)
+	{
+		SDL_SetError("Failed to grow render batch. (Failed to grow index buffer)");
+		return false;
+	}
+	batch->indices = indices;
+
+	// the index pattern is the same for every quad, so it is written once here instead of every frame
+	for (int quad = batch->quadCapacity; quad < quadCapacity; ++quad)
+	{
+		int *index = &batch->indices[quad * 6];
+		index[0] = quad * 4;
+		index[1] = quad * 4 + 1;
+		index[2] = quad * 4 + 2;
+		index[3] = quad * 4;
+		index[4] = quad * 4 + 2;
+		index[5] = quad * 4 + 3;
+	}
+
+	batch->quadCapacity = quadCapacity;
+
+	return true;
+}
+
+GlyphAtlas *CreateGlyphAtlas(SDL_Renderer *renderer, TTF_Font *font)
+{
+	// Create the struct and the batch that strings are laid out into.
+	GlyphAtlas *atlas = AllocMemory(sizeof(GlyphAtlas));
+	if (!atlas)
+	{
+		SDL_SetError("Failed to create glyph atlas. (Failed to create GlyphAtlas struct)");
+		return NULL;
+	}
+
+	// room for the HUD and the profiler overlay, so text never grows the batch mid-round
+	atlas->batch = CreateRenderBatch(512);
+	if (!atlas->batch)
+	{
+		SDL_ClearError();
+		SDL_SetError("Failed to create glyph atlas. (Failed to create RenderBatch)");
+		FreeMemory(atlas);
+		return NULL;
+	}
+
+	// Rasterize every glyph once, in white so the text color can be applied per vertex.
+	SDL_Surface *glyphs[GLYPH_ATLAS_COUNT];
+	SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+	int cellWidth = 1, cellHeight = 1;
+	for (int i = 0; i < GLYPH_ATLAS_COUNT; ++i)
+	{
+		glyphs[i] = TTF_RenderGlyph_Blended(font, (Uint16) (GLYPH_ATLAS_FIRST + i), white);
+		if (TTF_GlyphMetrics(font, (Uint16) (GLYPH_ATLAS_FIRST + i), NULL, NULL, NULL, NULL, &atlas->advances[i]) != 0)
+		{
+			atlas->advances[i] = glyphs[i] ? glyphs[i]->w : 0;
+		}
+
+		if (glyphs[i])
+		{
+			cellWidth = glyphs[i]->w > cellWidth ? glyphs[i]->w : cellWidth;
+			cellHeight = glyphs[i]->h > cellHeight ? glyphs[i]->h : cellHeight;
+		}
+	}
+	atlas->lineHeight = TTF_FontHeight(font);
+
+	// Pack the glyphs into a grid, 16 to a row, keeping their alpha as it is.
+	int columns = 16;
+	int rows = (GLYPH_ATLAS_COUNT + columns - 1) / columns;
+	SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, columns * cellWidth, rows * cellHeight, 32, SDL_PIXELFORMAT_RGBA32);
+	for (int i = 0; i < GLYPH_ATLAS_COUNT; ++i)
+	{
+		atlas->glyphs[i] = (SDL_Rect) {(i % columns) * cellWidth, (i / columns) * cellHeight, 0, 0};
+		if (glyphs[i])
+		{
+			atlas->glyphs[i].w = glyphs[i]->w;
+			atlas->glyphs[i].h = glyphs[i]->h;
+			if (surface)
+			{
+				SDL_SetSurfaceBlendMode(glyphs[i], SDL_BLENDMODE_NONE);
+				SDL_BlitSurface(glyphs[i], NULL, surface, &atlas->glyphs[i]);
+			}
+			SDL_FreeSurface(glyphs[i]);
+		}
+	}
+
+	if (!surface)
+	{
+		SDL_SetError("Failed to create glyph atlas. (Failed to create atlas SDL_Surface)");
+		DestroyRenderBatch(atlas->batch);
+		FreeMemory(atlas);
+		return NULL;
+	}
+
+	// Upload the atlas once.
+	atlas->texture = CreateTexture(renderer, & (SDL_Rect) {0, 0, surface->w, surface->h}, NULL);
+	if (!atlas->texture)
+	{
+		SDL_FreeSurface(surface);
+		DestroyRenderBatch(atlas->batch);
+		FreeMemory(atlas);
+		return NULL;
+	}
+
+	atlas->texture->texture = SDL_CreateTextureFromSurface(renderer, surface);
+	SDL_FreeSurface(surface);
+	if (!atlas->texture->texture || SDL_SetTextureBlendMode(atlas->texture->texture, SDL_BLENDMODE_BLEND) != 0)
+	{
+		SDL_SetError("Failed to create glyph atlas. (Failed to create atlas SDL_Texture from SDL_Surface)");
+		DestroyGlyphAtlas(atlas);
+		return NULL;
+	}
+
+	return atlas;
+}
+
+int MeasureGlyphAtlas(GlyphAtlas *atlas, const char *text)
+{
+	// Add up the advances. Characters outside the atlas take up no room.
+	int width = 0;
+	for (const char *c = text; *c; ++c)
+	{
+		if (*c >= GLYPH_ATLAS_FIRST && *c <= GLYPH_ATLAS_LAST)
+		{
+			width += atlas->advances[*c - GLYPH_ATLAS_FIRST];
+		}
+	}
+
+	return width;
+}
+
+bool AddTextGlyphAtlas(GlyphAtlas *atlas, const char *text, int x, int y, SDL_Color *color)
+{
+	float atlasWidth = atlas->texture->box.w;
+	float atlasHeight = atlas->texture->box.h;
+
+	// Lay out one quad per glyph, moving the pen along by each glyph's advance.
+	for (const char *c = text; *c; ++c)
+	{
+		if (*c < GLYPH_ATLAS_FIRST || *c > GLYPH_ATLAS_LAST)
+		{
+			continue;
+		}
+
+		SDL_Rect *glyph = &atlas->glyphs[*c - GLYPH_ATLAS_FIRST];
+		if (glyph->w > 0)
+		{
+			SDL_FRect rect = {x, y, glyph->w, glyph->h};
+			SDL_FRect textureRect = {glyph->x / atlasWidth, glyph->y / atlasHeight, glyph->w / atlasWidth, glyph->h / atlasHeight};
+			if (!AddQuadRenderBatch(atlas->batch, &rect, *color, &textureRect))
+			{
+				SDL_ClearError();
+				SDL_SetError("Failed to add text to glyph atlas. (Failed to add glyph quad)");
+				return false;
+			}
+		}
+
+		x += atlas->advances[*c - GLYPH_ATLAS_FIRST];
+	}
+
+	return true;
+}
+
+bool RenderGlyphAtlas(SDL_Renderer *renderer, GlyphAtlas *atlas)
+{
+	// Draw all text added since the last render in one go, then start over.
+	bool isRendered = DrawRenderBatch(renderer, atlas->batch, atlas->texture->texture);
+	ClearRenderBatch(atlas->batch);
+
+	if (!isRendered)
+	{
+		SDL_ClearError();
+		SDL_SetError("Failed to render glyph atlas. (Text failed to render)");
+		return false;
+	}
+
+	return true;
+}
+
+void DestroyGlyphAtlas(GlyphAtlas *atlas)
+{
+	DestroyTexture(atlas->texture);
+	DestroyRenderBatch(atlas->batch);
+	FreeMemory(atlas);
 }
@@ -8,7 +8,7 @@
 
 
 /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
- * Declare Text struct.
+ * Declare Texture, Textbox, Textbutton, RenderBatch, GlyphAtlas structs.
  */
 
 typedef struct Texture
@@ -37,6 +37,32 @@ typedef struct Textbutton
 	Textbox *buttonPressed;
 } Textbutton;
 
+// quads collected over a frame and drawn with a single SDL_RenderGeometry call. every quad
+// has its own color and texture coordinates, so one batch can hold differently colored
+// segments or sprites cut from one texture. the buffers are kept between frames and only grow
+typedef struct RenderBatch
+{
+	SDL_Vertex *vertices;	// four vertices per quad
+	int *indices;	// six indices per quad, filled in once when the buffers grow
+	int quadCount;	// number of quads added since the last clear
+	int quadCapacity;	// number of quads the buffers can hold
+} RenderBatch;
+
+// first and last characters kept in a GlyphAtlas, the printable ASCII range
+#define GLYPH_ATLAS_FIRST ' '
+#define GLYPH_ATLAS_LAST '~'
+#define GLYPH_ATLAS_COUNT (GLYPH_ATLAS_LAST - GLYPH_ATLAS_FIRST + 1)
+
+// every glyph of a font at one size, rasterized once into a single texture. strings are laid
+// out as quads cut from it, so text that changes every frame costs no rasterizing or uploading
+typedef struct GlyphAtlas
+{
+	Texture *texture;	// the atlas, with its box holding the size of the whole texture
+	SDL_Rect glyphs[GLYPH_ATLAS_COUNT];	// where each glyph sits in the atlas
+	int advances[GLYPH_ATLAS_COUNT];	// how far the pen moves after each glyph
+	int lineHeight;
+	RenderBatch *batch;	// quads of the text added since the last render
+} GlyphAtlas;
 
 Texture *CreateTexture(SDL_Renderer *renderer, SDL_Rect *box, const char *imagepath);
 Textbox *CreateTextbox(SDL_Renderer *renderer, SDL_Rect *box, int borderwidth, SDL_Color *boxcolor, SDL_Color *bordercolor, TTF_Font *font, SDL_Color *fontcolor, const char *text);
@@ -56,4 +82,16 @@ bool RenderTextbutton(SDL_Renderer *renderer, Textbutton *textbutton, Uint32 mou
 void DestroyTextbutton(Textbutton *textbutton);
 //void DestroyButtons(Button **buttons, int size);
 
+RenderBatch *CreateRenderBatch(int quadCapacity);
+void ClearRenderBatch(RenderBatch *batch);
+bool AddQuadRenderBatch(RenderBatch *batch, const SDL_FRect *rect, SDL_Color color, const SDL_FRect *textureRect);
+bool DrawRenderBatch(SDL_Renderer *renderer, RenderBatch *batch, SDL_Texture *texture);
+void DestroyRenderBatch(RenderBatch *batch);
+
+GlyphAtlas *CreateGlyphAtlas(SDL_Renderer *renderer, TTF_Font *font);
+int MeasureGlyphAtlas(GlyphAtlas *atlas, const char *text);
+bool AddTextGlyphAtlas(GlyphAtlas *atlas, const char *text, int x, int y, SDL_Color *color);
+bool RenderGlyphAtlas(SDL_Renderer *renderer, GlyphAtlas *atlas);
+void DestroyGlyphAtlas(GlyphAtlas *atlas);
+
 #endif
@@ -0,0 +1,150 @@
+#include "workers.h"
+#include "allocator.h"
+#include <stdlib.h>
+
+
+typedef struct WorkerStart
+{
+	WorkerPool *pool;
+	int worker;
+} WorkerStart;
+
+static void *RunWorker(void *arg);
+
+WorkerPool *CreateWorkerPool(int workerCount)
+{
+	if (workerCount < 1)
+	{
+		return NULL;
+	}
+
+	WorkerPool *pool = CallocMemory(1, sizeof(WorkerPool));
+	if (!pool)
+	{
+		return NULL;
+	}
+
+	pool->workerCount = workerCount;
+	pool->threads = AllocMemory((workerCount > 1 ? workerCount - 1 : 1) * sizeof(pthread_t));
+	if (!pool->threads)
+	{
+		FreeMemory(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->done, NULL);
+
+	// start the spawned workers, which wait for the first job
+	for (int worker = 1; worker < workerCount; ++worker)
+	{
+		WorkerStart *start = AllocMemory(sizeof(WorkerStart));
+		if (start)
+		{
+			start->pool = pool;
+			start->worker = worker;
+		}
+
+		if (!start || pthread_create(&pool->threads[worker - 1], NULL, RunWorker, start) != 0)
+		{
+			FreeMemory(start);
+			pool->workerCount = worker;
+			DestroyWorkerPool(pool);
+			return NULL;
+		}
+	}
+
+	return pool;
+}
+
+void RunWorkerPool(WorkerPool *pool, int itemCount, WorkerFunction function, void *data)
+{
+	if (pool->workerCount == 1)
+	{
+		function(data, 0, itemCount);
+		return;
+	}
+
+	// hand out the job and wake every spawned worker
+	pthread_mutex_lock(&pool->mutex);
+	pool->function = function;
+	pool->data = data;
+	pool->itemCount = itemCount;
+	pool->busyCount = pool->workerCount - 1;
+	++pool->generation;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->mutex);
+
+	// do the first share here, then wait for the rest
+	function(data, 0, (int) ((long long) itemCount / pool->workerCount));
+
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->busyCount > 0)
+	{
+		pthread_cond_wait(&pool->done, &pool->mutex);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void DestroyWorkerPool(WorkerPool *pool)
+{
+	// tell the workers to stop and wait for them
+	pthread_mutex_lock(&pool->mutex);
+	pool->isQuitting = true;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (int worker = 1; worker < pool->workerCount; ++worker)
+	{
+		pthread_join(pool->threads[worker - 1], NULL);
+	}
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->mutex);
+	FreeMemory(pool->threads);
+	FreeMemory(pool);
+}
+
+static void *RunWorker(void *arg)
+{
+	WorkerStart start = *(WorkerStart *) arg;
+	FreeMemory(arg);
+
+	WorkerPool *pool = start.pool;
+	unsigned generation = 0;
+
+	pthread_mutex_lock(&pool->mutex);
+	while (true)
+	{
+		// sleep until there is a job this worker has not done yet
+		while (!pool->isQuitting && pool->generation == generation)
+		{
+			pthread_cond_wait(&pool->wake, &pool->mutex);
+		}
+
+		if (pool->isQuitting)
+		{
+			break;
+		}
+
+		generation = pool->generation;
+		WorkerFunction function = pool->function;
+		void *data = pool->data;
+		long long itemCount = pool->itemCount;
+		pthread_mutex_unlock(&pool->mutex);
+
+		// work on this worker's share of the items
+		function(data, (int) (itemCount * start.worker / pool->workerCount), (int) (itemCount * (start.worker + 1) / pool->workerCount));
+
+		pthread_mutex_lock(&pool->mutex);
+		if (--pool->busyCount == 0)
+		{
+			pthread_cond_signal(&pool->done);
+		}
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
@@ -0,0 +1,38 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare WorkerPool struct.
+ */
+
+// work on the items from begin up to (not including) end
+typedef void (*WorkerFunction)(void *data, int begin, int end);
+
+// a fixed set of threads that split a range of items between them. the calling thread
+// takes the first share itself, so a pool of one worker spawns no threads at all
+typedef struct WorkerPool
+{
+	int workerCount;	// number of workers, counting the calling thread
+	pthread_t *threads;	// the workerCount - 1 spawned threads
+	pthread_mutex_t mutex;
+	pthread_cond_t wake;	// signalled when there is a new job
+	pthread_cond_t done;	// signalled when the last worker finishes a job
+	unsigned generation;	// incremented for every job so workers can tell a new one apart
+	int busyCount;	// number of spawned workers still working on the current job
+	bool isQuitting;
+
+	// the current job
+	WorkerFunction function;
+	void *data;
+	int itemCount;
+} WorkerPool;
+
+WorkerPool *CreateWorkerPool(int workerCount);
+void RunWorkerPool(WorkerPool *pool, int itemCount, WorkerFunction function, void *data);
+void DestroyWorkerPool(WorkerPool *pool);
+
+#endif
@@ -0,0 +1,841 @@
+#include "world.h"
+#include "allocator.h"
+#include "collide.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+// smallest body ring given to a snake, and the starting sizes of the snake arrays and body pool
+#define WORLD_MIN_BODY 16
+#define WORLD_MIN_SNAKES 16
+#define WORLD_MIN_POOL 1024
+// most cells a board is kept dense for. a bigger board is kept sparse
+#define WORLD_DENSE_CELLS (1 << 22)
+// most cells drawn when looking for one with neither a snake nor food on it
+#define WORLD_FREE_ATTEMPTS 16
+
+static bool ReserveWorldSnakes(World *world, int capacity);
+static int AllocWorldBody(World *world, int capacity);
+static bool GrowWorldBody(World *world, int snake);
+static void KillWorldSnake(World *world, int snake);
+static void PlaceWorldFood(World *world, int food);
+static int FindWorldFood(World *world, int x, int y);
+static bool SetWorldFood(World *world, int x, int y, int food);
+static void NextWorldCell(World *world, int snake, int *x, int *y);
+static void MoveWorldSnakes(void *data, int begin, int end);
+static void CheckWorldSnakes(void *data, int begin, int end);
+
+// round up to the next power of two so ring buffer indices can wrap with a mask
+static int RoundUpPow2(int n)
+{
+	int pow2 = 1;
+	while (pow2 < n)
+	{
+		pow2 <<= 1;
+	}
+
+	return pow2;
+}
+
+World *CreateWorld(int width, int height, int foodCount, uint64_t seed)
+{
+	World *world = CallocMemory(1, sizeof(World));
+	if (!world)
+	{
+		return NULL;
+	}
+
+	SeedRandom(&world->random, seed);
+
+	// create the shared board, the body pool and the food. a small board keeps every cell, a big one
+	// only the tiles something sits on, with the food found by cell through a hash
+	bool isSparse = (long long) width * height > WORLD_DENSE_CELLS;
+	world->width = width;
+	world->height = height;
+	world->foodCount = foodCount > 0 ? foodCount : 0;
+	if (isSparse)
+	{
+		world->sparse = CreateSparseBoard(width, height);
+		world->foodMap = CreateSparseMap(world->foodCount * 2);
+	}
+	else
+	{
+		world->board = CreateBoard(width, height);
+		world->foodAt = world->board ? AllocMemory((size_t) width * height * sizeof(int)) : NULL;
+	}
+	world->poolCapacity = WORLD_MIN_POOL;
+	world->pool = AllocMemory(world->poolCapacity * sizeof(SnakeCell));
+	world->foods = AllocMemory((world->foodCount > 0 ? world->foodCount : 1) * sizeof(Food));
+
+	bool hasBoard = isSparse ? world->sparse && world->foodMap : world->board && world->foodAt;
+	if (!(hasBoard && world->pool && world->foods && ReserveWorldSnakes(world, WORLD_MIN_SNAKES)))
+	{
+		DestroyWorld(world);
+		return NULL;
+	}
+
+	// no cell has food until it is placed
+	for (int cell = 0; !isSparse && cell < width * height; ++cell)
+	{
+		world->foodAt[cell] = -1;
+	}
+
+	for (int food = 0; food < world->foodCount; ++food)
+	{
+		world->foods[food].type = FOOD_APPLE;
+		world->foods[food].xPos = world->foods[food].yPos = -1;
+		PlaceWorldFood(world, food);
+	}
+
+	return world;
+}
+
+bool SetWorldThreads(World *world, int threadCount)
+{
+	// replace the old pool. one thread needs no pool at all
+	if (world->workers)
+	{
+		DestroyWorkerPool(world->workers);
+		world->workers = NULL;
+	}
+
+	if (threadCount > 1)
+	{
+		world->workers = CreateWorkerPool(threadCount);
+		return world->workers != NULL;
+	}
+
+	return true;
+}
+
+bool ReserveWorld(World *world, int snakeCapacity, int poolCapacity)
+{
+	// make room for many snakes and cells at once, e.g. before filling the arrays in from a saved world
+	if (snakeCapacity > world->snakeCapacity && !ReserveWorldSnakes(world, snakeCapacity))
+	{
+		return false;
+	}
+
+	if (poolCapacity > world->poolCapacity)
+	{
+		SnakeCell *pool = ReallocMemory(world->pool, (size_t) poolCapacity * sizeof(SnakeCell));
+		if (!pool)
+		{
+			return false;
+		}
+
+		world->pool = pool;
+		world->poolCapacity = poolCapacity;
+	}
+
+	return true;
+}
+
+int AddWorldSnake(World *world, int xPos, int yPos, int length, SnakeDirection direction, int speed, SnakeColor *color)
+{
+	// make room for one more snake in every array
+	if (world->snakeCount == world->snakeCapacity && !ReserveWorldSnakes(world, world->snakeCapacity * 2))
+	{
+		return -1;
+	}
+
+	int snake = world->snakeCount;
+	world->speed[snake] = speed > 0 ? speed : 1;
+	world->color[snake] = *color;
+	world->bodyStart[snake] = world->bodyCapacity[snake] = world->bodyHead[snake] = 0;
+	world->isAlive[snake] = false;
+	world->length[snake] = 0;
+
+	if (!SpawnWorldSnake(world, snake, xPos, yPos, length, direction))
+	{
+		return -1;
+	}
+
+	++world->snakeCount;
+
+	return snake;
+}
+
+bool SpawnWorldSnake(World *world, int snake, int xPos, int yPos, int length, SnakeDirection direction)
+{
+	// a snake spawns as just its head on a free cell without food, then grows out to its length over
+	// its first moves
+	if (length < 1 || world->isAlive[snake] || !IsFreeWorldCell(world, xPos, yPos) || FindWorldFood(world, xPos, yPos) >= 0)
+	{
+		return false;
+	}
+
+	// a sparse board may need a new tile for the head, which can fail
+	if (world->sparse && !TouchSparseBoardTile(world->sparse, xPos, yPos))
+	{
+		return false;
+	}
+
+	// give the snake a body ring big enough for its starting length, keeping its old one if it fits
+	int capacity = RoundUpPow2(length > WORLD_MIN_BODY ? length : WORLD_MIN_BODY);
+	if (world->bodyCapacity[snake] < capacity)
+	{
+		int start = AllocWorldBody(world, capacity);
+		if (start < 0)
+		{
+			return false;
+		}
+
+		world->bodyStart[snake] = start;
+		world->bodyCapacity[snake] = capacity;
+	}
+
+	world->bodyHead[snake] = 0;
+	world->pool[world->bodyStart[snake]] = (SnakeCell) {xPos, yPos};
+	if (world->board)
+	{
+		OccupyBoardCell(world->board, xPos, yPos);
+	}
+	else
+	{
+		OccupySparseBoardCell(world->sparse, xPos, yPos);
+	}
+
+	world->headX[snake] = xPos;
+	world->headY[snake] = yPos;
+	world->direction[snake] = world->pendingDirection[snake] = direction;
+	world->length[snake] = 1;
+	world->growth[snake] = length - 1;
+	world->isAlive[snake] = true;
+	world->events[snake] = GAME_EVENT_NONE;
+
+	return true;
+}
+
+bool SteerWorldSnake(World *world, int snake, SnakeDirection direction)
+{
+	// a snake cannot turn back into itself, so skip a direction opposite to the current one
+	SnakeDirection current = world->direction[snake];
+	if ((direction == SNAKE_RIGHT && current == SNAKE_LEFT) || (direction == SNAKE_LEFT && current == SNAKE_RIGHT) ||
+		(direction == SNAKE_UP && current == SNAKE_DOWN) || (direction == SNAKE_DOWN && current == SNAKE_UP))
+	{
+		return false;
+	}
+
+	world->pendingDirection[snake] = direction;
+
+	return true;
+}
+
+bool RandFreeWorldCell(World *world, int *x, int *y)
+{
+	// the food is kept off the free list, so cells are drawn until one has no food on it. if none
+	// turns up, there is no cell to give
+	for (int attempt = 0; attempt < WORLD_FREE_ATTEMPTS; ++attempt)
+	{
+		bool isFound = world->board ? RandFreeBoardCell(world->board, &world->random, x, y) : RandFreeSparseBoardCell(world->sparse, &world->random, x, y);
+		if (!isFound)
+		{
+			return false;
+		}
+
+		if (FindWorldFood(world, *x, *y) < 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int StepWorld(World *world)
+{
+	Board *board = world->board;
+	SparseBoard *sparse = world->sparse;
+	int moverCount = 0;
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Gather the snakes that move this tick. Any body that has to grow into a bigger span of the
+	 * pool does so now, since that may pack the pool and move every other body. On a sparse board,
+	 * the tile each head moves into is made now too, so moving only changes counts.
+	 */
+
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		world->events[snake] = GAME_EVENT_NONE;
+		if (world->isAlive[snake] && world->tick % world->speed[snake] == 0)
+		{
+			world->movers[moverCount++] = snake;
+		}
+	}
+
+	int keptCount = 0;
+	for (int i = 0; i < moverCount; ++i)
+	{
+		int snake = world->movers[i];
+
+		// a growing snake keeps its tail, so it needs room for one more cell. if there is none, it stops growing
+		if (world->growth[snake] > 0 && world->length[snake] == world->bodyCapacity[snake] && !GrowWorldBody(world, snake))
+		{
+			world->growth[snake] = 0;
+		}
+
+		// a snake whose next tile cannot be made sits this tick out
+		if (sparse)
+		{
+			int x, y;
+			NextWorldCell(world, snake, &x, &y);
+			if (!TouchSparseBoardTile(sparse, x, y))
+			{
+				continue;
+			}
+		}
+
+		world->movers[keptCount++] = snake;
+	}
+	moverCount = keptCount;
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Move every snake, split across the workers. Each snake only writes its own body, and the
+	 * board counts are changed atomically, so the counts come out the same in any order. The free
+	 * list is then brought up to date in snake order, so it matches for any number of workers. A
+	 * sparse board has no free list, but lets go of the tiles the tails left empty.
+	 */
+
+	if (world->workers)
+	{
+		RunWorkerPool(world->workers, moverCount, MoveWorldSnakes, world);
+	}
+	else
+	{
+		MoveWorldSnakes(world, 0, moverCount);
+	}
+
+	for (int i = 0; i < moverCount; ++i)
+	{
+		if (world->tailX[i] >= 0 && board)
+		{
+			SyncBoardCell(board, world->tailX[i], world->tailY[i]);
+		}
+		else if (world->tailX[i] >= 0)
+		{
+			TrimSparseBoardTile(sparse, world->tailX[i], world->tailY[i]);
+		}
+	}
+
+	for (int i = 0; i < moverCount && board; ++i)
+	{
+		int snake = world->movers[i];
+		SyncBoardCell(board, world->headX[snake], world->headY[snake]);
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * A head that shares its cell hit a body or another head. Every such snake is found first,
+	 * split across the workers, then removed in snake order, so when several snakes contend for
+	 * the same cell they all lose no matter which one was checked first.
+	 */
+
+	if (world->workers)
+	{
+		RunWorkerPool(world->workers, moverCount, CheckWorldSnakes, world);
+	}
+	else
+	{
+		CheckWorldSnakes(world, 0, moverCount);
+	}
+
+	int deaths = 0;
+	for (int i = 0; i < moverCount; ++i)
+	{
+		int snake = world->movers[i];
+		if (world->events[snake] & GAME_EVENT_DIED)
+		{
+			KillWorldSnake(world, snake);
+			++deaths;
+		}
+	}
+
+	/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	 * Surviving heads on food eat it, in snake order. The snake grows on its next move and the food moves.
+	 */
+
+	for (int i = 0; i < moverCount; ++i)
+	{
+		int snake = world->movers[i];
+		if (!world->isAlive[snake])
+		{
+			continue;
+		}
+
+		int food = FindWorldFood(world, world->headX[snake], world->headY[snake]);
+		if (food >= 0)
+		{
+			++world->growth[snake];
+			world->events[snake] |= GAME_EVENT_ATE;
+			PlaceWorldFood(world, food);
+		}
+	}
+
+	++world->tick;
+
+	return deaths;
+}
+
+void DestroyWorld(World *world)
+{
+	if (world->workers)
+	{
+		DestroyWorkerPool(world->workers);
+	}
+
+	if (world->board)
+	{
+		DestroyBoard(world->board);
+	}
+
+	if (world->sparse)
+	{
+		DestroySparseBoard(world->sparse);
+	}
+
+	if (world->foodMap)
+	{
+		DestroySparseMap(world->foodMap);
+	}
+
+	FreeMemory(world->headX);
+	FreeMemory(world->headY);
+	FreeMemory(world->direction);
+	FreeMemory(world->pendingDirection);
+	FreeMemory(world->speed);
+	FreeMemory(world->length);
+	FreeMemory(world->growth);
+	FreeMemory(world->color);
+	FreeMemory(world->isAlive);
+	FreeMemory(world->events);
+	FreeMemory(world->bodyStart);
+	FreeMemory(world->bodyCapacity);
+	FreeMemory(world->bodyHead);
+	FreeMemory(world->movers);
+	FreeMemory(world->tailX);
+	FreeMemory(world->tailY);
+	FreeMemory(world->moverX);
+	FreeMemory(world->moverY);
+	FreeMemory(world->hits);
+	FreeMemory(world->pool);
+	FreeMemory(world->foods);
+	FreeMemory(world->foodAt);
+	FreeMemory(world);
+}
+
+bool PlaceWorldSnake(World *world, int snake, int xPos, int yPos, SnakeDirection direction, SnakeColor *color)
+{
+	// slots up to the snake are made as dead snakes, so the snakes can be placed in any order
+	if (snake >= world->snakeCapacity)
+	{
+		int capacity = world->snakeCapacity;
+		while (capacity <= snake)
+		{
+			capacity *= 2;
+		}
+
+		if (!ReserveWorldSnakes(world, capacity))
+		{
+			return false;
+		}
+	}
+
+	for (; world->snakeCount <= snake; ++world->snakeCount)
+	{
+		int slot = world->snakeCount;
+		world->speed[slot] = 1;
+		world->bodyStart[slot] = world->bodyCapacity[slot] = world->bodyHead[slot] = 0;
+		world->isAlive[slot] = false;
+		world->length[slot] = world->growth[slot] = 0;
+		world->events[slot] = GAME_EVENT_NONE;
+	}
+
+	// a snake placed again starts over as just its head
+	RemoveWorldSnake(world, snake);
+	world->color[snake] = *color;
+
+	return SpawnWorldSnake(world, snake, xPos, yPos, 1, direction);
+}
+
+bool ExtendWorldSnake(World *world, int snake, const SnakeCell *cells, int count)
+{
+	// grow the body until the cells fit behind the tail, then put them there
+	while (world->length[snake] + count > world->bodyCapacity[snake])
+	{
+		if (!GrowWorldBody(world, snake))
+		{
+			return false;
+		}
+	}
+
+	for (int i = 0; i < count; ++i)
+	{
+		if (world->sparse && !OccupySparseBoardCell(world->sparse, cells[i].xPos, cells[i].yPos))
+		{
+			return false;
+		}
+		else if (world->board)
+		{
+			OccupyBoardCell(world->board, cells[i].xPos, cells[i].yPos);
+		}
+
+		*WorldSnakeCellAt(world, snake, world->length[snake]++) = cells[i];
+	}
+
+	return true;
+}
+
+bool PushWorldSnake(World *world, int snake, SnakeDirection direction, bool keepsTail)
+{
+	// a snake that keeps its tail needs room for one more cell
+	if (keepsTail && world->length[snake] == world->bodyCapacity[snake] && !GrowWorldBody(world, snake))
+	{
+		return false;
+	}
+
+	world->pendingDirection[snake] = direction;
+	world->growth[snake] = keepsTail;
+
+	int x, y;
+	NextWorldCell(world, snake, &x, &y);
+	if (world->sparse && !TouchSparseBoardTile(world->sparse, x, y))
+	{
+		return false;
+	}
+
+	// move it as the only mover of a step, then bring the board up to date like the step does
+	world->movers[0] = snake;
+	MoveWorldSnakes(world, 0, 1);
+
+	if (world->board && world->tailX[0] >= 0)
+	{
+		SyncBoardCell(world->board, world->tailX[0], world->tailY[0]);
+	}
+	else if (world->tailX[0] >= 0)
+	{
+		TrimSparseBoardTile(world->sparse, world->tailX[0], world->tailY[0]);
+	}
+
+	if (world->board)
+	{
+		SyncBoardCell(world->board, x, y);
+	}
+
+	return true;
+}
+
+void RemoveWorldSnake(World *world, int snake)
+{
+	if (world->isAlive[snake])
+	{
+		KillWorldSnake(world, snake);
+	}
+}
+
+bool MoveWorldFood(World *world, int food, int xPos, int yPos)
+{
+	// take the food off its cell, then put it on the new one. a food at -1 is out of play
+	Food *cur = &world->foods[food];
+	if (cur->xPos >= 0 && FindWorldFood(world, cur->xPos, cur->yPos) == food)
+	{
+		SetWorldFood(world, cur->xPos, cur->yPos, -1);
+	}
+
+	cur->xPos = cur->yPos = -1;
+	if (xPos < 0 || !SetWorldFood(world, xPos, yPos, food))
+	{
+		return xPos < 0;
+	}
+
+	cur->xPos = xPos;
+	cur->yPos = yPos;
+
+	return true;
+}
+
+static bool ReserveArray(void **array, size_t elementSize, int capacity)
+{
+	void *grown = ReallocMemory(*array, elementSize * capacity);
+	if (!grown)
+	{
+		return false;
+	}
+
+	*array = grown;
+
+	return true;
+}
+
+static bool ReserveWorldSnakes(World *world, int capacity)
+{
+	// grow every per-snake array to the same capacity
+	bool isReserved = ReserveArray((void **) &world->headX, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->headY, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->direction, sizeof(SnakeDirection), capacity) &&
+		ReserveArray((void **) &world->pendingDirection, sizeof(SnakeDirection), capacity) &&
+		ReserveArray((void **) &world->speed, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->length, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->growth, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->color, sizeof(SnakeColor), capacity) &&
+		ReserveArray((void **) &world->isAlive, sizeof(bool), capacity) &&
+		ReserveArray((void **) &world->events, sizeof(uint8_t), capacity) &&
+		ReserveArray((void **) &world->bodyStart, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->bodyCapacity, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->bodyHead, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->movers, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->tailX, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->tailY, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->moverX, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->moverY, sizeof(int), capacity) &&
+		ReserveArray((void **) &world->hits, sizeof(uint8_t), capacity);
+
+	if (isReserved)
+	{
+		world->snakeCapacity = capacity;
+	}
+
+	return isReserved;
+}
+
+static int AllocWorldBody(World *world, int capacity)
+{
+	// take the next span off the top of the pool if it fits
+	if (world->poolUsed + capacity <= world->poolCapacity)
+	{
+		int start = world->poolUsed;
+		world->poolUsed += capacity;
+		return start;
+	}
+
+	// otherwise pack the living snakes' bodies into a bigger pool, leaving out dead and outgrown spans
+	int live = 0;
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		live += world->isAlive[snake] ? world->bodyCapacity[snake] : 0;
+	}
+
+	int poolCapacity = world->poolCapacity;
+	while (poolCapacity < (live + capacity) * 2)
+	{
+		poolCapacity *= 2;
+	}
+
+	SnakeCell *pool = AllocMemory((size_t) poolCapacity * sizeof(SnakeCell));
+	if (!pool)
+	{
+		return -1;
+	}
+
+	int used = 0;
+	for (int snake = 0; snake < world->snakeCount; ++snake)
+	{
+		if (!world->isAlive[snake])
+		{
+			world->bodyCapacity[snake] = 0;
+			continue;
+		}
+
+		memcpy(pool + used, world->pool + world->bodyStart[snake], world->bodyCapacity[snake] * sizeof(SnakeCell));
+		world->bodyStart[snake] = used;
+		used += world->bodyCapacity[snake];
+	}
+
+	FreeMemory(world->pool);
+	world->pool = pool;
+	world->poolCapacity = poolCapacity;
+	world->poolUsed = used + capacity;
+
+	return used;
+}
+
+static bool GrowWorldBody(World *world, int snake)
+{
+	// move the body into a span twice as big, unrolled so the head is at offset 0
+	int capacity = world->bodyCapacity[snake];
+	int start = AllocWorldBody(world, capacity * 2);
+	if (start < 0)
+	{
+		return false;
+	}
+
+	// the old span may have moved while the pool was packed, so read it after allocating
+	SnakeCell *old = world->pool + world->bodyStart[snake];
+	int headSpan = capacity - world->bodyHead[snake];
+	memcpy(world->pool + start, old + world->bodyHead[snake], headSpan * sizeof(SnakeCell));
+	memcpy(world->pool + start + headSpan, old, world->bodyHead[snake] * sizeof(SnakeCell));
+
+	world->bodyStart[snake] = start;
+	world->bodyCapacity[snake] = capacity * 2;
+	world->bodyHead[snake] = 0;
+
+	return true;
+}
+
+static void KillWorldSnake(World *world, int snake)
+{
+	// take the whole body off the board and give its span back to the pool
+	for (int i = 0; i < world->length[snake]; ++i)
+	{
+		SnakeCell *cell = WorldSnakeCellAt(world, snake, i);
+		if (world->board)
+		{
+			VacateBoardCell(world->board, cell->xPos, cell->yPos);
+		}
+		else
+		{
+			VacateSparseBoardCell(world->sparse, cell->xPos, cell->yPos);
+		}
+	}
+
+	world->isAlive[snake] = false;
+	world->length[snake] = 0;
+	world->growth[snake] = 0;
+	world->bodyCapacity[snake] = 0;
+}
+
+static void PlaceWorldFood(World *world, int food)
+{
+	Food *cur = &world->foods[food];
+
+	// take the food off its old cell
+	if (cur->xPos >= 0 && FindWorldFood(world, cur->xPos, cur->yPos) == food)
+	{
+		SetWorldFood(world, cur->xPos, cur->yPos, -1);
+	}
+
+	// look for a free cell without other food on it. if none turns up, the food is left out of play
+	cur->xPos = cur->yPos = -1;
+	int x, y;
+	if (RandFreeWorldCell(world, &x, &y) && SetWorldFood(world, x, y, food))
+	{
+		cur->xPos = x;
+		cur->yPos = y;
+	}
+}
+
+static int FindWorldFood(World *world, int x, int y)
+{
+	// food on the cell at x, y, or -1
+	return world->foodAt ? world->foodAt[y * world->width + x] : FindSparseMap(world->foodMap, (int64_t) y * world->width + x);
+}
+
+static bool SetWorldFood(World *world, int x, int y, int food)
+{
+	// put food on the cell at x, y, or take it off with -1
+	if (world->foodAt)
+	{
+		world->foodAt[y * world->width + x] = food;
+		return true;
+	}
+
+	if (food < 0)
+	{
+		RemoveSparseMap(world->foodMap, (int64_t) y * world->width + x);
+		return true;
+	}
+
+	return PutSparseMap(world->foodMap, (int64_t) y * world->width + x, food);
+}
+
+static void NextWorldCell(World *world, int snake, int *x, int *y)
+{
+	// the cell the head moves into next, looping around the edges of the board
+	*x = world->headX[snake];
+	*y = world->headY[snake];
+
+	switch (world->pendingDirection[snake])
+	{
+		case SNAKE_RIGHT:
+			*x = *x + 1 < world->width ? *x + 1 : 0;
+			break;
+		case SNAKE_UP:
+			*y = *y > 0 ? *y - 1 : world->height - 1;
+			break;
+		case SNAKE_LEFT:
+			*x = *x > 0 ? *x - 1 : world->width - 1;
+			break;
+		case SNAKE_DOWN:
+			*y = *y + 1 < world->height ? *y + 1 : 0;
+			break;
+	}
+}
+
+static void MoveWorldSnakes(void *data, int begin, int end)
+{
+	World *world = data;
+
+	for (int i = begin; i < end; ++i)
+	{
+		int snake = world->movers[i];
+
+		// a growing snake keeps its tail, the others let go of it
+		if (world->growth[snake] > 0)
+		{
+			--world->growth[snake];
+			++world->length[snake];
+			world->tailX[i] = world->tailY[i] = -1;
+		}
+		else
+		{
+			SnakeCell *tail = WorldSnakeCellAt(world, snake, world->length[snake] - 1);
+			world->tailX[i] = tail->xPos;
+			world->tailY[i] = tail->yPos;
+			if (world->board)
+			{
+				AddBoardCellCount(world->board, tail->xPos, tail->yPos, -1);
+			}
+			else
+			{
+				AddSparseBoardCellCount(world->sparse, tail->xPos, tail->yPos, -1);
+			}
+		}
+
+		// push the head into its next cell
+		int x, y;
+		NextWorldCell(world, snake, &x, &y);
+		world->direction[snake] = world->pendingDirection[snake];
+
+		if (world->board)
+		{
+			AddBoardCellCount(world->board, x, y, 1);
+		}
+		else
+		{
+			AddSparseBoardCellCount(world->sparse, x, y, 1);
+		}
+		world->bodyHead[snake] = (world->bodyHead[snake] - 1) & (world->bodyCapacity[snake] - 1);
+		world->pool[world->bodyStart[snake] + world->bodyHead[snake]] = (SnakeCell) {x, y};
+		world->headX[snake] = x;
+		world->headY[snake] = y;
+		world->moverX[i] = x;
+		world->moverY[i] = y;
+		world->events[snake] = GAME_EVENT_MOVED;
+	}
+}
+
+static void CheckWorldSnakes(void *data, int begin, int end)
+{
+	World *world = data;
+
+	// check the whole range of heads in one pass of the collision kernel, then mark the ones that hit.
+	// a sparse board has no dense counts for the kernel, so its heads are looked up one by one
+	if (world->sparse)
+	{
+		for (int i = begin; i < end; ++i)
+		{
+			world->hits[i] = CountSparseBoardCell(world->sparse, world->moverX[i], world->moverY[i]) > 1;
+		}
+	}
+	else if (CollideBoardHeads(world->board, world->moverX + begin, world->moverY + begin, end - begin, world->hits + begin) == 0)
+	{
+		return;
+	}
+
+	for (int i = begin; i < end; ++i)
+	{
+		if (world->hits[i])
+		{
+			world->events[world->movers[i]] |= GAME_EVENT_DIED;
+		}
+	}
+}
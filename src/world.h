@@ -0,0 +1,99 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "game.h"
+#include "snake.h"
+#include "sparse.h"
+#include "workers.h"
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Declare World struct.
+ */
+
+// many snakes sharing one board. every per-snake property lives in its own array indexed
+// by snake, so a batched step walks each property linearly. the bodies are ring buffers
+// carved out of one shared pool of cells instead of one allocation per snake.
+// a step can be split across a worker pool and gives the same result for any number of workers.
+// a board too big to keep every cell of is kept sparse, with memory only where snakes and food are
+typedef struct World
+{
+	WorkerPool *workers;	// threads that share the step, NULL to step on the calling thread only
+	int width, height;	// size of the board in cells
+	Board *board;	// occupancy of every snake on the shared board, NULL if the board is sparse
+	SparseBoard *sparse;	// occupancy of a sparse board, NULL if the board is dense
+	uint64_t tick;	// number of ticks stepped so far
+	Random random;	// places the food
+
+	int snakeCount;	// number of snake slots in use, dead snakes keep their slot
+	int snakeCapacity;	// number of snake slots allocated in the arrays below
+
+	// per-snake properties
+	int *headX, *headY;	// cell of each head
+	SnakeDirection *direction;	// current direction of each snake
+	SnakeDirection *pendingDirection;	// direction for the next move of each snake
+	int *speed;	// ticks per move
+	int *length;	// number of cells in each body
+	int *growth;	// cells each snake still grows by, one per move
+	SnakeColor *color;
+	bool *isAlive;
+	uint8_t *events;	// GameEvent flags of each snake from the last tick
+
+	// bodies in the shared pool. snake i owns pool[bodyStart[i]] up to pool[bodyStart[i] + bodyCapacity[i]]
+	// and its head sits at offset bodyHead[i] in that span, with the rest of the body following like Snake
+	int *bodyStart, *bodyCapacity, *bodyHead;
+	SnakeCell *pool;
+	int poolUsed, poolCapacity;
+
+	// food, and which food (if any) sits on each board cell
+	Food *foods;
+	int foodCount;
+	int *foodAt;	// index into foods for each cell, or -1. NULL if the board is sparse
+	SparseMap *foodMap;	// index into foods for each cell with food, by y * width + x. NULL if the board is dense
+
+	// scratch space for the batched step
+	int *movers;	// snakes that move this tick
+	int *tailX, *tailY;	// cell the tail of each mover left this tick, or -1 if it grew instead
+	int *moverX, *moverY;	// cell the head of each mover went into this tick, packed for the collision kernel
+	uint8_t *hits;	// whether each mover's head collided this tick
+} World;
+
+World *CreateWorld(int width, int height, int foodCount, uint64_t seed);
+bool SetWorldThreads(World *world, int threadCount);
+bool ReserveWorld(World *world, int snakeCapacity, int poolCapacity);
+int AddWorldSnake(World *world, int xPos, int yPos, int length, SnakeDirection direction, int speed, SnakeColor *color);
+bool SpawnWorldSnake(World *world, int snake, int xPos, int yPos, int length, SnakeDirection direction);
+bool SteerWorldSnake(World *world, int snake, SnakeDirection direction);
+// a random cell with neither a snake nor food on it, e.g. to spawn a snake on
+bool RandFreeWorldCell(World *world, int *x, int *y);
+int StepWorld(World *world);
+void DestroyWorld(World *world);
+
+// change a world one snake at a time from outside the step, e.g. to mirror a world stepped elsewhere
+bool PlaceWorldSnake(World *world, int snake, int xPos, int yPos, SnakeDirection direction, SnakeColor *color);
+bool ExtendWorldSnake(World *world, int snake, const SnakeCell *cells, int count);
+bool PushWorldSnake(World *world, int snake, SnakeDirection direction, bool keepsTail);
+void RemoveWorldSnake(World *world, int snake);
+bool MoveWorldFood(World *world, int food, int xPos, int yPos);
+
+// get the i-th cell of a snake's body counting from the head
+static inline SnakeCell *WorldSnakeCellAt(World *world, int snake, int i)
+{
+	return &world->pool[world->bodyStart[snake] + ((world->bodyHead[snake] + i) & (world->bodyCapacity[snake] - 1))];
+}
+
+// number of snake cells that sit on the cell at x, y
+static inline int CountWorldCell(const World *world, int x, int y)
+{
+	return world->board ? CountBoardCell(world->board, x, y) : CountSparseBoardCell(world->sparse, x, y);
+}
+
+static inline bool IsFreeWorldCell(const World *world, int x, int y)
+{
+	return CountWorldCell(world, x, y) == 0;
+}
+
+#endif